@@ -3,6 +3,96 @@
 //////////////////////////////////////////////////////////////////////////
 #include "app.h"
 #include "USART3.h"
+#include "fixmath.h"
+
+// BAUD = 65536 * (1 - 16 * baud / F_CPU). 16 * 65536 / F_CPU reduces to
+// 2^14 / (F_CPU / 64), so baud * 2^14 stays in 32 bits up to 250000 baud
+// and the division is by a constant, done as a multiply.
+#define UART3_BAUD_DIVISOR      (F_CPU / 64u)
+#define UART3_BAUD_DIVISOR_LOG2 (20u)
+
+static const fixmath_recip_t uart3_baud_recip = FIXMATH_RECIP(UART3_BAUD_DIVISOR, UART3_BAUD_DIVISOR_LOG2);
+
+// Transmit queues, powers of two. SERCOM3_Handler empties the priority
+// queue first, so a priority message waits for at most the character being
+// shifted out and the one in DATA, whatever is queued.
+//
+// The main queue holds the longest burst of one second without waiting:
+// the report line (up to ~200 characters), a desaturation line (~60) and
+// the minute report (~460), about 720 in all. At 9600 baud 960 characters
+// go out each second, so the queue is empty again before the next line.
+#define UART3_TX_QUEUE_SIZE     (1024u)
+#define UART3_TX_PRIORITY_SIZE  (64u)
+
+static char uart3_tx_queue[UART3_TX_QUEUE_SIZE];
+static volatile uint16_t uart3_tx_head;
+static volatile uint16_t uart3_tx_tail;
+
+static char uart3_tx_priority[UART3_TX_PRIORITY_SIZE];
+static volatile uint16_t uart3_priority_head;
+static volatile uint16_t uart3_priority_tail;
+
+
+/*******************************************************************************
+ * Function:        static bool uart3_tx_next(void)
+ *
+ * PreCondition:    DATA is empty (DRE set)
+ *
+ * Input:           None
+ *
+ * Output:          false if both queues are empty
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Writes the next character to DATA, from the priority
+ *                  queue if it holds any.
+ *
+ * Note:            Called from SERCOM3_Handler, or with interrupts masked
+ *
+ ******************************************************************************/
+static bool uart3_tx_next(void)
+{
+	if (uart3_priority_tail != uart3_priority_head)
+	{
+		SERCOM3->USART.DATA.reg = uart3_tx_priority[uart3_priority_tail];
+		uart3_priority_tail = (uart3_priority_tail + 1u) & (UART3_TX_PRIORITY_SIZE - 1u);
+		return true;
+	}
+	if (uart3_tx_tail != uart3_tx_head)
+	{
+		SERCOM3->USART.DATA.reg = uart3_tx_queue[uart3_tx_tail];
+		uart3_tx_tail = (uart3_tx_tail + 1u) & (UART3_TX_QUEUE_SIZE - 1u);
+		return true;
+	}
+	return false;
+} // uart3_tx_next()
+
+
+/*******************************************************************************
+ * Function:        static void uart3_tx_wait(void)
+ *
+ * PreCondition:    The UART must be initialized
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Called while a queue is full. The interrupt drains it,
+ *                  unless interrupts are masked (eg. in bench_run()), in
+ *                  which case the queue is drained here by polling DRE.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void uart3_tx_wait(void)
+{
+	if ((__get_PRIMASK() != 0u) && (SERCOM3->USART.INTFLAG.reg & SERCOM_USART_INTFLAG_DRE))
+	{
+		uart3_tx_next();
+	}
+} // uart3_tx_wait()
 
 
 /*******************************************************************************
@@ -83,8 +173,9 @@ void UART3_Init(uint32_t baud)
 	/* -----------------------------------------------------
 	* 6) Set USART Baud Rate
 	*/
-	// Baud rate is (65536) * (CPU_CLock - 16 * wanted baud) / CPU_Clock
-	uint64_t baudRate = (uint64_t)65536 * (F_CPU - 16 * baud) / F_CPU;
+	// Baud rate is (65536) * (CPU_CLock - 16 * wanted baud) / CPU_Clock,
+	// rounded down like the 64-bit division it replaces
+	uint32_t baudRate = 65536u - fixmath_div((baud << 14) + (UART3_BAUD_DIVISOR - 1u), &uart3_baud_recip);
 	
 	// Set Baud Rate
 	SERCOM3->USART.BAUD.reg = (uint32_t)baudRate;
@@ -95,6 +186,15 @@ void UART3_Init(uint32_t baud)
 	*/
 	// SERCOM3 peripheral enabled
 	SERCOM3->USART.CTRLA.reg |= SERCOM_USART_CTRLA_ENABLE;
+
+	/* ------------------------------------------------------
+	* 8) Empty transmit queues, DRE interrupt enabled when data is queued
+	*/
+	uart3_tx_head = 0;
+	uart3_tx_tail = 0;
+	uart3_priority_head = 0;
+	uart3_priority_tail = 0;
+	NVIC_EnableIRQ(SERCOM3_IRQn);
 }  // UART3_Init()
 
 
@@ -109,21 +209,25 @@ void UART3_Init(uint32_t baud)
  *
  * Side Effects:    None
  *
- * Overview:        This function writes a character to the UART module
+ * Overview:        This function queues a character for the UART module
  *                  
  *
- * Note:            
+ * Note:            Waits only when the queue is full
  *
  ******************************************************************************/
 void UART3_Write(char data)
 {
-	// Wait on interrupt flag and Write some data
-	while(!(REG_SERCOM3_USART_INTFLAG) & 1)
+	uint16_t next = (uart3_tx_head + 1u) & (UART3_TX_QUEUE_SIZE - 1u);
+
+	// Wait for room in the queue
+	while (next == uart3_tx_tail)
 	{
-		
+		uart3_tx_wait();
 	}
 	
-	REG_SERCOM3_USART_DATA = data;
+	uart3_tx_queue[uart3_tx_head] = data;
+	uart3_tx_head = next;
+	SERCOM3->USART.INTENSET.reg = SERCOM_USART_INTENSET_DRE;
 } //UART3_Write()
 
 
@@ -155,6 +259,43 @@ void UART3_Write_Text(char *text)
 } // UART3_Write_Text()
 
 
+/*******************************************************************************
+ * Function:        void UART3_Write_Priority_Text(char *text)
+ *
+ * PreCondition:    The UART must be initialized
+ *
+ * Input:           This text we want to send
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function queues a string ahead of everything
+ *                  written with UART3_Write(). It can land in the middle of
+ *                  a queued line, so it should start with a line break.
+ *
+ * Note:            Messages up to UART3_TX_PRIORITY_SIZE - 1 characters
+ *                  never wait
+ *
+ ******************************************************************************/
+void UART3_Write_Priority_Text(char *text)
+{
+	for (int i = 0; text[i] != '\0'; i++)
+	{
+		uint16_t next = (uart3_priority_head + 1u) & (UART3_TX_PRIORITY_SIZE - 1u);
+
+		while (next == uart3_priority_tail)
+		{
+			uart3_tx_wait();
+		}
+
+		uart3_tx_priority[uart3_priority_head] = text[i];
+		uart3_priority_head = next;
+		SERCOM3->USART.INTENSET.reg = SERCOM_USART_INTENSET_DRE;
+	}
+} // UART3_Write_Priority_Text()
+
+
 /*******************************************************************************
  * Function:        void UART3_Write_Text(char *text)
  *
@@ -207,4 +348,33 @@ char UART3_Read()
 {
 	// return data in the USART data register
 	return SERCOM3->USART.DATA.reg;
-}  // UART3_Read()
\ No newline at end of file
+}  // UART3_Read()
+
+
+/*******************************************************************************
+ * Function:        void SERCOM3_Handler(void)
+ *
+ * PreCondition:    The UART must be initialized
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        DATA is empty: sends the next queued character, or stops
+ *                  the interrupt when both queues are empty.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void SERCOM3_Handler(void)
+{
+	if (SERCOM3->USART.INTFLAG.reg & SERCOM_USART_INTFLAG_DRE)
+	{
+		if (!uart3_tx_next())
+		{
+			SERCOM3->USART.INTENCLR.reg = SERCOM_USART_INTENCLR_DRE;
+		}
+	}
+} // SERCOM3_Handler()
\ No newline at end of file
@@ -33,6 +33,13 @@ void UART3_Write(char data);
  */
 void UART3_Write_Text(char *text);
 
+/*
+ * \def UART3_Write_Priority_Text
+ * \brief Writes a string to UART3 ahead of any queued text
+ * \param data (text to send)
+ */
+void UART3_Write_Priority_Text(char *text);
+
 
 /*
  * \def UART3_Has_Data
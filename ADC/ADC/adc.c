@@ -3,6 +3,65 @@
 //////////////////////////////////////////////////////////////////////////
 #include "adc.h"
 #include "USART3.h"
+#include <stddef.h>
+
+// Register settings that make up one acquisition profile
+typedef struct
+{
+	uint8_t prescaler;    // CTRLB.PRESCALER
+	uint8_t samplen;      // SAMPCTRL.SAMPLEN, sampling time is (samplen + 1) / 2 ADC clocks
+	uint8_t ressel;       // CTRLB.RESSEL
+	uint8_t samplenum;    // AVGCTRL.SAMPLENUM
+	uint8_t adjres;       // AVGCTRL.ADJRES
+	uint32_t max_rate;    // results per second
+} adc_profile_config_t;
+
+// Indexed by adc_profile_t, kept in flash
+static const adc_profile_config_t adc_profiles[ADC_PROFILE_COUNT] =
+{
+	// 7 clocks propagation + 0.5 sampling at 1.5 MHz
+	[ADC_PROFILE_FAST_12BIT] =
+	{
+		ADC_CTRLB_PRESCALER_DIV32_Val, 0, ADC_CTRLB_RESSEL_12BIT_Val,
+		ADC_AVGCTRL_SAMPLENUM_1_Val, 0, 200000
+	},
+
+	// 256 x (7 + 1) clocks at 1.5 MHz, the 20-bit sum is shifted right by 4 in hardware
+	[ADC_PROFILE_OVERSAMPLED_16BIT] =
+	{
+		ADC_CTRLB_PRESCALER_DIV32_Val, 1, ADC_CTRLB_RESSEL_16BIT_Val,
+		ADC_AVGCTRL_SAMPLENUM_256_Val, 0, 730
+	},
+
+	// 5 clocks propagation + 0.5 sampling at 94 kHz
+	[ADC_PROFILE_FINGER_DETECT_8BIT] =
+	{
+		ADC_CTRLB_PRESCALER_DIV512_Val, 0, ADC_CTRLB_RESSEL_8BIT_Val,
+		ADC_AVGCTRL_SAMPLENUM_1_Val, 0, 17000
+	},
+
+	// 16 x (7 + 1) clocks at 1.5 MHz, the 16-bit sum is kept as is
+	[ADC_PROFILE_AVERAGED_16BIT] =
+	{
+		ADC_CTRLB_PRESCALER_DIV32_Val, 1, ADC_CTRLB_RESSEL_16BIT_Val,
+		ADC_AVGCTRL_SAMPLENUM_16_Val, 0, 11000
+	},
+};
+
+// A conversion queued with adc_read_async()
+typedef struct
+{
+	uint8_t channel;
+	adc_callback_t callback;
+} adc_request_t;
+
+// Request at adc_queue_head is the one being converted
+static adc_request_t adc_queue[ADC_ASYNC_QUEUE_SIZE];
+static volatile uint8_t adc_queue_head = 0;
+static volatile uint8_t adc_queue_count = 0;
+
+// Called when the window monitor condition is met
+static adc_window_callback_t adc_window_callback = NULL;
 
 
 
@@ -52,6 +111,9 @@ void adc_init(void)
 	// Enable ADC
 	ADC->CTRLA.reg = ADC_CTRLA_ENABLE;
 	while (ADC->STATUS.bit.SYNCBUSY); // Wait for synchronization to complete
+
+	// Interrupt sources are enabled by the modes that use them
+	NVIC_EnableIRQ(ADC_IRQn);
 }
 
 
@@ -89,4 +151,410 @@ int32_t adc_readchannel(uint8_t channel)
 
 	// return the result of the ADC
 	return ADC->RESULT.reg;
-}
\ No newline at end of file
+}
+
+
+/*******************************************************************************
+ * Function:        void adc_start_event(uint8_t evsys_channel, uint8_t generator)
+ *
+ * PreCondition:    adc_init() has been called
+ *
+ * Input:           EVSYS channel and event generator
+ *
+ * Output:          None
+ *
+ * Side Effects:    The ADC only converts on START events from now on
+ *
+ * Overview:        This function connects a peripheral event to the ADC START
+ *                  input over an asynchronous EVSYS channel, so conversions
+ *                  are started by hardware with no CPU involvement.
+ *
+ * Note:            The ADC START user can only listen to one channel, the
+ *                  last source routed here wins. The asynchronous path needs
+ *                  no EVSYS channel clock.
+ *
+ ******************************************************************************/
+void adc_start_event(uint8_t evsys_channel, uint8_t generator)
+{
+	// Enable APBC clock for EVSYS
+	REG_PM_APBCMASK |= PM_APBCMASK_EVSYS;
+
+	// Generator -> EVSYS channel -> ADC START
+	EVSYS->USER.reg = EVSYS_USER_USER(EVSYS_ID_USER_ADC_START) |
+		EVSYS_USER_CHANNEL(evsys_channel + 1);
+	EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(evsys_channel) |
+		EVSYS_CHANNEL_EVGEN(generator) |
+		EVSYS_CHANNEL_PATH_ASYNCHRONOUS |
+		EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT;
+
+	// Start a single conversion on each event
+	ADC->CTRLB.bit.FREERUN = 0;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->EVCTRL.reg |= ADC_EVCTRL_STARTEI;
+} // adc_start_event()
+
+
+/*******************************************************************************
+ * Function:        bool adc_scan_init(uint8_t first, uint8_t count)
+ *
+ * PreCondition:    adc_init() has been called
+ *
+ * Input:           First channel of the sweep and number of channels
+ *
+ * Output:          false if the sweep does not fit the MUXPOS range
+ *
+ * Side Effects:    The temperature sensor and bandgap outputs are enabled
+ *                  when the sweep covers them
+ *
+ * Overview:        This function programs INPUTSCAN so that every START (from
+ *                  software, free-running or an event) converts the next
+ *                  input, from first to first + count - 1, and then wraps
+ *                  back to first. Results come out as interleaved frames of
+ *                  count samples, all taken back-to-back.
+ *
+ * Note:            The hardware only scans consecutive MUXPOS values. The
+ *                  internal inputs TEMP, BANDGAP, SCALEDCOREVCC and
+ *                  SCALEDIOVCC are consecutive, so they can be swept together.
+ *                  A count of 1 is a plain single channel setup.
+ *
+ ******************************************************************************/
+bool adc_scan_init(uint8_t first, uint8_t count)
+{
+	uint8_t last = first + count - 1;
+
+	if ((count == 0) || (count > ADC_SCAN_MAX_CHANNELS) || (last > ADC_CHANNEL_SCALEDIOVCC))
+	{
+		return false;
+	}
+
+	// Internal inputs that need their source switched on
+	if ((first <= ADC_CHANNEL_TEMP) && (last >= ADC_CHANNEL_TEMP))
+	{
+		SYSCTRL->VREF.bit.TSEN = 1;
+	}
+	if ((first <= ADC_CHANNEL_BANDGAP) && (last >= ADC_CHANNEL_BANDGAP))
+	{
+		SYSCTRL->VREF.bit.BGOUTEN = 1;
+	}
+
+	// Start the sweep at first, INPUTOFFSET counts through the rest
+	ADC->INPUTCTRL.bit.MUXPOS = first;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->INPUTCTRL.bit.INPUTSCAN = count - 1;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->INPUTCTRL.bit.INPUTOFFSET = 0;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	return true;
+} // adc_scan_init()
+
+
+/*******************************************************************************
+ * Function:        uint8_t adc_scan_count(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          Number of channels converted per sweep
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function returns the frame size of the current scan.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint8_t adc_scan_count(void)
+{
+	return ADC->INPUTCTRL.bit.INPUTSCAN + 1;
+} // adc_scan_count()
+
+
+/*******************************************************************************
+ * Function:        void adc_set_profile(adc_profile_t profile)
+ *
+ * PreCondition:    adc_init() has been called
+ *
+ * Input:           Acquisition profile
+ *
+ * Output:          None
+ *
+ * Side Effects:    The ADC is disabled while it is reconfigured
+ *
+ * Overview:        This function programs CTRLB.PRESCALER, CTRLB.RESSEL,
+ *                  SAMPCTRL and AVGCTRL from one table entry, so the settings
+ *                  that depend on each other always change together.
+ *
+ * Note:            With averaging enabled a single START runs all SAMPLENUM
+ *                  conversions, so the trigger rate stays one result per
+ *                  event.
+ *
+ ******************************************************************************/
+void adc_set_profile(adc_profile_t profile)
+{
+	const adc_profile_config_t *config = &adc_profiles[profile];
+
+	// Disable ADC
+	ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	ADC->SAMPCTRL.reg = ADC_SAMPCTRL_SAMPLEN(config->samplen);
+	ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM(config->samplenum) |
+		ADC_AVGCTRL_ADJRES(config->adjres);
+
+	ADC->CTRLB.bit.PRESCALER = config->prescaler;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->CTRLB.bit.RESSEL = config->ressel;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	// Enable ADC
+	ADC->CTRLA.reg |= ADC_CTRLA_ENABLE;
+	while (ADC->STATUS.bit.SYNCBUSY);
+} // adc_set_profile()
+
+
+/*******************************************************************************
+ * Function:        uint32_t adc_profile_max_rate(adc_profile_t profile)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Acquisition profile
+ *
+ * Output:          Results per second
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function returns the throughput of a profile, used to
+ *                  check that a trigger rate can be honoured.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint32_t adc_profile_max_rate(adc_profile_t profile)
+{
+	return adc_profiles[profile].max_rate;
+} // adc_profile_max_rate()
+
+
+/*******************************************************************************
+ * Function:        static void adc_async_start(uint8_t channel)
+ *
+ * PreCondition:    None
+ *
+ * Input:           ADC channel number
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Selects the channel and starts one conversion.
+ *
+ * Note:            Called with interrupts disabled or from ADC_Handler
+ *
+ ******************************************************************************/
+static void adc_async_start(uint8_t channel)
+{
+	ADC->INPUTCTRL.bit.MUXPOS = channel;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	ADC->SWTRIG.reg = ADC_SWTRIG_START;
+} // adc_async_start()
+
+
+/*******************************************************************************
+ * Function:        bool adc_read_async(uint8_t channel, adc_callback_t callback)
+ *
+ * PreCondition:    adc_init() has been called, DMA acquisition is stopped
+ *
+ * Input:           ADC channel number and completion callback
+ *
+ * Output:          false if the queue is full
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function adds a conversion to the queue and returns
+ *                  straight away. If the ADC is idle the conversion starts
+ *                  now, otherwise ADC_Handler starts it as soon as the ones
+ *                  ahead of it complete.
+ *
+ * Note:            Callbacks run in interrupt context and should be short
+ *
+ ******************************************************************************/
+bool adc_read_async(uint8_t channel, adc_callback_t callback)
+{
+	bool queued = false;
+
+	__disable_irq();
+	if (adc_queue_count < ADC_ASYNC_QUEUE_SIZE)
+	{
+		uint8_t slot = (adc_queue_head + adc_queue_count) & (ADC_ASYNC_QUEUE_SIZE - 1);
+		adc_queue[slot].channel = channel;
+		adc_queue[slot].callback = callback;
+		adc_queue_count++;
+
+		// ADC was idle
+		if (adc_queue_count == 1)
+		{
+			ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+			ADC->INTENSET.reg = ADC_INTENSET_RESRDY;
+			adc_async_start(channel);
+		}
+
+		queued = true;
+	}
+	__enable_irq();
+
+	return queued;
+} // adc_read_async()
+
+
+/*******************************************************************************
+ * Function:        bool adc_async_busy(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          true if conversions are queued or running
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function lets the caller wait for the queue to drain
+ *                  before handing the ADC to another mode.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+bool adc_async_busy(void)
+{
+	return adc_queue_count != 0;
+} // adc_async_busy()
+
+
+/*******************************************************************************
+ * Function:        void adc_window_init(uint16_t lower, uint16_t upper,
+ *                                       adc_window_mode_t mode,
+ *                                       adc_window_callback_t callback)
+ *
+ * PreCondition:    adc_init() has been called
+ *
+ * Input:           Window limits, condition and callback
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function programs WINLT, WINUT and WINCTRL and enables
+ *                  the WINMON interrupt. The hardware compares every result,
+ *                  however it was started and whoever reads it, so the CPU
+ *                  does not have to look at samples to catch limits.
+ *
+ * Note:            The interrupt is one-shot: ADC_Handler disables it before
+ *                  calling back, so a condition that persists cannot flood the
+ *                  CPU. Re-arm, usually with the opposite mode, to be told
+ *                  when the condition clears.
+ *
+ ******************************************************************************/
+void adc_window_init(uint16_t lower, uint16_t upper, adc_window_mode_t mode,
+	adc_window_callback_t callback)
+{
+	ADC->INTENCLR.reg = ADC_INTENCLR_WINMON;
+	adc_window_callback = callback;
+
+	ADC->WINLT.reg = lower;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->WINUT.reg = upper;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->WINCTRL.reg = ADC_WINCTRL_WINMODE(mode);
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	// Ignore a match from before the new limits
+	ADC->INTFLAG.reg = ADC_INTFLAG_WINMON;
+	ADC->INTENSET.reg = ADC_INTENSET_WINMON;
+} // adc_window_init()
+
+
+/*******************************************************************************
+ * Function:        void adc_window_disable(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function turns the window monitor off.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void adc_window_disable(void)
+{
+	ADC->INTENCLR.reg = ADC_INTENCLR_WINMON;
+
+	ADC->WINCTRL.reg = ADC_WINCTRL_WINMODE_DISABLE;
+	while (ADC->STATUS.bit.SYNCBUSY);
+} // adc_window_disable()
+
+
+/*******************************************************************************
+ * Function:        void ADC_Handler(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    Reading RESULT clears RESRDY
+ *
+ * Overview:        Serves the two ADC interrupt sources:
+ *
+ *                  - WINMON: disables itself and calls the window callback.
+ *                  - RESRDY: completes the conversion at the head of the
+ *                    queue, starts the next one before running the callback
+ *                    so the ADC is kept busy, and disables RESRDY once the
+ *                    queue is empty.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void ADC_Handler(void)
+{
+	if (ADC->INTFLAG.bit.WINMON && (ADC->INTENSET.reg & ADC_INTENSET_WINMON))
+	{
+		ADC->INTENCLR.reg = ADC_INTENCLR_WINMON;
+		ADC->INTFLAG.reg = ADC_INTFLAG_WINMON;
+
+		if (adc_window_callback != NULL)
+		{
+			adc_window_callback();
+		}
+	}
+
+	if (ADC->INTFLAG.bit.RESRDY && (ADC->INTENSET.reg & ADC_INTENSET_RESRDY))
+	{
+		uint16_t result = ADC->RESULT.reg;
+		adc_request_t done = adc_queue[adc_queue_head];
+
+		adc_queue_head = (adc_queue_head + 1) & (ADC_ASYNC_QUEUE_SIZE - 1);
+		adc_queue_count--;
+
+		if (adc_queue_count != 0)
+		{
+			adc_async_start(adc_queue[adc_queue_head].channel);
+		}
+		else
+		{
+			ADC->INTENCLR.reg = ADC_INTENCLR_RESRDY;
+		}
+
+		if (done.callback != NULL)
+		{
+			done.callback(done.channel, result);
+		}
+	}
+} // ADC_Handler()
\ No newline at end of file
@@ -5,6 +5,56 @@
 // Include and defines
 //////////////////////////////////////////////////////////////////////////
 #include "app.h"
+#include <stdbool.h>
+
+// Internal inputs (MUXPOS values)
+#define ADC_CHANNEL_TEMP            (0x18u)
+#define ADC_CHANNEL_BANDGAP         (0x19u)
+#define ADC_CHANNEL_SCALEDCOREVCC   (0x1Au)
+#define ADC_CHANNEL_SCALEDIOVCC     (0x1Bu)
+
+// Pending asynchronous conversions (power of two)
+#define ADC_ASYNC_QUEUE_SIZE        (8u)
+
+// Called from ADC_Handler when an asynchronous conversion completes
+typedef void (*adc_callback_t)(uint8_t channel, uint16_t result);
+
+// Window monitor conditions (WINCTRL.WINMODE)
+typedef enum
+{
+	ADC_WINDOW_INSIDE = ADC_WINCTRL_WINMODE_MODE3_Val,   // WINLT < RESULT < WINUT
+	ADC_WINDOW_OUTSIDE = ADC_WINCTRL_WINMODE_MODE4_Val   // RESULT outside WINLT..WINUT
+} adc_window_mode_t;
+
+// Called from ADC_Handler the first time a result meets the window condition
+typedef void (*adc_window_callback_t)(void);
+
+// INPUTSCAN can walk at most 16 consecutive inputs
+#define ADC_SCAN_MAX_CHANNELS       (16u)
+
+// Sample of scan slot 'slot' in frame 'frame' of an interleaved block
+#define ADC_SCAN_SAMPLE(block, count, frame, slot)  ((block)[((frame) * (count)) + (slot)])
+
+// Acquisition profiles, ADC clock is GCLK0 (48 MHz) / prescaler.
+// Throughput is the maximum number of results per second, ENOB the
+// typical effective resolution on the MKR Zero with a quiet supply.
+typedef enum
+{
+	// 1.5 MHz, 0.5 clk sampling, 12-bit: ~200 k results/s, ~10.5 ENOB
+	ADC_PROFILE_FAST_12BIT = 0,
+
+	// 1.5 MHz, 1 clk sampling, 256 accumulated, 16-bit: ~730 results/s, ~14 ENOB
+	ADC_PROFILE_OVERSAMPLED_16BIT,
+
+	// 94 kHz, 0.5 clk sampling, 8-bit: ~17 k results/s, 8 ENOB, lowest current
+	ADC_PROFILE_FINGER_DETECT_8BIT,
+
+	// 1.5 MHz, 1 clk sampling, 16 accumulated, 16-bit: ~11 k results/s, ~13 ENOB,
+	// same full scale as ADC_PROFILE_OVERSAMPLED_16BIT for kHz frame rates
+	ADC_PROFILE_AVERAGED_16BIT,
+
+	ADC_PROFILE_COUNT
+} adc_profile_t;
 
 //////////////////////////////////////////////////////////////////////////
 // Function Prototypes
@@ -27,4 +77,83 @@ void adc_init(void);
 int32_t adc_readchannel(uint8_t channel);
 
 
+/**
+ * \def adc_read_async
+ * \brief Queues a conversion, the callback receives the result from ADC_Handler
+ * \param channel (ADC channel number)
+ * \param callback (completion callback, may be NULL)
+ */
+bool adc_read_async(uint8_t channel, adc_callback_t callback);
+
+
+/**
+ * \def adc_async_busy
+ * \brief Returns true while queued conversions are outstanding
+ * \param none
+ */
+bool adc_async_busy(void);
+
+
+/**
+ * \def adc_window_init
+ * \brief Arms the window monitor, the callback fires once when a result meets the condition
+ * \param lower (WINLT, in the units of the current resolution)
+ * \param upper (WINUT, in the units of the current resolution)
+ * \param mode (ADC_WINDOW_INSIDE or ADC_WINDOW_OUTSIDE)
+ * \param callback (window callback)
+ */
+void adc_window_init(uint16_t lower, uint16_t upper, adc_window_mode_t mode,
+	adc_window_callback_t callback);
+
+
+/**
+ * \def adc_window_disable
+ * \brief Turns the window monitor and its interrupt off
+ * \param none
+ */
+void adc_window_disable(void);
+
+
+/**
+ * \def adc_set_profile
+ * \brief Programs prescaler, sample length, resolution and averaging together
+ * \param profile (one of adc_profile_t)
+ */
+void adc_set_profile(adc_profile_t profile);
+
+
+/**
+ * \def adc_profile_max_rate
+ * \brief Highest trigger rate in Hz a profile can keep up with
+ * \param profile (one of adc_profile_t)
+ */
+uint32_t adc_profile_max_rate(adc_profile_t profile);
+
+
+/**
+ * \def adc_start_event
+ * \brief Routes an event generator to the ADC START input, one conversion per event
+ * \param evsys_channel (EVSYS channel to use)
+ * \param generator (event generator, eg. EVSYS_ID_GEN_TC3_OVF)
+ */
+void adc_start_event(uint8_t evsys_channel, uint8_t generator);
+
+
+/**
+ * \def adc_scan_init
+ * \brief Converts count consecutive inputs starting at first, one per START
+ * \param first (first ADC channel number of the sweep)
+ * \param count (number of channels in the sweep, 1 to ADC_SCAN_MAX_CHANNELS)
+ */
+bool adc_scan_init(uint8_t first, uint8_t count);
+
+
+/**
+ * \def adc_scan_count
+ * \brief Number of channels in one sweep (frame) of the current scan
+ * \param none
+ */
+uint8_t adc_scan_count(void);
+
+
 #endif /* ADC_H_ */
\ No newline at end of file
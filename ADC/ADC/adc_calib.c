@@ -0,0 +1,295 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "adc_calib.h"
+#include "adc.h"
+
+// Words written to the calibration row
+#define ADC_CALIB_WORDS   (sizeof(adc_calib_t) / sizeof(uint32_t))
+
+// Correction currently loaded in the ADC
+static uint16_t adc_calib_gain = 0x0800u;
+static int16_t adc_calib_offset = 0;
+
+
+/*******************************************************************************
+ * Function:        static uint32_t adc_calib_checksum(const adc_calib_t *record)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Calibration record
+ *
+ * Output:          Check word for the record
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Guards against a half written or erased (all ones) row.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static uint32_t adc_calib_checksum(const adc_calib_t *record)
+{
+	return ~(record->magic ^
+		((uint32_t)record->gaincorr | ((uint32_t)(uint16_t)record->offsetcorr << 16)));
+} // adc_calib_checksum()
+
+
+/*******************************************************************************
+ * Function:        static void adc_calib_averaging(bool enable)
+ *
+ * PreCondition:    adc_init() has been called
+ *
+ * Input:           true for 16x averaged raw results, false for the adc_init()
+ *                  single conversion setup
+ *
+ * Output:          None
+ *
+ * Side Effects:    The ADC is disabled while it is reconfigured, hardware
+ *                  correction is turned off when enabling averaging
+ *
+ * Overview:        Averaging 16 conversions (shifted back to 12 bits) keeps
+ *                  noise out of the measured correction.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void adc_calib_averaging(bool enable)
+{
+	// Disable ADC
+	ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	if (enable)
+	{
+		ADC->CTRLB.bit.CORREN = 0;
+		while (ADC->STATUS.bit.SYNCBUSY);
+		ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_16 | ADC_AVGCTRL_ADJRES(4);
+		ADC->CTRLB.bit.RESSEL = ADC_CTRLB_RESSEL_16BIT_Val;
+	}
+	else
+	{
+		ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_1 | ADC_AVGCTRL_ADJRES(0);
+		ADC->CTRLB.bit.RESSEL = ADC_CTRLB_RESSEL_12BIT_Val;
+	}
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	// Enable ADC
+	ADC->CTRLA.reg |= ADC_CTRLA_ENABLE;
+	while (ADC->STATUS.bit.SYNCBUSY);
+} // adc_calib_averaging()
+
+
+/*******************************************************************************
+ * Function:        static void adc_calib_nvm_command(uint16_t command)
+ *
+ * PreCondition:    None
+ *
+ * Input:           NVMCTRL command
+ *
+ * Output:          None
+ *
+ * Side Effects:    The CPU stalls on flash reads until the command completes
+ *
+ * Overview:        Runs one NVMCTRL command on the calibration row.
+ *
+ * Note:            ADDR is given in 16-bit words
+ *
+ ******************************************************************************/
+static void adc_calib_nvm_command(uint16_t command)
+{
+	NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
+	NVMCTRL->ADDR.reg = ADC_CALIB_ROW_ADDR / 2;
+	NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | command;
+	while (!NVMCTRL->INTFLAG.bit.READY);
+} // adc_calib_nvm_command()
+
+
+/*******************************************************************************
+ * Function:        void adc_calib_apply(uint16_t gaincorr, int16_t offsetcorr)
+ *
+ * PreCondition:    adc_init() has been called
+ *
+ * Input:           Gain (1.11 fixed point) and offset (12-bit counts)
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function loads the correction registers and sets
+ *                  CTRLB.CORREN. The ADC then outputs
+ *                  (raw - OFFSETCORR) * GAINCORR for every result, at no CPU
+ *                  cost per sample.
+ *
+ * Note:            Hardware correction adds 3 ADC clocks of latency
+ *
+ ******************************************************************************/
+void adc_calib_apply(uint16_t gaincorr, int16_t offsetcorr)
+{
+	adc_calib_gain = gaincorr;
+	adc_calib_offset = offsetcorr;
+
+	ADC->GAINCORR.reg = ADC_GAINCORR_GAINCORR(gaincorr);
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->OFFSETCORR.reg = ADC_OFFSETCORR_OFFSETCORR(offsetcorr);
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	ADC->CTRLB.bit.CORREN = 1;
+	while (ADC->STATUS.bit.SYNCBUSY);
+} // adc_calib_apply()
+
+
+/*******************************************************************************
+ * Function:        bool adc_calib_load(void)
+ *
+ * PreCondition:    adc_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          true if a valid record was found and applied
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function reads the record from the calibration row,
+ *                  which takes a few microseconds, instead of measuring again
+ *                  on every boot.
+ *
+ * Note:            An erased row reads as all ones and fails the magic check
+ *
+ ******************************************************************************/
+bool adc_calib_load(void)
+{
+	const adc_calib_t *record = (const adc_calib_t *)ADC_CALIB_ROW_ADDR;
+
+	if ((record->magic != ADC_CALIB_MAGIC) || (record->check != adc_calib_checksum(record)))
+	{
+		return false;
+	}
+
+	if ((record->gaincorr < ADC_CALIB_GAIN_MIN) || (record->gaincorr > ADC_CALIB_GAIN_MAX) ||
+		(record->offsetcorr > ADC_CALIB_OFFSET_LIMIT) || (record->offsetcorr < -ADC_CALIB_OFFSET_LIMIT))
+	{
+		return false;
+	}
+
+	adc_calib_apply(record->gaincorr, record->offsetcorr);
+	return true;
+} // adc_calib_load()
+
+
+/*******************************************************************************
+ * Function:        bool adc_calib_run(void)
+ *
+ * PreCondition:    adc_init() has been called, no other ADC mode is running
+ *
+ * Input:           None
+ *
+ * Output:          false if the measured correction is not believable
+ *
+ * Side Effects:    MUXPOS is changed, the ADC is left in the adc_init()
+ *                  single conversion setup
+ *
+ * Overview:        This function measures two internal points with hardware
+ *                  correction off:
+ *
+ *                  - Zero: a differential conversion with both inputs on the
+ *                    same pin, which leaves only the ADC's own offset.
+ *                  - Span: SCALEDIOVCC (VDDIO / 4) against the INTVCC0
+ *                    reference (VDDANA / 1.48). With one 3.3V rail this is
+ *                    0.37 of full scale whatever the actual supply voltage.
+ *
+ *                  The offset is the zero reading and the gain maps the span
+ *                  reading back to its expected value. Both are applied with
+ *                  adc_calib_apply().
+ *
+ * Note:            The single division runs once per calibration
+ *
+ ******************************************************************************/
+bool adc_calib_run(void)
+{
+	adc_calib_averaging(true);
+
+	// Zero: both inputs on the same pin
+	ADC->INPUTCTRL.bit.MUXNEG = ADC_CALIB_ZERO_PIN;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->CTRLB.bit.DIFFMODE = 1;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	// First result after a MUX change is discarded
+	(void)adc_readchannel(ADC_CALIB_ZERO_PIN);
+	int32_t offset = (int16_t)adc_readchannel(ADC_CALIB_ZERO_PIN);
+
+	// Back to single ended
+	ADC->CTRLB.bit.DIFFMODE = 0;
+	while (ADC->STATUS.bit.SYNCBUSY);
+	ADC->INPUTCTRL.bit.MUXNEG = ADC_INPUTCTRL_MUXNEG_GND_Val;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	// Span: VDDIO / 4
+	(void)adc_readchannel(ADC_CHANNEL_SCALEDIOVCC);
+	int32_t span = adc_readchannel(ADC_CHANNEL_SCALEDIOVCC) - offset;
+
+	adc_calib_averaging(false);
+
+	if ((offset > ADC_CALIB_OFFSET_LIMIT) || (offset < -ADC_CALIB_OFFSET_LIMIT) || (span <= 0))
+	{
+		return false;
+	}
+
+	uint32_t gain = (ADC_CALIB_VDDIO_EXPECTED + ((uint32_t)span / 2)) / (uint32_t)span;
+	if ((gain < ADC_CALIB_GAIN_MIN) || (gain > ADC_CALIB_GAIN_MAX))
+	{
+		return false;
+	}
+
+	adc_calib_apply((uint16_t)gain, (int16_t)offset);
+	return true;
+} // adc_calib_run()
+
+
+/*******************************************************************************
+ * Function:        void adc_calib_save(void)
+ *
+ * PreCondition:    adc_calib_run() has succeeded
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    The calibration row is erased and rewritten
+ *
+ * Overview:        This function stores the correction in use so that the
+ *                  next boot can use adc_calib_load().
+ *
+ * Note:            Only the first page of the row is written, the page buffer
+ *                  is committed with a manual write command.
+ *
+ ******************************************************************************/
+void adc_calib_save(void)
+{
+	adc_calib_t record =
+	{
+		.magic = ADC_CALIB_MAGIC,
+		.gaincorr = adc_calib_gain,
+		.offsetcorr = adc_calib_offset,
+		.check = 0,
+		.reserved = 0xFFFFFFFFu
+	};
+	record.check = adc_calib_checksum(&record);
+
+	const uint32_t *src = (const uint32_t *)&record;
+	volatile uint32_t *dst = (volatile uint32_t *)ADC_CALIB_ROW_ADDR;
+
+	NVMCTRL->CTRLB.bit.MANW = 1;
+
+	adc_calib_nvm_command(NVMCTRL_CTRLA_CMD_ER);
+	adc_calib_nvm_command(NVMCTRL_CTRLA_CMD_PBC);
+
+	// Fill the page buffer, 32-bit writes only
+	for (uint32_t i = 0; i < ADC_CALIB_WORDS; i++)
+	{
+		dst[i] = src[i];
+	}
+
+	adc_calib_nvm_command(NVMCTRL_CTRLA_CMD_WP);
+} // adc_calib_save()
@@ -0,0 +1,76 @@
+#ifndef ADC_CALIB_H_
+#define ADC_CALIB_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "app.h"
+#include <stdbool.h>
+
+// Flash row reserved for the calibration record (see samd21g18au_flash.ld)
+#define ADC_CALIB_ROW_ADDR        (0x0003FF00u)
+
+// Marks a valid record ("ADCC")
+#define ADC_CALIB_MAGIC           (0x43434441u)
+
+// ADC input used for the offset measurement, shorted against itself
+#define ADC_CALIB_ZERO_PIN        (0u)
+
+// SCALEDIOVCC (VDDIO / 4) against INTVCC0 (VDDANA / 1.48) is 0.37 of full
+// scale when VDDIO = VDDANA, in 12-bit counts scaled by 2^11 (GAINCORR 1.0)
+#define ADC_CALIB_VDDIO_EXPECTED  ((4096u * 2048u * 37u + 50u) / 100u)
+
+// Largest believable correction
+#define ADC_CALIB_OFFSET_LIMIT    (128)
+#define ADC_CALIB_GAIN_MIN        (0x0700u)
+#define ADC_CALIB_GAIN_MAX        (0x0900u)
+
+// Record stored in the calibration row
+typedef struct
+{
+	uint32_t magic;
+	uint16_t gaincorr;      // GAINCORR, 1.11 unsigned fixed point
+	int16_t offsetcorr;     // OFFSETCORR, 12-bit counts
+	uint32_t check;         // bitwise complement of the words above, XORed
+	uint32_t reserved;
+} adc_calib_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def adc_calib_load
+ * \brief Applies the stored gain/offset correction, returns false if there is none
+ * \param none
+ */
+bool adc_calib_load(void);
+
+
+/**
+ * \def adc_calib_run
+ * \brief Measures internal references and applies the resulting correction
+ * \param none
+ */
+bool adc_calib_run(void);
+
+
+/**
+ * \def adc_calib_save
+ * \brief Writes the correction currently in use to the calibration row
+ * \param none
+ */
+void adc_calib_save(void);
+
+
+/**
+ * \def adc_calib_apply
+ * \brief Loads GAINCORR and OFFSETCORR and enables hardware correction
+ * \param gaincorr (1.11 unsigned fixed point, 0x800 is 1.0)
+ * \param offsetcorr (12-bit counts)
+ */
+void adc_calib_apply(uint16_t gaincorr, int16_t offsetcorr);
+
+
+#endif /* ADC_CALIB_H_ */
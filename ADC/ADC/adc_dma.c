@@ -0,0 +1,275 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "adc_dma.h"
+#include "dma.h"
+#include <stddef.h>
+
+// No block is waiting to be collected
+#define ADC_DMA_NO_BLOCK       (0xFFu)
+
+// Ping-pong buffer, the DMAC fills one half while the other is processed
+static uint16_t adc_dma_buffer[2][ADC_DMA_BLOCK_SIZE];
+
+// Second descriptor of the ring, the first lives in the DMAC base section
+static DmacDescriptor adc_dma_pong __attribute__((aligned(16)));
+
+// Half the DMAC is currently writing to
+static volatile uint8_t adc_dma_fill = 0;
+
+// Half that is full and waiting for the main loop
+static volatile uint8_t adc_dma_ready = ADC_DMA_NO_BLOCK;
+
+static volatile uint32_t adc_dma_overrun_count = 0;
+
+// Samples per block, trimmed to a whole number of scan frames
+static uint16_t adc_dma_length = ADC_DMA_BLOCK_SIZE;
+
+
+/*******************************************************************************
+ * Function:        static void adc_dma_block_done(uint8_t flags)
+ *
+ * PreCondition:    None
+ *
+ * Input:           CHINTFLAG bits of the ADC DMAC channel
+ *
+ * Output:          None
+ *
+ * Side Effects:    Runs in DMAC_Handler context
+ *
+ * Overview:        Publishes the half that was just filled and moves on to the
+ *                  other one. If the main loop has not collected the previous
+ *                  block yet it is counted as an overrun and replaced.
+ *
+ * Note:            The DMAC has already switched to the next descriptor, so
+ *                  this only does bookkeeping.
+ *
+ ******************************************************************************/
+static void adc_dma_block_done(uint8_t flags)
+{
+	if (flags & DMAC_CHINTFLAG_TCMPL)
+	{
+		if (adc_dma_ready != ADC_DMA_NO_BLOCK)
+		{
+			adc_dma_overrun_count++;
+		}
+
+		adc_dma_ready = adc_dma_fill;
+		adc_dma_fill ^= 1u;
+	}
+} // adc_dma_block_done()
+
+
+/*******************************************************************************
+ * Function:        static void adc_dma_descriptor(DmacDescriptor *desc,
+ *                                                 uint16_t *dst,
+ *                                                 DmacDescriptor *next)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Descriptor to fill, destination half and next descriptor
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Fills in a descriptor that copies one block of results
+ *                  into one half of the buffer.
+ *
+ * Note:            With DSTINC set, DSTADDR is the address after the last beat
+ *
+ ******************************************************************************/
+static void adc_dma_descriptor(DmacDescriptor *desc, uint16_t *dst, DmacDescriptor *next)
+{
+	desc->BTCTRL.reg = DMAC_BTCTRL_VALID |
+		DMAC_BTCTRL_BLOCKACT_INT |
+		DMAC_BTCTRL_BEATSIZE_HWORD |
+		DMAC_BTCTRL_DSTINC;
+	desc->BTCNT.reg = adc_dma_length;
+	desc->SRCADDR.reg = (uint32_t)&ADC->RESULT.reg;
+	desc->DSTADDR.reg = (uint32_t)(dst + adc_dma_length);
+	desc->DESCADDR.reg = (uint32_t)next;
+} // adc_dma_descriptor()
+
+
+/*******************************************************************************
+ * Function:        void adc_dma_init(uint8_t frame_size)
+ *
+ * PreCondition:    adc_scan_init() has selected the input(s)
+ *
+ * Input:           Samples per frame, a scan sweep or an LED sequence
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function links two descriptors into a ring so the
+ *                  DMAC keeps alternating between the halves of the buffer
+ *                  without any CPU involvement, and raises an interrupt each
+ *                  time a half is full.
+ *
+ * Note:            Blocks hold whole frames so that slot 0 of every block is
+ *                  always the first channel of the sweep or the first LED
+ *                  phase. Call adc_dma_start() to begin conversions.
+ *
+ ******************************************************************************/
+void adc_dma_init(uint8_t frame_size)
+{
+	adc_dma_length = (ADC_DMA_BLOCK_SIZE / frame_size) * frame_size;
+
+	dma_init();
+	dma_channel_init(ADC_DMA_CHANNEL, ADC_DMAC_ID_RESRDY, adc_dma_block_done);
+
+	// ping -> pong -> ping ...
+	DmacDescriptor *ping = dma_descriptor(ADC_DMA_CHANNEL);
+	adc_dma_descriptor(ping, adc_dma_buffer[0], &adc_dma_pong);
+	adc_dma_descriptor(&adc_dma_pong, adc_dma_buffer[1], ping);
+
+	adc_dma_fill = 0;
+	adc_dma_ready = ADC_DMA_NO_BLOCK;
+	adc_dma_overrun_count = 0;
+} // adc_dma_init()
+
+
+/*******************************************************************************
+ * Function:        void adc_dma_start(void)
+ *
+ * PreCondition:    adc_dma_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    Without a start event source the ADC is switched to
+ *                  free-running mode
+ *
+ * Overview:        This function enables the DMAC channel. If nothing drives
+ *                  the ADC START event input the ADC is left converting
+ *                  continuously, otherwise each event yields one beat.
+ *
+ * Note:            Each result triggers one DMA beat. A result left over from
+ *                  before is discarded so that it cannot shift the frames.
+ *
+ ******************************************************************************/
+void adc_dma_start(void)
+{
+	(void)ADC->RESULT.reg;
+	dma_channel_enable(ADC_DMA_CHANNEL);
+
+	if (!ADC->EVCTRL.bit.STARTEI)
+	{
+		// Convert continuously
+		ADC->CTRLB.bit.FREERUN = 1;
+		while (ADC->STATUS.bit.SYNCBUSY);
+
+		ADC->SWTRIG.reg = ADC_SWTRIG_START | ADC_SWTRIG_FLUSH;
+		while (ADC->STATUS.bit.SYNCBUSY);
+	}
+} // adc_dma_start()
+
+
+/*******************************************************************************
+ * Function:        void adc_dma_stop(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    The ADC is left in single conversion mode
+ *
+ * Overview:        This function stops conversions and the DMAC channel.
+ *
+ * Note:            A block that was ready stays available
+ *
+ ******************************************************************************/
+void adc_dma_stop(void)
+{
+	ADC->CTRLB.bit.FREERUN = 0;
+	while (ADC->STATUS.bit.SYNCBUSY);
+
+	dma_channel_disable(ADC_DMA_CHANNEL);
+} // adc_dma_stop()
+
+
+/*******************************************************************************
+ * Function:        const uint16_t *adc_dma_get_block(void)
+ *
+ * PreCondition:    adc_dma_start() has been called
+ *
+ * Input:           None
+ *
+ * Output:          Pointer to adc_dma_block_length() samples, or NULL
+ *
+ * Side Effects:    The block is marked as collected
+ *
+ * Overview:        This function hands the last full half to the caller. The
+ *                  caller has one block period to finish with it before the
+ *                  DMAC starts overwriting it.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+const uint16_t *adc_dma_get_block(void)
+{
+	uint8_t ready;
+
+	__disable_irq();
+	ready = adc_dma_ready;
+	adc_dma_ready = ADC_DMA_NO_BLOCK;
+	__enable_irq();
+
+	if (ready == ADC_DMA_NO_BLOCK)
+	{
+		return NULL;
+	}
+
+	return adc_dma_buffer[ready];
+} // adc_dma_get_block()
+
+
+/*******************************************************************************
+ * Function:        uint16_t adc_dma_block_length(void)
+ *
+ * PreCondition:    adc_dma_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          Number of samples in each block
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function returns the block length, which is the
+ *                  largest multiple of the frame size that fits in
+ *                  ADC_DMA_BLOCK_SIZE.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint16_t adc_dma_block_length(void)
+{
+	return adc_dma_length;
+} // adc_dma_block_length()
+
+
+/*******************************************************************************
+ * Function:        uint32_t adc_dma_overruns(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          Number of blocks dropped since adc_dma_init()
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function reports how often the main loop fell behind.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint32_t adc_dma_overruns(void)
+{
+	return adc_dma_overrun_count;
+} // adc_dma_overruns()
@@ -0,0 +1,70 @@
+#ifndef ADC_DMA_H_
+#define ADC_DMA_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "app.h"
+#include <stdbool.h>
+
+// DMAC channel reserved for draining ADC->RESULT
+#define ADC_DMA_CHANNEL        (0u)
+
+// Capacity of each half of the ping-pong buffer in samples. 96 holds 32 red,
+// IR and dark frames, a whole number of DECIM_FACTOR groups.
+#define ADC_DMA_BLOCK_SIZE     (96u)
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def adc_dma_init
+ * \brief Sets up the DMAC to copy every ADC result into a ping-pong buffer
+ * \param frame_size (samples per interleaved frame, eg. adc_scan_count())
+ */
+void adc_dma_init(uint8_t frame_size);
+
+
+/**
+ * \def adc_dma_start
+ * \brief Starts free-running conversions drained by the DMAC
+ * \param none
+ */
+void adc_dma_start(void);
+
+
+/**
+ * \def adc_dma_stop
+ * \brief Stops conversions and the DMAC channel
+ * \param none
+ */
+void adc_dma_stop(void);
+
+
+/**
+ * \def adc_dma_get_block
+ * \brief Returns the half buffer that was last filled, or NULL if none is ready
+ * \param none
+ */
+const uint16_t *adc_dma_get_block(void);
+
+
+/**
+ * \def adc_dma_block_length
+ * \brief Number of samples in each block, a whole number of scan frames
+ * \param none
+ */
+uint16_t adc_dma_block_length(void);
+
+
+/**
+ * \def adc_dma_overruns
+ * \brief Number of blocks that were overwritten before being collected
+ * \param none
+ */
+uint32_t adc_dma_overruns(void);
+
+
+#endif /* ADC_DMA_H_ */
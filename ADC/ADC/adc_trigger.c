@@ -0,0 +1,166 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "adc_trigger.h"
+#include "adc.h"
+
+
+/*******************************************************************************
+ * Function:        static uint16_t adc_trigger_period(uint16_t rate_hz)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Sample rate in Hz
+ *
+ * Output:          TC3 TOP value for that rate
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clamps the rate to the supported range and converts it into
+ *                  a number of TC3 ticks.
+ *
+ * Note:            At 1 MHz the period is 1000 ticks at 1 kHz and 40000 ticks
+ *                  at 25 Hz, both fit in COUNT16.
+ *
+ ******************************************************************************/
+static uint16_t adc_trigger_period(uint16_t rate_hz)
+{
+	if (rate_hz < ADC_TRIGGER_RATE_MIN_HZ)
+	{
+		rate_hz = ADC_TRIGGER_RATE_MIN_HZ;
+	}
+	else if (rate_hz > ADC_TRIGGER_RATE_MAX_HZ)
+	{
+		rate_hz = ADC_TRIGGER_RATE_MAX_HZ;
+	}
+
+	// Round to the nearest tick
+	return (uint16_t)(((ADC_TRIGGER_TC_CLK_FREQ + (rate_hz / 2)) / rate_hz) - 1);
+} // adc_trigger_period()
+
+
+/*******************************************************************************
+ * Function:        void adc_trigger_init(uint16_t rate_hz)
+ *
+ * PreCondition:    ClocksInit() and adc_init() have been called
+ *
+ * Input:           Sample rate in Hz
+ *
+ * Output:          None
+ *
+ * Side Effects:    The ADC only converts on START events from now on
+ *
+ * Overview:        This function sets up TC3 as a match frequency timer and
+ *                  routes its overflow event through EVSYS to the ADC START
+ *                  input. Every sample is then started by hardware at an exact
+ *                  period, with no CPU involvement.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void adc_trigger_init(uint16_t rate_hz)
+{
+	// Enable APBC clock for TC3
+	REG_PM_APBCMASK |= PM_APBCMASK_TC3;
+
+	// Assign the 8 MHz clock to TC3
+	GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC2_TC3 |
+		GCLK_CLKCTRL_GEN(GENERIC_CLOCK_GENERATOR_OSC8M) |
+		GCLK_CLKCTRL_CLKEN;
+	while (GCLK->STATUS.bit.SYNCBUSY);
+
+	// Reset TC3
+	TC3->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+	while (TC3->COUNT16.CTRLA.bit.SWRST || TC3->COUNT16.STATUS.bit.SYNCBUSY);
+
+	// 16-bit counter, TOP = CC0, 8 MHz / 8 = 1 MHz
+	TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 |
+		TC_CTRLA_WAVEGEN_MFRQ |
+		TC_CTRLA_PRESCALER_DIV8 |
+		TC_CTRLA_PRESCSYNC_PRESC;
+	while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+
+	TC3->COUNT16.CC[0].reg = adc_trigger_period(rate_hz);
+	while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+
+	// Emit an event on every overflow
+	TC3->COUNT16.EVCTRL.reg = TC_EVCTRL_OVFEO;
+
+	// TC3 overflow -> EVSYS channel -> ADC START
+	adc_start_event(ADC_TRIGGER_EVSYS_CHANNEL, EVSYS_ID_GEN_TC3_OVF);
+} // adc_trigger_init()
+
+
+/*******************************************************************************
+ * Function:        void adc_trigger_set_rate(uint16_t rate_hz)
+ *
+ * PreCondition:    adc_trigger_init() has been called
+ *
+ * Input:           Sample rate in Hz
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function changes the TC3 period. The counter is
+ *                  restarted so the new rate does not have to wait for a long
+ *                  old period to run out.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void adc_trigger_set_rate(uint16_t rate_hz)
+{
+	TC3->COUNT16.CC[0].reg = adc_trigger_period(rate_hz);
+	while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+
+	TC3->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+	while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+} // adc_trigger_set_rate()
+
+
+/*******************************************************************************
+ * Function:        void adc_trigger_start(void)
+ *
+ * PreCondition:    adc_trigger_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function enables TC3, the first sample follows one
+ *                  period later.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void adc_trigger_start(void)
+{
+	TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+	while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+} // adc_trigger_start()
+
+
+/*******************************************************************************
+ * Function:        void adc_trigger_stop(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function disables TC3.
+ *
+ * Note:            A conversion already started still completes
+ *
+ ******************************************************************************/
+void adc_trigger_stop(void)
+{
+	TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+	while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+} // adc_trigger_stop()
@@ -0,0 +1,56 @@
+#ifndef ADC_TRIGGER_H_
+#define ADC_TRIGGER_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "app.h"
+
+// Supported sample rates
+#define ADC_TRIGGER_RATE_MIN_HZ    (25u)
+#define ADC_TRIGGER_RATE_MAX_HZ    (1000u)
+
+// EVSYS channel used to route the TC3 overflow to the ADC START input
+#define ADC_TRIGGER_EVSYS_CHANNEL  (0u)
+
+// TC3 counts OSC8M (GCLK3) divided by 8
+#define ADC_TRIGGER_TC_CLK_FREQ    (1000000u)
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def adc_trigger_init
+ * \brief Routes a TC3 overflow event to the ADC START input
+ * \param rate_hz (sample rate, ADC_TRIGGER_RATE_MIN_HZ to ADC_TRIGGER_RATE_MAX_HZ)
+ */
+void adc_trigger_init(uint16_t rate_hz);
+
+
+/**
+ * \def adc_trigger_set_rate
+ * \brief Changes the sample rate, takes effect from the next period
+ * \param rate_hz (sample rate, ADC_TRIGGER_RATE_MIN_HZ to ADC_TRIGGER_RATE_MAX_HZ)
+ */
+void adc_trigger_set_rate(uint16_t rate_hz);
+
+
+/**
+ * \def adc_trigger_start
+ * \brief Starts the sample timer
+ * \param none
+ */
+void adc_trigger_start(void);
+
+
+/**
+ * \def adc_trigger_stop
+ * \brief Stops the sample timer, no further conversions are started
+ * \param none
+ */
+void adc_trigger_stop(void);
+
+
+#endif /* ADC_TRIGGER_H_ */
@@ -0,0 +1,377 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "alarm.h"
+
+// Limits of one alarm
+typedef struct
+{
+	int32_t limit;
+	int32_t hysteresis;
+	uint32_t delay_ms;
+	uint32_t escalate_ms;
+	uint32_t stale_ms;          // no value for this long gives stale_value, 0 for never
+	int32_t stale_value;
+	alarm_priority_t priority;  // priority when raised
+	bool above;                 // raised above the limit, else below
+	char *name;
+} alarm_config_t;
+
+static const alarm_config_t alarm_config[ALARM_COUNT] =
+{
+	{ ALARM_SPO2_LOW, ALARM_SPO2_HYSTERESIS, ALARM_SPO2_DELAY_MS, ALARM_SPO2_ESCALATE_MS, 0u, 0, ALARM_MEDIUM, false, "SpO2 low" },
+	{ ALARM_HR_LOW, ALARM_HR_HYSTERESIS, ALARM_HR_DELAY_MS, ALARM_HR_ESCALATE_MS, ALARM_HR_STALE_MS, 0, ALARM_MEDIUM, false, "HR low" },
+	{ ALARM_HR_HIGH, ALARM_HR_HYSTERESIS, ALARM_HR_DELAY_MS, ALARM_HR_ESCALATE_MS, 0u, 0, ALARM_MEDIUM, true, "HR high" },
+	{ ALARM_PI_LOW, ALARM_PI_HYSTERESIS, ALARM_PI_DELAY_MS, 0u, 0u, 0, ALARM_LOW, false, "Perfusion low" },
+	{ 0, 0, ALARM_PROBE_DELAY_MS, ALARM_PROBE_ESCALATE_MS, 0u, 0, ALARM_LOW, true, "Probe off" }
+};
+
+
+/*******************************************************************************
+ * Function:        static bool alarm_check(alarm_engine_t *engine, alarm_id_t id,
+ *                                          uint32_t now_ms)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Engine state, alarm and time
+ *
+ * Output:          true if the alarm was raised or escalated
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Raises an alarm whose condition has held for its delay,
+ *                  noting the time from onset, or moves a raised alarm up
+ *                  one priority each escalation time.
+ *
+ * Note:            Times are compared by difference, so the ms counter may
+ *                  wrap
+ *
+ ******************************************************************************/
+static bool alarm_check(alarm_engine_t *engine, alarm_id_t id, uint32_t now_ms)
+{
+	alarm_state_t *alarm = &engine->alarm[id];
+	const alarm_config_t *config = &alarm_config[id];
+
+	if (alarm->level == ALARM_NONE)
+	{
+		if (!alarm->condition || ((now_ms - alarm->onset_ms) < config->delay_ms))
+		{
+			return false;
+		}
+		alarm->level = config->priority;
+		alarm->raised_ms = now_ms;
+		alarm->latency_ms = now_ms - alarm->onset_ms;
+		if (alarm->latency_ms > engine->latency_max_ms)
+		{
+			engine->latency_max_ms = alarm->latency_ms;
+		}
+		return true;
+	}
+
+	if ((config->escalate_ms != 0u) && (alarm->level < ALARM_HIGH) &&
+		((now_ms - alarm->raised_ms) >= config->escalate_ms))
+	{
+		alarm->level++;
+		alarm->raised_ms = now_ms;
+		return true;
+	}
+	return false;
+} // alarm_check()
+
+
+/*******************************************************************************
+ * Function:        static bool alarm_evaluate(alarm_engine_t *engine, alarm_id_t id,
+ *                                             int32_t value, uint32_t now_ms)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Engine state, alarm, value and time
+ *
+ * Output:          true if the alarm's priority changed
+ *
+ * Side Effects:    None
+ *
+ * Overview:        A value past the limit starts the condition, and the
+ *                  alarm is raised at once if its delay allows. A raised
+ *                  alarm clears only once a value is back past the limit by
+ *                  the hysteresis, so a value hovering at the limit does not
+ *                  make it chatter.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool alarm_evaluate(alarm_engine_t *engine, alarm_id_t id, int32_t value, uint32_t now_ms)
+{
+	alarm_state_t *alarm = &engine->alarm[id];
+	const alarm_config_t *config = &alarm_config[id];
+
+	alarm->value = value;
+
+	bool past = config->above ? (value > config->limit) : (value < config->limit);
+	bool back = config->above ? (value <= (config->limit - config->hysteresis)) :
+		(value >= (config->limit + config->hysteresis));
+
+	if (alarm->level != ALARM_NONE)
+	{
+		if (!back)
+		{
+			return alarm_check(engine, id, now_ms);
+		}
+		alarm->level = ALARM_NONE;
+		alarm->condition = false;
+		return true;
+	}
+
+	if (!past)
+	{
+		alarm->condition = false;
+		return false;
+	}
+	if (!alarm->condition)
+	{
+		alarm->condition = true;
+		alarm->onset_ms = now_ms;
+	}
+	return alarm_check(engine, id, now_ms);
+} // alarm_evaluate()
+
+
+/*******************************************************************************
+ * Function:        void alarm_init(alarm_engine_t *engine)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Engine state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears every alarm and the worst latency.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void alarm_init(alarm_engine_t *engine)
+{
+	for (uint8_t id = 0; id < ALARM_COUNT; id++)
+	{
+		engine->alarm[id] = (alarm_state_t){ 0 };
+	}
+	engine->latency_max_ms = 0;
+} // alarm_init()
+
+
+/*******************************************************************************
+ * Function:        bool alarm_update(alarm_engine_t *engine, alarm_id_t id,
+ *                                    int32_t value, bool valid, uint32_t now_ms)
+ *
+ * PreCondition:    alarm_init() has been called
+ *
+ * Input:           Engine state, alarm, new value, whether it is valid and
+ *                  time
+ *
+ * Output:          true if the alarm's priority changed
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Evaluates a valid value against the limits. Without a
+ *                  valid value a waiting condition is dropped but a raised
+ *                  alarm stays raised, and the value cannot go stale, as
+ *                  when the probe is off and the probe alarm speaks for it.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+bool alarm_update(alarm_engine_t *engine, alarm_id_t id, int32_t value, bool valid, uint32_t now_ms)
+{
+	alarm_state_t *alarm = &engine->alarm[id];
+
+	alarm->live = valid;
+	if (!valid)
+	{
+		alarm->condition = false;
+		return false;
+	}
+	alarm->seen_ms = now_ms;
+	alarm->stale = false;
+	return alarm_evaluate(engine, id, value, now_ms);
+} // alarm_update()
+
+
+/*******************************************************************************
+ * Function:        void alarm_seen(alarm_engine_t *engine, alarm_id_t id,
+ *                                  uint32_t now_ms)
+ *
+ * PreCondition:    alarm_init() has been called
+ *
+ * Input:           Engine state, alarm and time
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        For a beat that was found but turned down, eg. by the SQI
+ *                  during motion. Its rate is not evaluated, but the pulse
+ *                  has not stopped either, so the value does not go stale
+ *                  and a condition the stale value started is dropped.
+ *
+ * Note:            A condition from a measured value is kept, and a raised
+ *                  alarm stays raised until a valid value clears it
+ *
+ ******************************************************************************/
+void alarm_seen(alarm_engine_t *engine, alarm_id_t id, uint32_t now_ms)
+{
+	alarm_state_t *alarm = &engine->alarm[id];
+
+	alarm->seen_ms = now_ms;
+	if (alarm->stale)
+	{
+		alarm->stale = false;
+		alarm->condition = false;
+	}
+} // alarm_seen()
+
+
+/*******************************************************************************
+ * Function:        uint8_t alarm_tick(alarm_engine_t *engine, uint32_t now_ms)
+ *
+ * PreCondition:    alarm_init() has been called
+ *
+ * Input:           Engine state and time
+ *
+ * Output:          Bit id set for each alarm whose priority changed
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Values come once a beat, or once for the probe, so the
+ *                  delays and escalations also run here, as often as the
+ *                  caller can. The time from the end of a delay to the raise
+ *                  is at most the time between calls.
+ *
+ *                  A live value older than its alarm's stale time is
+ *                  replaced by the stale value on every call. HR low so
+ *                  sees a pulse that stops with the probe still on, where
+ *                  no beat would ever bring a low rate. The next valid
+ *                  value takes over again, and a beat noted with
+ *                  alarm_seen() holds the stale value off.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint8_t alarm_tick(alarm_engine_t *engine, uint32_t now_ms)
+{
+	uint8_t changed = 0;
+
+	for (uint8_t id = 0; id < ALARM_COUNT; id++)
+	{
+		alarm_state_t *alarm = &engine->alarm[id];
+		const alarm_config_t *config = &alarm_config[id];
+		bool change;
+
+		if (alarm->live && (config->stale_ms != 0u) && ((now_ms - alarm->seen_ms) >= config->stale_ms))
+		{
+			alarm->stale = true;
+			change = alarm_evaluate(engine, (alarm_id_t)id, config->stale_value, now_ms);
+		}
+		else
+		{
+			change = alarm_check(engine, (alarm_id_t)id, now_ms);
+		}
+		if (change)
+		{
+			changed |= (uint8_t)(1u << id);
+		}
+	}
+	return changed;
+} // alarm_tick()
+
+
+/*******************************************************************************
+ * Function:        alarm_priority_t alarm_highest(const alarm_engine_t *engine)
+ *
+ * PreCondition:    alarm_init() has been called
+ *
+ * Input:           Engine state
+ *
+ * Output:          Highest priority raised, ALARM_NONE if none
+ *
+ * Side Effects:    None
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+alarm_priority_t alarm_highest(const alarm_engine_t *engine)
+{
+	alarm_priority_t highest = ALARM_NONE;
+
+	for (uint8_t id = 0; id < ALARM_COUNT; id++)
+	{
+		if (engine->alarm[id].level > highest)
+		{
+			highest = engine->alarm[id].level;
+		}
+	}
+	return highest;
+} // alarm_highest()
+
+
+/*******************************************************************************
+ * Function:        bool alarm_led(const alarm_engine_t *engine, uint32_t now_ms)
+ *
+ * PreCondition:    alarm_init() has been called
+ *
+ * Input:           Engine state and time
+ *
+ * Output:          true to light LED0
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Flashes fast for a high priority alarm, slowly for a
+ *                  medium one and stays lit for a low one, after the visual
+ *                  alarm signals of IEC 60601-1-8.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+bool alarm_led(const alarm_engine_t *engine, uint32_t now_ms)
+{
+	switch (alarm_highest(engine))
+	{
+		case ALARM_HIGH:
+			return ((now_ms / ALARM_LED_HIGH_MS) & 1u) == 0u;
+
+		case ALARM_MEDIUM:
+			return ((now_ms / ALARM_LED_MEDIUM_MS) & 1u) == 0u;
+
+		case ALARM_LOW:
+			return true;
+
+		default:
+			return false;
+	}
+} // alarm_led()
+
+
+/*******************************************************************************
+ * Function:        char *alarm_name(alarm_id_t id)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Alarm
+ *
+ * Output:          Name of the alarm
+ *
+ * Side Effects:    None
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+char *alarm_name(alarm_id_t id)
+{
+	return alarm_config[id].name;
+} // alarm_name()
@@ -0,0 +1,151 @@
+#ifndef ALARM_H_
+#define ALARM_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Limits, in the units given to alarm_update(). An alarm is raised once its
+// condition has held for the delay, and clears when the value is back past
+// the limit by the hysteresis. A raised alarm that stays raised for the
+// escalation time goes up one priority (0 for never).
+#define ALARM_SPO2_LOW            (900)      // 0.1 %
+#define ALARM_SPO2_HYSTERESIS     (10)
+#define ALARM_SPO2_DELAY_MS       (10000u)
+#define ALARM_SPO2_ESCALATE_MS    (30000u)
+
+#define ALARM_HR_LOW              (400)      // 0.1 bpm
+#define ALARM_HR_HIGH             (1400)
+#define ALARM_HR_HYSTERESIS       (50)
+#define ALARM_HR_DELAY_MS         (10000u)
+#define ALARM_HR_ESCALATE_MS      (60000u)
+
+// With no beat for longer than a beat interval at the low limit the pulse
+// is taken as stopped, and HR low sees a value of 0 from then on. Beats the
+// SQI turns down count as beats here, see alarm_seen()
+#define ALARM_HR_STALE_MS         (600000u / ALARM_HR_LOW)
+
+#define ALARM_PI_LOW              (20)       // 0.01 %
+#define ALARM_PI_HYSTERESIS       (10)
+#define ALARM_PI_DELAY_MS         (15000u)
+
+#define ALARM_PROBE_DELAY_MS      (2000u)    // value 1 while the probe is off
+#define ALARM_PROBE_ESCALATE_MS   (60000u)
+
+// LED0 flash half periods: high priority 2 Hz, medium 0.5 Hz, low is steady
+#define ALARM_LED_HIGH_MS         (250u)
+#define ALARM_LED_MEDIUM_MS       (1000u)
+
+// Alarm conditions
+typedef enum
+{
+	ALARM_SPO2 = 0,
+	ALARM_HR_BRADY,
+	ALARM_HR_TACHY,
+	ALARM_PERFUSION,
+	ALARM_PROBE_OFF,
+	ALARM_COUNT
+} alarm_id_t;
+
+// Priorities, ALARM_NONE while not raised
+typedef enum
+{
+	ALARM_NONE = 0,
+	ALARM_LOW,
+	ALARM_MEDIUM,
+	ALARM_HIGH
+} alarm_priority_t;
+
+// One alarm
+typedef struct
+{
+	int32_t value;           // last value given
+	uint32_t onset_ms;       // when the condition started
+	uint32_t raised_ms;      // when the alarm was raised or escalated
+	uint32_t latency_ms;     // onset to raise of the last raise
+	uint32_t seen_ms;        // when the last valid value came
+	alarm_priority_t level;  // current priority
+	bool condition;          // past the limit, waiting for the delay
+	bool live;               // the last value was valid, so it can go stale
+	bool stale;              // the stale value stands in for the last one
+} alarm_state_t;
+
+// Engine state
+typedef struct
+{
+	alarm_state_t alarm[ALARM_COUNT];
+	uint32_t latency_max_ms; // worst onset to raise so far
+} alarm_engine_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def alarm_init
+ * \brief Clears every alarm
+ * \param engine (engine state)
+ */
+void alarm_init(alarm_engine_t *engine);
+
+
+/**
+ * \def alarm_update
+ * \brief Gives an alarm a new value, returns true if its priority changed
+ * \param engine (engine state)
+ * \param id (alarm)
+ * \param value (new value, see the limits for units)
+ * \param valid (false if there is no value, the condition onset is dropped)
+ * \param now_ms (time in ms)
+ */
+bool alarm_update(alarm_engine_t *engine, alarm_id_t id, int32_t value, bool valid, uint32_t now_ms);
+
+
+/**
+ * \def alarm_seen
+ * \brief Notes a value that was measured but not trusted, so it is neither evaluated nor stale
+ * \param engine (engine state)
+ * \param id (alarm)
+ * \param now_ms (time in ms)
+ */
+void alarm_seen(alarm_engine_t *engine, alarm_id_t id, uint32_t now_ms);
+
+
+/**
+ * \def alarm_tick
+ * \brief Runs the delays, escalations and stale values, returns a mask of alarms whose priority changed
+ * \param engine (engine state)
+ * \param now_ms (time in ms)
+ */
+uint8_t alarm_tick(alarm_engine_t *engine, uint32_t now_ms);
+
+
+/**
+ * \def alarm_highest
+ * \brief Returns the highest priority raised
+ * \param engine (engine state)
+ */
+alarm_priority_t alarm_highest(const alarm_engine_t *engine);
+
+
+/**
+ * \def alarm_led
+ * \brief Returns the LED0 state for the highest priority at this time
+ * \param engine (engine state)
+ * \param now_ms (time in ms)
+ */
+bool alarm_led(const alarm_engine_t *engine, uint32_t now_ms);
+
+
+/**
+ * \def alarm_name
+ * \brief Returns a short name for messages
+ * \param id (alarm)
+ */
+char *alarm_name(alarm_id_t id);
+
+
+#endif /* ALARM_H_ */
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "ambient.h"
+#include "led_seq.h"
+
+
+/*******************************************************************************
+ * Function:        void ambient_init(ambient_state_t *state)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Ambient state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function forgets the previous dark sample.
+ *
+ * Note:            Call it whenever the LED sequence is restarted
+ *
+ ******************************************************************************/
+void ambient_init(ambient_state_t *state)
+{
+	state->last_dark = 0;
+	state->primed = false;
+} // ambient_init()
+
+
+/*******************************************************************************
+ * Function:        void ambient_cancel_block(ambient_state_t *state,
+ *                                            const uint16_t *block,
+ *                                            uint16_t frames,
+ *                                            int32_t *red, int32_t *ir)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Block of interleaved red, IR, dark frames
+ *
+ * Output:          Ambient-free red and IR samples, one of each per frame
+ *
+ * Side Effects:    The last dark sample is kept for the next block
+ *
+ * Overview:        Within a frame the phases are evenly spaced, so relative
+ *                  to the dark sample of the previous frame (t = -1) and of
+ *                  this frame (t = 2) the red sample sits at t = 0 and the IR
+ *                  sample at t = 1. The ambient level under each lit sample
+ *                  is estimated by linear interpolation between the two dark
+ *                  samples and subtracted:
+ *
+ *                    red' = red - (d0 + 1/3 (d1 - d0))
+ *                    ir'  = ir  - (d0 + 2/3 (d1 - d0))
+ *
+ *                  This follows slow changes in room light, including most
+ *                  of the 100/120 Hz flicker at frame rates of a few hundred
+ *                  Hz, which a plain subtraction of one dark sample would not.
+ *
+ * Note:            Per frame this is one subtraction, two multiplies by a Q15
+ *                  constant and four add/shifts, no division. The first frame
+ *                  after ambient_init() uses its own dark sample for both ends.
+ *
+ ******************************************************************************/
+void ambient_cancel_block(ambient_state_t *state, const uint16_t *block, uint16_t frames,
+	int32_t *red, int32_t *ir)
+{
+	int32_t d0 = state->last_dark;
+
+	if (!state->primed && (frames != 0))
+	{
+		d0 = block[LED_SEQ_SLOT_DARK];
+		state->primed = true;
+	}
+
+	for (uint16_t i = 0; i < frames; i++)
+	{
+		int32_t d1 = block[LED_SEQ_SLOT_DARK];
+		int32_t step = d1 - d0;
+
+		red[i] = (int32_t)block[LED_SEQ_SLOT_RED] - d0 -
+			((step * AMBIENT_Q15_ONE_THIRD + (1 << 14)) >> 15);
+		ir[i] = (int32_t)block[LED_SEQ_SLOT_IR] - d0 -
+			((step * AMBIENT_Q15_TWO_THIRDS + (1 << 14)) >> 15);
+
+		d0 = d1;
+		block += LED_SEQ_PHASES;
+	}
+
+	state->last_dark = d0;
+} // ambient_cancel_block()
@@ -0,0 +1,47 @@
+#ifndef AMBIENT_H_
+#define AMBIENT_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Interpolation weights in Q15 (1/3 and 2/3 of a frame)
+#define AMBIENT_Q15_ONE_THIRD    (10923)
+#define AMBIENT_Q15_TWO_THIRDS   (21845)
+
+// Carries the last dark sample from one block to the next
+typedef struct
+{
+	int32_t last_dark;
+	bool primed;
+} ambient_state_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def ambient_init
+ * \brief Resets the ambient estimate, the next block starts from its own dark sample
+ * \param state (ambient state)
+ */
+void ambient_init(ambient_state_t *state);
+
+
+/**
+ * \def ambient_cancel_block
+ * \brief Subtracts the interpolated ambient level from the lit samples of a block
+ * \param state (ambient state)
+ * \param block (interleaved red, IR, dark frames)
+ * \param frames (number of frames in the block)
+ * \param red (output, frames ambient-free red samples)
+ * \param ir (output, frames ambient-free IR samples)
+ */
+void ambient_cancel_block(ambient_state_t *state, const uint16_t *block, uint16_t frames,
+	int32_t *red, int32_t *ir);
+
+
+#endif /* AMBIENT_H_ */
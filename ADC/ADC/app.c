@@ -11,8 +11,165 @@
 
 //Modules Being Used
 #include "adc.h"
+#include "adc_calib.h"
+#include "adc_dma.h"
+#include "led_seq.h"
+#include "ambient.h"
+#include "dc_track.h"
+#include "probe.h"
+#include "decim.h"
+#include "filter.h"
+#include "beat.h"
+#include "goertzel.h"
+#include "spo2.h"
+#include "spo2_cal.h"
+#include "sqi.h"
+#include "morph.h"
+#include "hrv.h"
+#include "resp.h"
+#include "trend.h"
+#include "desat.h"
+#include "alarm.h"
+#include "tick.h"
+#include "bench.h"
 #include "USART3.h"
 
+// Red / IR / dark frames per second set by TCC0. Kept well above the pulse
+// band so LED flicker and mains light fold onto the decimator nulls.
+#define APP_RAW_RATE_HZ        (800u)
+
+// Filters, beat detection and SpO2 run after CIC decimation
+#define APP_PULSE_RATE_HZ      (APP_RAW_RATE_HZ / DECIM_FACTOR)
+
+// HR and SpO2 are reported once a second
+#define APP_REPORT_SAMPLES     (APP_PULSE_RATE_HZ)
+
+// The band-pass tables are generated for one rate (ADC/tools/gen_filter.py)
+#if APP_PULSE_RATE_HZ != FILTER_SAMPLE_RATE_HZ
+#error "Regenerate filter_coeffs.c for APP_PULSE_RATE_HZ"
+#endif
+
+// Time from LED switch-on to the ADC trigger
+#define APP_LED_SETTLE_US      (200u)
+
+// Time constant of the reported red and IR baselines
+#define APP_DC_TAU_MS          (1000u)
+
+// Time constant of the baseline under the pulse shape, long enough that it
+// barely moves within a beat and the diastolic wave keeps its height
+#define APP_SHAPE_TAU_MS       (4000u)
+
+// Smallest pulse accepted as a beat, in 16-bit counts
+#define APP_BEAT_MIN_AMPLITUDE (32)
+
+// Window of the spectral heart rate, a new estimate every window
+#define APP_SPECTRAL_WINDOW_S  (8u)
+
+// Valid signal window for 16-bit results: below is an open probe, above is saturation
+#define APP_PROBE_LOWER        (64u)
+#define APP_PROBE_UPPER        (65000u)
+
+// Samples this close to the window edges count as clipped for the SQI
+#define APP_CLIP_MARGIN        (1024u)
+
+// Beats scoring less than this (%) are left out of the reported SpO2
+#define APP_SQI_MIN            (SQI_ACCEPT)
+
+// Pulse rate variability, the HR and SpO2 trends and the ODI are reported once a minute
+#define APP_HRV_REPORT_S       (60u)
+
+// Frames in one DMA block, and the decimated samples they give
+#define APP_BLOCK_FRAMES       (ADC_DMA_BLOCK_SIZE / LED_SEQ_PHASES)
+#define APP_PULSE_FRAMES       ((APP_BLOCK_FRAMES / DECIM_FACTOR) + 1u)
+
+// Decimated samples a block gives on average, the time a lost block takes
+#define APP_BLOCK_SAMPLES      (APP_BLOCK_FRAMES / DECIM_FACTOR)
+
+// Raw rate stage: ambient-free samples of the current block
+static int32_t app_red[APP_BLOCK_FRAMES];
+static int32_t app_ir[APP_BLOCK_FRAMES];
+static ambient_state_t app_ambient;
+static decim_t app_decim_red;
+static decim_t app_decim_ir;
+
+// Pulse rate stage: decimated samples of the current block
+static int32_t app_pulse_red[APP_PULSE_FRAMES];
+static int32_t app_pulse_ir[APP_PULSE_FRAMES];
+static dc_track_t app_dc_red;
+static dc_track_t app_dc_ir;
+static filter_bandpass_t app_pulse;
+static beat_state_t app_beat;
+static goertzel_t app_spectral;
+static spo2_state_t app_spo2;
+static sqi_state_t app_sqi;
+static morph_state_t app_morph;
+static hrv_state_t app_hrv;
+static resp_state_t app_resp;
+static trend_t app_trend_hr;
+static trend_t app_trend_spo2;
+static desat_state_t app_desat;
+
+// Shape for morph, and whether the beat it reports next passed the SQI
+static dc_track_t app_dc_shape;
+static filter_fir_t app_shape;
+static bool app_morph_accepted;
+
+// Time of the next whole second while the probe is off
+static uint32_t app_gap_ms;
+
+// Alarms span pipeline resets, a probe off is one of them
+static alarm_engine_t app_alarm;
+static alarm_priority_t app_alarm_level[ALARM_COUNT];
+static uint8_t app_alarm_changed;
+
+// Report stage: what happened since the last report
+static uint16_t app_report_count;
+static uint16_t app_report_beats;
+static uint32_t app_report_intervals;
+static uint16_t app_report_latency;
+static uint32_t app_report_sqi;
+static uint16_t app_report_rejected;
+static uint32_t app_report_spo2_sum;
+static uint32_t app_report_spo2_weight;
+static bool app_report_morph;
+
+// One closed second of the report line, for the main loop to write
+typedef struct
+{
+	uint16_t bpm_x10;        // mean heart rate over the second's beats
+	uint16_t latency_ms;     // worst beat detection latency
+	uint8_t sqi;             // mean beat SQI
+	uint16_t rejected;       // beats under APP_SQI_MIN
+	uint16_t spo2_x10;       // SQI weighted SpO2 of the second's beats
+	bool hr;                 // beats were timed
+	bool spo2;               // beats gave SpO2
+	bool morph;              // a beat's shape was measured
+} app_report_line_t;
+
+// Report stage: closed on the sample path, written from the main loop so
+// the UART never holds up a block
+static app_report_line_t app_report_line;
+static bool app_report_line_due;
+static bool app_report_desat_due;
+static bool app_report_minute_due;
+static uint8_t app_report_seconds;
+
+// DMA blocks lost so far, as last seen
+static uint32_t app_dma_overruns;
+
+// Custom SpO2 curve arriving over the serial port
+typedef struct
+{
+	uint16_t points[SPO2_CAL_POINTS];
+	uint16_t value;          // point being received
+	uint8_t count;           // points complete
+	bool digits;             // value has a digit
+	bool bad;                // the line is rejected at its end
+	bool active;             // a 'C' line is being received
+} app_curve_rx_t;
+
+static app_curve_rx_t app_curve;
+
 /*******************************************************************************
  * Function:        void AppInit(void)
  *
@@ -48,6 +205,865 @@ void AppInit(void)
 
 } // AppInit()
 
+/*******************************************************************************
+ * Function:        static void app_pipeline_reset(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the per-sample and per-beat stages, used at start,
+ *                  when a finger is put back and after lost DMA blocks, so
+ *                  no filter or beat state spans the gap. The HRV windows,
+ *                  the trends and the ODI keep their history, the gap only
+ *                  breaks the run of successive differences.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_pipeline_reset(void)
+{
+	ambient_init(&app_ambient);
+	decim_init(&app_decim_red);
+	decim_init(&app_decim_ir);
+
+	dc_track_init(&app_dc_red, APP_PULSE_RATE_HZ, APP_DC_TAU_MS);
+	dc_track_init(&app_dc_ir, APP_PULSE_RATE_HZ, APP_DC_TAU_MS);
+	dc_track_init(&app_dc_shape, APP_PULSE_RATE_HZ, APP_SHAPE_TAU_MS);
+	filter_bandpass_init(&app_pulse);
+	filter_fir_init(&app_shape);
+	beat_init(&app_beat, APP_PULSE_RATE_HZ, APP_BEAT_MIN_AMPLITUDE);
+	goertzel_init(&app_spectral, APP_SPECTRAL_WINDOW_S);
+	spo2_init(&app_spo2, APP_PULSE_RATE_HZ);
+	sqi_init(&app_sqi, APP_PULSE_RATE_HZ);
+	morph_init(&app_morph, APP_PULSE_RATE_HZ, FILTER_FIR_DELAY);
+	app_morph_accepted = false;
+	hrv_gap(&app_hrv);
+	resp_init(&app_resp);
+
+	app_report_count = 0;
+	app_report_beats = 0;
+	app_report_intervals = 0;
+	app_report_latency = 0;
+	app_report_sqi = 0;
+	app_report_rejected = 0;
+	app_report_spo2_sum = 0;
+	app_report_spo2_weight = 0;
+	app_report_morph = false;
+} // app_pipeline_reset()
+
+
+/*******************************************************************************
+ * Function:        static void app_write_x10(uint32_t value)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           Value in tenths
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Writes the value with one decimal.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_write_x10(uint32_t value)
+{
+	char buffer[12];
+
+	UART3_Write_Text(utoa(value / 10u, buffer, 10));
+	UART3_Write_Text(".");
+	UART3_Write_Text(utoa(value % 10u, buffer, 10));
+} // app_write_x10()
+
+
+/*******************************************************************************
+ * Function:        static void app_report_hrv(void)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        One line per rolling window with SDNN, RMSSD, pNN50 and
+ *                  the number of intervals. Windows with fewer than two
+ *                  intervals are skipped.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_report_hrv(void)
+{
+	static const uint8_t minutes[HRV_WINDOW_COUNT] = { 1, 5, 60 };
+	char buffer[8];
+
+	for (uint8_t w = 0; w < HRV_WINDOW_COUNT; w++) {
+		hrv_result_t result;
+
+		if (!hrv_result(&app_hrv, (hrv_window_t)w, &result)) {
+			continue;
+		}
+		UART3_Write_Text("HRV ");
+		UART3_Write_Text(utoa(minutes[w], buffer, 10));
+		UART3_Write_Text(" min: SDNN ");
+		app_write_x10(result.sdnn_x10);
+		UART3_Write_Text(" ms RMSSD ");
+		app_write_x10(result.rmssd_x10);
+		UART3_Write_Text(" ms pNN50 ");
+		app_write_x10(result.pnn50_x10);
+		UART3_Write_Text(" % (");
+		UART3_Write_Text(utoa(result.count, buffer, 10));
+		UART3_Write_Text(" beats)\r\n");
+	}
+} // app_report_hrv()
+
+
+/*******************************************************************************
+ * Function:        static void app_report_trends(void)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        One line per trend with min / mean / max of each horizon
+ *                  that holds a value.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_report_trends(void)
+{
+	static char *const labels[TREND_HORIZONS] = { " 1m ", " 15m ", " 1h ", " 8h " };
+	const trend_t *trends[2] = { &app_trend_hr, &app_trend_spo2 };
+
+	for (uint8_t t = 0; t < 2u; t++) {
+		UART3_Write_Text((t == 0u) ? "Trend HR:" : "Trend SpO2:");
+		for (uint8_t h = 0; h < TREND_HORIZONS; h++) {
+			trend_result_t result;
+
+			if (!trend_result(trends[t], (trend_horizon_t)h, &result)) {
+				continue;
+			}
+			UART3_Write_Text(labels[h]);
+			app_write_x10((uint16_t)result.min);
+			UART3_Write_Text("/");
+			app_write_x10((uint16_t)result.mean);
+			UART3_Write_Text("/");
+			app_write_x10((uint16_t)result.max);
+		}
+		UART3_Write_Text("\r\n");
+	}
+
+	desat_summary_t summary;
+	if (desat_summary(&app_desat, &summary)) {
+		UART3_Write_Text("ODI3: ");
+		app_write_x10(summary.odi3_x10);
+		UART3_Write_Text(" /h ODI4: ");
+		app_write_x10(summary.odi4_x10);
+		UART3_Write_Text(" /h Burden: ");
+		app_write_x10(summary.burden_x10);
+		UART3_Write_Text(" %min/h\r\n");
+	}
+} // app_report_trends()
+
+
+/*******************************************************************************
+ * Function:        static void app_report_desat(void)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        One line for the desaturation just reported: baseline
+ *                  and nadir SpO2, duration and time from onset to nadir.
+ *                  An event reported at DESAT_MAX_S is marked ongoing.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_report_desat(void)
+{
+	const desat_event_t *event = &app_desat.last;
+	char buffer[12];
+
+	UART3_Write_Text("Desat: ");
+	app_write_x10(event->baseline_x10);
+	UART3_Write_Text(" -> ");
+	app_write_x10(event->nadir_x10);
+	UART3_Write_Text(" %, ");
+	UART3_Write_Text(utoa(event->duration_s, buffer, 10));
+	UART3_Write_Text(" s, nadir +");
+	UART3_Write_Text(utoa(event->nadir_s - event->start_s, buffer, 10));
+	UART3_Write_Text(" s");
+	if (!event->recovered) {
+		UART3_Write_Text(" (ongoing)");
+	}
+	UART3_Write_Text("\r\n");
+} // app_report_desat()
+
+
+/*******************************************************************************
+ * Function:        static void app_statistics_second(uint16_t bpm_x10, bool hr,
+ *                                                    uint16_t spo2_x10, bool spo2)
+ *
+ * PreCondition:    None
+ *
+ * Input:           The second's heart rate and SpO2, and whether each is
+ *                  valid
+ *
+ * Output:          None
+ *
+ * Side Effects:    Flags the desaturation and minute reports for app_report()
+ *
+ * Overview:        Moves the HRV windows, the trends and the desaturation
+ *                  detector on by one second, and counts the minute for the
+ *                  pulse rate variability, trend and ODI report.
+ *
+ * Note:            Runs on the sample path, so writes nothing
+ *
+ ******************************************************************************/
+static void app_statistics_second(uint16_t bpm_x10, bool hr, uint16_t spo2_x10, bool spo2)
+{
+	hrv_second(&app_hrv);
+	trend_second(&app_trend_hr, (int16_t)bpm_x10, hr);
+	trend_second(&app_trend_spo2, (int16_t)spo2_x10, spo2);
+	if (desat_second(&app_desat, spo2_x10, spo2)) {
+		app_report_desat_due = true;
+	}
+	if (++app_report_seconds >= APP_HRV_REPORT_S) {
+		app_report_seconds = 0;
+		app_report_minute_due = true;
+	}
+} // app_statistics_second()
+
+
+/*******************************************************************************
+ * Function:        static void app_report_close(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    Report accumulators are cleared
+ *
+ * Overview:        Ends a second of the pulse stage: the mean heart rate
+ *                  over its beats, the worst beat detection latency, the
+ *                  mean SQI and the SpO2 of its beats weighted by their SQI
+ *                  are kept for app_report(), then the second goes to the
+ *                  long horizon statistics.
+ *
+ * Note:            The heart rate, latency, SQI and SpO2 divisions run once a
+ *                  second
+ *
+ ******************************************************************************/
+static void app_report_close(void)
+{
+	app_report_line_t *line = &app_report_line;
+
+	*line = (app_report_line_t){ 0 };
+	line->hr = (app_report_beats != 0);
+	if (line->hr) {
+		line->bpm_x10 = (uint16_t)((600u * APP_PULSE_RATE_HZ * app_report_beats) / app_report_intervals);
+		line->latency_ms = (uint16_t)((1000u * app_report_latency) / APP_PULSE_RATE_HZ);
+		line->sqi = (uint8_t)(app_report_sqi / app_report_beats);
+		line->rejected = app_report_rejected;
+	}
+	line->spo2 = (app_report_spo2_weight != 0);
+	if (line->spo2) {
+		line->spo2_x10 = (uint16_t)((app_report_spo2_sum + (app_report_spo2_weight / 2u)) / app_report_spo2_weight);
+	}
+	line->morph = app_report_morph;
+	app_report_line_due = true;
+
+	app_statistics_second(line->bpm_x10, line->hr, line->spo2_x10, line->spo2);
+
+	app_report_beats = 0;
+	app_report_intervals = 0;
+	app_report_latency = 0;
+	app_report_sqi = 0;
+	app_report_rejected = 0;
+	app_report_spo2_sum = 0;
+	app_report_spo2_weight = 0;
+	app_report_morph = false;
+} // app_report_close()
+
+
+/*******************************************************************************
+ * Function:        static void app_report_write_line(void)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        One line for the last closed second: baselines, heart
+ *                  rate, latency, SQI and beats it rejected, the spectral heart rate of the
+ *                  last window, SpO2, the respiratory rate and the pulse
+ *                  shape features of the last complete beat.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_report_write_line(void)
+{
+	const app_report_line_t *line = &app_report_line;
+	char buffer[12];
+
+	UART3_Write_Text("Red: ");
+	UART3_Write_Text(itoa(dc_track_value(&app_dc_red), buffer, 10));
+	UART3_Write_Text(" IR: ");
+	UART3_Write_Text(itoa(dc_track_value(&app_dc_ir), buffer, 10));
+
+	if (line->hr) {
+		UART3_Write_Text(" HR: ");
+		UART3_Write_Text(utoa(line->bpm_x10 / 10u, buffer, 10));
+		UART3_Write_Text(" bpm, latency ");
+		UART3_Write_Text(utoa(line->latency_ms, buffer, 10));
+		UART3_Write_Text(" ms, SQI ");
+		UART3_Write_Text(utoa(line->sqi, buffer, 10));
+		if (line->rejected != 0) {
+			UART3_Write_Text(", ");
+			UART3_Write_Text(utoa(line->rejected, buffer, 10));
+			UART3_Write_Text(" rejected");
+		}
+	}
+
+	if (app_spectral.valid) {
+		UART3_Write_Text(" Spectral HR: ");
+		UART3_Write_Text(utoa(app_spectral.bpm_x10 / 10u, buffer, 10));
+		UART3_Write_Text(".");
+		UART3_Write_Text(utoa(app_spectral.bpm_x10 % 10u, buffer, 10));
+		UART3_Write_Text(" bpm (");
+		UART3_Write_Text(utoa(app_spectral.purity, buffer, 10));
+		UART3_Write_Text(" %)");
+	}
+
+	if (line->spo2) {
+		UART3_Write_Text(" SpO2: ");
+		app_write_x10(line->spo2_x10);
+		UART3_Write_Text(" %");
+	}
+
+	if (app_resp.valid) {
+		UART3_Write_Text(" Resp: ");
+		app_write_x10(app_resp.brpm_x10);
+		UART3_Write_Text(" /min (");
+		UART3_Write_Text(utoa(app_resp.quality, buffer, 10));
+		UART3_Write_Text(" %)");
+	}
+
+	if (line->morph) {
+		const morph_features_t *f = &app_morph.last;
+
+		UART3_Write_Text(" PI: ");
+		UART3_Write_Text(utoa(f->pi_x100 / 100u, buffer, 10));
+		UART3_Write_Text(".");
+		if ((f->pi_x100 % 100u) < 10u) {
+			UART3_Write_Text("0");
+		}
+		UART3_Write_Text(utoa(f->pi_x100 % 100u, buffer, 10));
+		UART3_Write_Text(" % Rise: ");
+		UART3_Write_Text(utoa(f->rise_ms, buffer, 10));
+		UART3_Write_Text(" ms Width: ");
+		UART3_Write_Text(utoa(f->width_ms, buffer, 10));
+		UART3_Write_Text(" ms");
+		if (f->notch) {
+			UART3_Write_Text(" Notch: ");
+			UART3_Write_Text(utoa(f->notch_ms, buffer, 10));
+			UART3_Write_Text(" ms RI: ");
+			UART3_Write_Text(utoa(f->ri_pct, buffer, 10));
+			UART3_Write_Text(" %");
+		}
+	}
+	UART3_Write_Text("\r\n");
+} // app_report_write_line()
+
+
+/*******************************************************************************
+ * Function:        static void app_report(void)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Report stage, from the main loop: the line of each second
+ *                  the pulse stage closed, a line for each desaturation when
+ *                  it is detected, and the pulse rate variability, the HR
+ *                  and SpO2 trends and the ODI once a minute. The text goes
+ *                  to the UART queue, which holds the longest burst, so
+ *                  writing it takes well under one block.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_report(void)
+{
+	if (app_report_line_due) {
+		app_report_line_due = false;
+		app_report_write_line();
+	}
+	if (app_report_desat_due) {
+		app_report_desat_due = false;
+		app_report_desat();
+	}
+	if (app_report_minute_due) {
+		app_report_minute_due = false;
+		app_report_hrv();
+		app_report_trends();
+	}
+} // app_report()
+
+
+/*******************************************************************************
+ * Function:        static void app_gap_seconds(void)
+ *
+ * PreCondition:    tick_init() has been called, app_gap_ms set when the
+ *                  probe went off
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        With the probe off no samples count the seconds, so the
+ *                  millisecond tick does. Each second passed moves the HRV
+ *                  windows on with no beats, and the trends and the
+ *                  desaturation detector on with no value, so their times
+ *                  stay right across the gap. Seconds without SpO2 are left
+ *                  out of the ODI hours. The minute report carries on.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_gap_seconds(void)
+{
+	while ((tick_ms() - app_gap_ms) >= 1000u) {
+		app_gap_ms += 1000u;
+		app_statistics_second(0, false, 0, false);
+	}
+} // app_gap_seconds()
+
+
+/*******************************************************************************
+ * Function:        static void app_alarm_input(alarm_id_t id, int32_t value, bool valid)
+ *
+ * PreCondition:    tick_init() has been called
+ *
+ * Input:           Alarm, new value and whether it is valid
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Passes the value on at the current time and notes a
+ *                  change for app_alarm_service().
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_alarm_input(alarm_id_t id, int32_t value, bool valid)
+{
+	if (alarm_update(&app_alarm, id, value, valid, tick_ms())) {
+		app_alarm_changed |= (uint8_t)(1u << id);
+	}
+} // app_alarm_input()
+
+
+/*******************************************************************************
+ * Function:        static void app_alarm_service(void)
+ *
+ * PreCondition:    UART3_Init() and tick_init() have been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    LED0 is driven
+ *
+ * Overview:        Runs the alarm delays, then announces every alarm that
+ *                  was raised, escalated or cleared with a priority message,
+ *                  which goes out ahead of any queued report text. A raise
+ *                  carries the time from the condition's onset. LED0 shows
+ *                  the highest priority raised.
+ *
+ * Note:            Called on every pass of the main loop, so the time from a
+ *                  delay ending to the message is at most one pass plus one
+ *                  UART character
+ *
+ ******************************************************************************/
+static void app_alarm_service(void)
+{
+	uint32_t now = tick_ms();
+	uint8_t changed = app_alarm_changed | alarm_tick(&app_alarm, now);
+	app_alarm_changed = 0;
+
+	for (uint8_t id = 0; id < ALARM_COUNT; id++) {
+		if (!(changed & (1u << id))) {
+			continue;
+		}
+
+		const alarm_state_t *alarm = &app_alarm.alarm[id];
+		static char *const levels[] = { "NONE", "LOW", "MEDIUM", "HIGH" };
+		char buffer[12];
+
+		if (alarm->level == ALARM_NONE) {
+			UART3_Write_Priority_Text("\r\n!CLEAR ");
+			UART3_Write_Priority_Text(alarm_name((alarm_id_t)id));
+		} else {
+			UART3_Write_Priority_Text("\r\n!ALARM ");
+			UART3_Write_Priority_Text(levels[alarm->level]);
+			UART3_Write_Priority_Text(" ");
+			UART3_Write_Priority_Text(alarm_name((alarm_id_t)id));
+			if (app_alarm_level[id] == ALARM_NONE) {
+				UART3_Write_Priority_Text(", +");
+				UART3_Write_Priority_Text(utoa(alarm->latency_ms, buffer, 10));
+				UART3_Write_Priority_Text(" ms");
+			}
+		}
+		UART3_Write_Priority_Text("\r\n");
+		app_alarm_level[id] = alarm->level;
+	}
+
+	if (alarm_led(&app_alarm, now)) {
+		REG_PORT_OUTSET0 = LED0_PIN_MASK;
+	} else {
+		REG_PORT_OUTCLR0 = LED0_PIN_MASK;
+	}
+} // app_alarm_service()
+
+
+/*******************************************************************************
+ * Function:        static void app_curve_receive(char c)
+ *
+ * PreCondition:    UART3_Init() has been called, a 'C' has started the line
+ *
+ * Input:           Character received on UART3
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Collects the SPO2_CAL_POINTS values of a 'C' line, SpO2
+ *                  in 0.1 % at R = 0, 1/8 ... 2.0, split by commas or spaces:
+ *
+ *                      C1000,1000,1000,975,944,...,600
+ *
+ *                  At CR or LF a complete line is loaded with
+ *                  spo2_cal_set_custom() and selected. A wrong count, a
+ *                  value over SPO2_CAL_MAX or any other character rejects
+ *                  the whole line and leaves the curve in use.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_curve_receive(char c)
+{
+	if ((c >= '0') && (c <= '9')) {
+		app_curve.value = (uint16_t)((app_curve.value * 10u) + (uint16_t)(c - '0'));
+		app_curve.digits = true;
+		app_curve.bad |= (app_curve.value > SPO2_CAL_MAX);
+		if (app_curve.bad) {
+			app_curve.value = 0;
+		}
+		return;
+	}
+
+	if (app_curve.digits) {
+		// A point past the last one makes the line too long, however long
+		if (app_curve.count < SPO2_CAL_POINTS) {
+			app_curve.points[app_curve.count++] = app_curve.value;
+		} else {
+			app_curve.bad = true;
+		}
+		app_curve.value = 0;
+		app_curve.digits = false;
+	}
+
+	if ((c == ',') || (c == ' ')) {
+		return;
+	}
+	if ((c != '\r') && (c != '\n')) {
+		app_curve.bad = true;
+		return;
+	}
+
+	char buffer[4];
+	app_curve.active = false;
+	if (app_curve.bad || (app_curve.count != SPO2_CAL_POINTS) || !spo2_cal_set_custom(app_curve.points)) {
+		UART3_Write_Text("SpO2 curve rejected, need ");
+		UART3_Write_Text(utoa(SPO2_CAL_POINTS, buffer, 10));
+		UART3_Write_Text(" points of 0-1000\r\n");
+		return;
+	}
+
+	spo2_cal_select(SPO2_CAL_CUSTOM);
+	UART3_Write_Text("SpO2 curve: ");
+	UART3_Write_Text(utoa(spo2_cal_selected(), buffer, 10));
+	UART3_Write_Text("\r\n");
+} // app_curve_receive()
+
+
+/*******************************************************************************
+ * Function:        static void app_command(char command)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           Character received on UART3
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        '0', '1' ... select the SpO2 calibration curve with that
+ *                  spo2_cal_curve_t number, so a probe or skin tone profile
+ *                  can be changed without rebuilding. 'C' starts a line
+ *                  loading the custom curve, see app_curve_receive(). Other
+ *                  characters are ignored.
+ *
+ * Note:            Selecting the custom curve before one is loaded says so
+ *                  and keeps the curve in use
+ *
+ ******************************************************************************/
+static void app_command(char command)
+{
+	if (app_curve.active) {
+		app_curve_receive(command);
+		return;
+	}
+	if ((command == 'C') || (command == 'c')) {
+		app_curve = (app_curve_rx_t){ 0 };
+		app_curve.active = true;
+		return;
+	}
+	if ((command < '0') || (command >= ('0' + SPO2_CAL_COUNT))) {
+		return;
+	}
+
+	spo2_cal_select((spo2_cal_curve_t)(command - '0'));
+
+	char buffer[4];
+	if (spo2_cal_selected() != (spo2_cal_curve_t)(command - '0')) {
+		UART3_Write_Text("SpO2 curve ");
+		UART3_Write_Text(utoa((uint32_t)(command - '0'), buffer, 10));
+		UART3_Write_Text(" not loaded, send C and its points first\r\n");
+	}
+	UART3_Write_Text("SpO2 curve: ");
+	UART3_Write_Text(utoa(spo2_cal_selected(), buffer, 10));
+	UART3_Write_Text("\r\n");
+} // app_command()
+
+
+/*******************************************************************************
+ * Function:        static void app_pulse_block(uint16_t count)
+ *
+ * PreCondition:    app_pipeline_reset() has been called
+ *
+ * Input:           Number of decimated samples in app_pulse_red/app_pulse_ir
+ *
+ * Output:          None
+ *
+ * Side Effects:    Closes a report second every APP_REPORT_SAMPLES samples
+ *
+ * Overview:        Pulse stage at APP_PULSE_RATE_HZ. Tracks the baselines,
+ *                  band-passes the IR pulse, finds beats on it and closes an
+ *                  SpO2 beat on each. Each beat is scored by the SQI, and its
+ *                  SpO2 is weighted by the score or dropped below
+ *                  APP_SQI_MIN, so motion does not read as a desaturation.
+ *                  The pulse shape of each beat is measured one beat later,
+ *                  on the IR over a slower baseline and low-passed only.
+ *                  Intervals of accepted beats feed the HRV windows, any
+ *                  other beat breaks the run of successive differences.
+ *                  Every timed beat adds its baseline, amplitude and interval
+ *                  to the respiratory rate series, which run at beat rate.
+ *                  Accepted beats give the alarms their HR, SpO2 and
+ *                  perfusion values. Other beats only show that there is a
+ *                  pulse, so motion cannot read as one that stopped. If
+ *                  beats stop, HR low goes stale in alarm_tick() and sees
+ *                  no pulse.
+ *                  The same pulse feeds the Goertzel bank,
+ *                  which holds its rate through motion that upsets the beat
+ *                  detector. Less IR light reaches the detector at
+ *                  systole, so the pulse is the inverted IR signal, taken
+ *                  about its baseline to fit 16 bits.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_pulse_block(uint16_t count)
+{
+	dc_track_block(&app_dc_red, app_pulse_red, count);
+	dc_track_block(&app_dc_ir, app_pulse_ir, count);
+	dc_track_block(&app_dc_shape, app_pulse_ir, count);
+
+	int32_t red_dc = dc_track_value(&app_dc_red);
+	int32_t ir_dc = dc_track_value(&app_dc_ir);
+	int32_t shape_dc = dc_track_value(&app_dc_shape);
+	for (uint16_t i = 0; i < count; i++) {
+		beat_event_t event;
+		int16_t x = filter_bandpass(&app_pulse, fixmath_sat16(ir_dc - app_pulse_ir[i]));
+
+		// The band-pass moves the foot into its undershoot, the shape is low-passed only
+		goertzel_push(&app_spectral, x);
+		if (morph_push(&app_morph, filter_fir(&app_shape, fixmath_sat16(shape_dc - app_pulse_ir[i])),
+			app_pulse_ir[i])) {
+			app_report_morph = true;
+			app_alarm_input(ALARM_PERFUSION, app_morph.last.pi_x100, app_morph_accepted);
+		}
+
+		if (beat_push(&app_beat, x, &event)) {
+			uint8_t score = sqi_beat(&app_sqi, &event);
+
+			morph_beat(&app_morph, &event);
+			app_morph_accepted = (score >= APP_SQI_MIN);
+
+			if (event.interval != 0) {
+				uint16_t interval_ms = (uint16_t)((1000u * event.interval) / APP_PULSE_RATE_HZ);
+				bool accepted = (score >= APP_SQI_MIN);
+
+				app_report_beats++;
+				app_report_intervals += event.interval;
+				app_report_sqi += score;
+
+				if (accepted) {
+					hrv_add(&app_hrv, interval_ms);
+					app_alarm_input(ALARM_HR_BRADY, 600000l / interval_ms, true);
+					app_alarm_input(ALARM_HR_TACHY, 600000l / interval_ms, true);
+				} else {
+					app_report_rejected++;
+					hrv_gap(&app_hrv);
+					alarm_seen(&app_alarm, ALARM_HR_BRADY, tick_ms());
+				}
+				resp_beat(&app_resp, ir_dc, event.amplitude, interval_ms, accepted);
+			} else {
+				hrv_gap(&app_hrv);
+				alarm_seen(&app_alarm, ALARM_HR_BRADY, tick_ms());
+			}
+			if (event.latency > app_report_latency) {
+				app_report_latency = event.latency;
+			}
+			if (spo2_beat(&app_spo2) && (score >= APP_SQI_MIN)) {
+				app_report_spo2_sum += (uint32_t)app_spo2.spo2 * score;
+				app_report_spo2_weight += score;
+				app_alarm_input(ALARM_SPO2, app_spo2.spo2, true);
+			}
+		}
+		spo2_push(&app_spo2, app_pulse_red[i], app_pulse_ir[i]);
+
+		bool clipped = (app_pulse_red[i] < (int32_t)(APP_PROBE_LOWER + APP_CLIP_MARGIN)) ||
+			(app_pulse_red[i] > (int32_t)(APP_PROBE_UPPER - APP_CLIP_MARGIN)) ||
+			(app_pulse_ir[i] < (int32_t)(APP_PROBE_LOWER + APP_CLIP_MARGIN)) ||
+			(app_pulse_ir[i] > (int32_t)(APP_PROBE_UPPER - APP_CLIP_MARGIN));
+		sqi_push(&app_sqi, x, fixmath_sat16(app_pulse_red[i] - red_dc),
+			fixmath_sat16(app_pulse_ir[i] - ir_dc), clipped);
+
+		if (++app_report_count >= APP_REPORT_SAMPLES) {
+			app_report_count = 0;
+			app_report_close();
+		}
+	}
+} // app_pulse_block()
+
+
+/*******************************************************************************
+ * Function:        static void app_overrun(uint32_t lost)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           Number of DMA blocks written over before they were read
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        A lost block is a jump in every sample counted time base:
+ *                  beat intervals, the Goertzel window and the respiratory
+ *                  span. The pulse stages restart as after a probe gap, and
+ *                  the samples the lost blocks would have given still count
+ *                  towards the report seconds, so the HRV windows, trends
+ *                  and desaturation times keep in step with real time.
+ *                  Seconds lost in full go to the statistics as invalid.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_overrun(uint32_t lost)
+{
+	char buffer[12];
+	uint32_t count = app_report_count + (lost * APP_BLOCK_SAMPLES);
+
+	UART3_Write_Text("DMA overrun, ");
+	UART3_Write_Text(utoa(lost, buffer, 10));
+	UART3_Write_Text(" blocks lost.\r\n");
+
+	app_pipeline_reset();
+	while (count >= APP_REPORT_SAMPLES) {
+		count -= APP_REPORT_SAMPLES;
+		app_report_close();
+	}
+	app_report_count = (uint16_t)count;
+} // app_overrun()
+
+
+/*******************************************************************************
+ * Function:        static void app_raw_block(const uint16_t *block)
+ *
+ * PreCondition:    app_pipeline_reset() has been called
+ *
+ * Input:           Interleaved red, IR, dark block from the DMAC
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Raw stage at APP_RAW_RATE_HZ. Removes room light using
+ *                  each frame's dark sample, then decimates red and IR by
+ *                  DECIM_FACTOR and hands the result to the pulse stage.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void app_raw_block(const uint16_t *block)
+{
+	uint16_t frames = adc_dma_block_length() / LED_SEQ_PHASES;
+
+	ambient_cancel_block(&app_ambient, block, frames, app_red, app_ir);
+
+	uint16_t count = decim_block(&app_decim_red, app_red, frames, app_pulse_red);
+	decim_block(&app_decim_ir, app_ir, frames, app_pulse_ir);
+
+	if (count != 0) {
+		app_pulse_block(count);
+	}
+} // app_raw_block()
+
+
 /*******************************************************************************
  * Function:        void AppRun(void)
  *
@@ -74,33 +1090,117 @@ void AppRun(void)
 	// Debug message to indicate initialization is complete
 	UART3_Write_Text("UART Initialized successfully at 9600 baud.\r\n");
 
+#ifdef APP_RUN_BENCHMARKS
+	// Cycle cost of the signal processing on synthetic data
+	bench_run();
+#endif
+
 	// Initialize the ADC
 	adc_init();
 	delay_ms(100);
 	UART3_Write_Text("ADC Initialized successfully.\r\n");
 
-	// Variable to store the result of ADC conversion
-	int result;
+	// Gain/offset correction from flash, measured once on the first boot
+	if (adc_calib_load())
+	{
+		UART3_Write_Text("ADC calibration loaded.\r\n");
+	}
+	else if (adc_calib_run())
+	{
+		adc_calib_save();
+		UART3_Write_Text("ADC calibration measured and saved.\r\n");
+	}
+	else
+	{
+		UART3_Write_Text("ADC calibration failed, running uncorrected.\r\n");
+	}
+
+	// 16-bit results at the raw frame rate, three conversions per frame
+	adc_set_profile(ADC_PROFILE_AVERAGED_16BIT);
+
+	// Ambient, decimator, filter, beat and SpO2 state, then the statistics
+	// that span probe gaps
+	app_pipeline_reset();
+	hrv_init(&app_hrv);
+	trend_init(&app_trend_hr);
+	trend_init(&app_trend_spo2);
+	desat_init(&app_desat);
+
+	// Sample A0 once in each red, IR and dark phase, drained by the DMAC
+	adc_scan_init(ADC_CHANNEL_A0, 1);
+	adc_dma_init(LED_SEQ_PHASES);
+	led_seq_init(APP_RAW_RATE_HZ, APP_LED_SETTLE_US);
+	adc_dma_start();
+	led_seq_start();
+	UART3_Write_Text("LED sequencer and ADC DMA acquisition started.\r\n");
+
+	// Let the window monitor watch for finger-off and saturation
+	probe_init(APP_PROBE_LOWER, APP_PROBE_UPPER, APP_RAW_RATE_HZ);
+
+	// Millisecond time for the alarm delays, which must run with the probe off
+	tick_init();
+	alarm_init(&app_alarm);
+	for (uint8_t id = 0; id < ALARM_COUNT; id++) {
+		app_alarm_level[id] = ALARM_NONE;
+	}
+	app_alarm_changed = 0;
 
 	while(1)
 	{
-		// Read the ADC channel connected to A0
-		result = adc_readchannel(19); // A0 on the MKR Zero is connected to ADC channel 19 (PA11)
+		// Raise, escalate and clear alarms, drive LED0
+		app_alarm_service();
+
+		// Write what the pulse stage closed, off the sample path
+		app_report();
+
+		// Calibration curve selection and loading over the serial port
+		if (UART3_Has_Data()) {
+			app_command(UART3_Read());
+		}
+
+		// Switch between full rate and low rate probing
+		switch (probe_update()) {
+			case PROBE_EVENT_LOST:
+				UART3_Write_Text("Probe off, waiting for finger.\r\n");
+				app_gap_ms = tick_ms();
+				app_alarm_input(ALARM_PROBE_OFF, 1, true);
+				app_alarm_input(ALARM_SPO2, 0, false);
+				app_alarm_input(ALARM_HR_BRADY, 0, false);
+				app_alarm_input(ALARM_HR_TACHY, 0, false);
+				app_alarm_input(ALARM_PERFUSION, 0, false);
+				break;
 
-		// Check if the result is greater than zero before printing
-		if (result >= 0) {
-			// Convert the ADC result to a string
-			char buffer[10];
-			itoa(result, buffer, 10);
+			case PROBE_EVENT_FOUND:
+				app_pipeline_reset();
+				app_dma_overruns = 0;
+				UART3_Write_Text("Finger detected.\r\n");
+				app_alarm_input(ALARM_PROBE_OFF, 0, true);
+				break;
+
+			default:
+				break;
+		}
+
+		// Keep the long horizon statistics in time while the probe is off
+		if (!probe_active()) {
+			app_gap_seconds();
+		}
+
+		// Wait for the DMAC to fill a half buffer
+		const uint16_t *block = adc_dma_get_block();
+		if ((block == NULL) || !probe_active()) {
+			continue;
+		}
 
-			// Send ADC reading over UART
-			UART3_Write_Text("ADC Reading: ");
-			UART3_Write_Text(buffer);
-			UART3_Write_Text("\r\n");
+		// Blocks the DMAC wrote over while the last one was processed
+		uint32_t overruns = adc_dma_overruns();
+		if (overruns != app_dma_overruns) {
+			app_overrun(overruns - app_dma_overruns);
+			app_dma_overruns = overruns;
 		}
 
-		// Add a small delay between readings
-		delay_ms(100);
+		// Raw stage, which runs the pulse and report stages as their samples come due
+		app_raw_block(block);
 	}
 }
 
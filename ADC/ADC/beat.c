@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "beat.h"
+
+
+/*******************************************************************************
+ * Function:        void beat_init(beat_state_t *state, uint16_t sample_rate_hz,
+ *                                 int32_t min_amplitude)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Detector state, sample rate and smallest accepted pulse
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function converts the BEAT_BPM_MAX and BEAT_BPM_MIN
+ *                  limits to samples and starts the amplitude estimate at the
+ *                  floor, so the first beats are found with the lowest
+ *                  threshold.
+ *
+ * Note:            The divisions here run once, not per sample
+ *
+ ******************************************************************************/
+void beat_init(beat_state_t *state, uint16_t sample_rate_hz, int32_t min_amplitude)
+{
+	state->index = 0;
+	state->last_peak = 0;
+	state->extreme_index = 0;
+	state->extreme = INT32_MIN;
+	state->trough = 0;
+	state->amplitude = min_amplitude;
+	state->min_amplitude = min_amplitude;
+	state->refractory = (uint16_t)(((uint32_t)sample_rate_hz * 60u) / BEAT_BPM_MAX);
+	state->max_interval = (uint16_t)(((uint32_t)sample_rate_hz * 60u) / BEAT_BPM_MIN);
+	state->idle = 0;
+	state->latency_max = 0;
+	state->phase = BEAT_SEEK_PEAK;
+	state->have_peak = false;
+	state->have_trough = false;
+} // beat_init()
+
+
+/*******************************************************************************
+ * Function:        bool beat_push(beat_state_t *state, int32_t sample,
+ *                                 beat_event_t *event)
+ *
+ * PreCondition:    beat_init() has been called
+ *
+ * Input:           Detector state, one sample of the pulse signal
+ *
+ * Output:          true when a peak was confirmed, event is filled in
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Two phase state machine with hysteresis:
+ *
+ *                  - Seeking a peak, the running maximum is followed until
+ *                    the signal falls a threshold below it. That maximum is
+ *                    the peak, reported with its own index, the amplitude
+ *                    over the trough before it and the interval since the last
+ *                    peak.
+ *                  - Seeking a trough, the running minimum is followed until
+ *                    the signal rises a threshold above it.
+ *
+ *                  The threshold is a fixed fraction of the recent beat
+ *                  amplitude, floored at min_amplitude. Peaks inside the
+ *                  refractory period or under half the recent amplitude
+ *                  (dicrotic wave, motion) are skipped. With
+ *                  no beat for the longest interval the amplitude estimate is
+ *                  halved, so the detector recovers after a large artifact.
+ *
+ *                  Every path is a handful of compares and adds, there is no
+ *                  loop and no division, so it can run per sample in an ISR.
+ *
+ * Note:            Latency is the time for the signal to fall the threshold
+ *                  after the peak, reported per event and as latency_max.
+ *
+ ******************************************************************************/
+bool beat_push(beat_state_t *state, int32_t sample, beat_event_t *event)
+{
+	bool emitted = false;
+	int32_t threshold = state->amplitude >> BEAT_THRESHOLD_SHIFT;
+
+	if (state->phase == BEAT_SEEK_PEAK)
+	{
+		if (sample > state->extreme)
+		{
+			state->extreme = sample;
+			state->extreme_index = state->index;
+		}
+		else if ((state->extreme - sample) > threshold)
+		{
+			uint32_t interval = state->extreme_index - state->last_peak;
+			int32_t amplitude = state->extreme - state->trough;
+
+			if (state->have_peak && (interval < state->refractory))
+			{
+				// Too soon after the last beat
+			}
+			else if (state->have_trough && (amplitude >= state->min_amplitude) &&
+				(amplitude >= (state->amplitude >> BEAT_ACCEPT_SHIFT)))
+			{
+				event->index = state->extreme_index;
+				event->amplitude = amplitude;
+				event->interval = (state->have_peak && (interval <= state->max_interval)) ? (uint16_t)interval : 0;
+				event->latency = (uint16_t)(state->index - state->extreme_index);
+
+				if (event->latency > state->latency_max)
+				{
+					state->latency_max = event->latency;
+				}
+
+				state->amplitude += (event->amplitude - state->amplitude) >> BEAT_AMPLITUDE_SHIFT;
+				state->last_peak = state->extreme_index;
+				state->have_peak = true;
+				state->idle = 0;
+				emitted = true;
+			}
+
+			state->phase = BEAT_SEEK_TROUGH;
+			state->extreme = sample;
+			state->extreme_index = state->index;
+		}
+	}
+	else
+	{
+		if (sample < state->extreme)
+		{
+			state->extreme = sample;
+			state->extreme_index = state->index;
+		}
+		else if ((sample - state->extreme) > threshold)
+		{
+			state->trough = state->extreme;
+			state->have_trough = true;
+
+			state->phase = BEAT_SEEK_PEAK;
+			state->extreme = sample;
+			state->extreme_index = state->index;
+		}
+	}
+
+	// No beat for too long, lower the threshold
+	if (++state->idle >= state->max_interval)
+	{
+		state->amplitude >>= 1;
+		if (state->amplitude < state->min_amplitude)
+		{
+			state->amplitude = state->min_amplitude;
+		}
+		state->idle = 0;
+	}
+
+	state->index++;
+	return emitted;
+} // beat_push()
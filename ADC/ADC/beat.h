@@ -0,0 +1,85 @@
+#ifndef BEAT_H_
+#define BEAT_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Beat rate limits in beats per minute
+#define BEAT_BPM_MAX              (220u)
+#define BEAT_BPM_MIN              (30u)
+
+// A peak is confirmed once the signal falls 1/2^shift of the beat amplitude
+// below it (and a trough once it rises as much above it)
+#define BEAT_THRESHOLD_SHIFT      (2u)
+
+// A beat must reach 1/2^shift of the amplitude estimate, smaller swings
+// (dicrotic wave, noise) are skipped
+#define BEAT_ACCEPT_SHIFT         (1u)
+
+// Amplitude estimate follows each beat with a weight of 1/2^shift
+#define BEAT_AMPLITUDE_SHIFT      (2u)
+
+// Detector phase
+typedef enum
+{
+	BEAT_SEEK_PEAK = 0,
+	BEAT_SEEK_TROUGH
+} beat_phase_t;
+
+// Emitted once per beat
+typedef struct
+{
+	uint32_t index;        // sample index of the peak
+	int32_t amplitude;     // peak minus the trough before it
+	uint16_t interval;     // samples since the previous peak, 0 for the first beat
+	uint16_t latency;      // samples from the peak to this event
+} beat_event_t;
+
+// Detector state, no sample history is kept
+typedef struct
+{
+	uint32_t index;           // samples seen
+	uint32_t last_peak;       // index of the last emitted peak
+	uint32_t extreme_index;   // index of the running extreme
+	int32_t extreme;          // highest (or lowest) sample of the current phase
+	int32_t trough;           // last confirmed trough
+	int32_t amplitude;        // adaptive beat amplitude
+	int32_t min_amplitude;    // threshold floor
+	uint16_t refractory;      // shortest beat interval in samples
+	uint16_t max_interval;    // longest beat interval in samples
+	uint16_t idle;            // samples since the last beat or amplitude decay
+	uint16_t latency_max;     // worst latency emitted since init
+	beat_phase_t phase;
+	bool have_peak;
+	bool have_trough;
+} beat_state_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def beat_init
+ * \brief Resets the beat detector
+ * \param state (detector state)
+ * \param sample_rate_hz (rate of the samples fed to beat_push)
+ * \param min_amplitude (smallest pulse accepted, in sample units)
+ */
+void beat_init(beat_state_t *state, uint16_t sample_rate_hz, int32_t min_amplitude);
+
+
+/**
+ * \def beat_push
+ * \brief Adds one sample, returns true and fills event when a beat is confirmed
+ * \param state (detector state)
+ * \param sample (pulse signal, rising towards systole)
+ * \param event (output, valid when true is returned)
+ */
+bool beat_push(beat_state_t *state, int32_t sample, beat_event_t *event);
+
+
+#endif /* BEAT_H_ */
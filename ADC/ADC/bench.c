@@ -0,0 +1,648 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "bench.h"
+#include "spo2.h"
+#include "beat.h"
+#include "sqi.h"
+#include "morph.h"
+#include "hrv.h"
+#include "resp.h"
+#include "trend.h"
+#include "desat.h"
+#include "alarm.h"
+#include "goertzel.h"
+#include "fft.h"
+#include "filter.h"
+#include "decim.h"
+#include "fixmath.h"
+#include "USART3.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Synthetic pulse: a triangle wave with this period in samples, starting
+// each beat at the base levels
+#define BENCH_BEAT_SAMPLES      (80)
+#define BENCH_RED_BASE          (20000)
+#define BENCH_IR_BASE           (30000)
+
+// Start of the FFT test sequence
+#define BENCH_FFT_SEED          (12345u)
+
+// Alarm replay: desaturations from 97 % at 0.2 to 2 %/s, with per-beat
+// SpO2 noise of +-0.5 %, replayed with the main loop ticking every 10 ms
+#define BENCH_ALARM_SEED        (54321u)
+#define BENCH_ALARM_TRIALS      (64u)
+#define BENCH_ALARM_BASELINE    (970)
+#define BENCH_ALARM_NADIR       (800)
+#define BENCH_ALARM_ONSET_MS    (5000u)
+#define BENCH_ALARM_TICK_MS     (10u)
+#define BENCH_ALARM_TIMEOUT_MS  (180000u)
+#define BENCH_ALARM_BIN_MS      (500u)
+#define BENCH_ALARM_BINS        (8u)
+
+// Divisor for the division benchmarks
+#define BENCH_DIVISOR           (1000u)
+
+// Times expr once for each synthetic sample i and reports it
+#define BENCH_EACH(name, expr)                         \
+	do                                                 \
+	{                                                  \
+		total = 0;                                     \
+		worst = 0;                                     \
+		for (uint16_t i = 0; i < BENCH_FRAMES; i++)    \
+		{                                              \
+			start = bench_now();                       \
+			expr;                                      \
+			cycles = bench_elapsed(start);             \
+			total += cycles;                           \
+			if (cycles > worst) worst = cycles;        \
+		}                                              \
+		bench_report(name, total, BENCH_FRAMES, worst); \
+	} while (0)
+
+// Synthetic red and IR samples
+static int32_t bench_red[BENCH_FRAMES];
+static int32_t bench_ir[BENCH_FRAMES];
+
+// Cost of a bench_now() / bench_elapsed() pair
+static uint32_t bench_overhead;
+
+// FFT working buffer, the only RAM the transform uses
+static int16_t bench_fft_data[2u * FFT_SIZE_MAX];
+
+// Results are stored here so the compiler keeps the work being timed
+static volatile uint32_t bench_sink;
+static volatile float bench_sink_float;
+
+
+/*******************************************************************************
+ * Function:        static void bench_fill(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Fills the sample buffers with a red and IR pulse of about
+ *                  2 % modulation, so the beat logic takes its normal paths.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void bench_fill(void)
+{
+	for (uint16_t i = 0; i < BENCH_FRAMES; i++)
+	{
+		int32_t phase = (int32_t)(i % BENCH_BEAT_SAMPLES);
+		int32_t tri = (phase < (BENCH_BEAT_SAMPLES / 2)) ? phase : (BENCH_BEAT_SAMPLES - phase);
+
+		bench_red[i] = BENCH_RED_BASE + (tri * 10);
+		bench_ir[i] = BENCH_IR_BASE + (tri * 15);
+	}
+} // bench_fill()
+
+
+/*******************************************************************************
+ * Function:        static void bench_print_hundredths(uint32_t value)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           Value in hundredths
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Prints a value with two decimals.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void bench_print_hundredths(uint32_t value)
+{
+	char buffer[12];
+	uint32_t frac = value % 100u;
+
+	UART3_Write_Text(utoa(value / 100u, buffer, 10));
+	UART3_Write_Text(".");
+	if (frac < 10u)
+	{
+		UART3_Write_Text("0");
+	}
+	UART3_Write_Text(utoa(frac, buffer, 10));
+} // bench_print_hundredths()
+
+
+/*******************************************************************************
+ * Function:        static void bench_report(char *name, uint32_t cycles,
+ *                                           uint32_t samples, uint32_t worst)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           Benchmark name, total cycles taken, samples processed and
+ *                  the slowest single call
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Prints cycles per sample and the share of the CPU the
+ *                  processing would take at BENCH_RATE_LOW_HZ and
+ *                  BENCH_RATE_HIGH_HZ frame rates, then the worst case call,
+ *                  which bounds the time spent if run from an ISR.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void bench_report(char *name, uint32_t cycles, uint32_t samples, uint32_t worst)
+{
+	// Cycles per sample in hundredths
+	uint32_t per_sample = (uint32_t)(((uint64_t)cycles * 100u) / samples);
+
+	// CPU load in hundredths of a percent
+	uint32_t load_low = (uint32_t)(((uint64_t)cycles * BENCH_RATE_LOW_HZ * 10000u) /
+		((uint64_t)samples * BENCH_CPU_HZ));
+	uint32_t load_high = (uint32_t)(((uint64_t)cycles * BENCH_RATE_HIGH_HZ * 10000u) /
+		((uint64_t)samples * BENCH_CPU_HZ));
+
+	UART3_Write_Text(name);
+	UART3_Write_Text(": ");
+	bench_print_hundredths(per_sample);
+	UART3_Write_Text(" cycles/sample, ");
+	bench_print_hundredths(load_low);
+	UART3_Write_Text(" % CPU at 100 Hz, ");
+	bench_print_hundredths(load_high);
+	UART3_Write_Text(" % CPU at 500 Hz, worst ");
+	bench_print_hundredths(worst * 100u);
+	UART3_Write_Text(" cycles\r\n");
+} // bench_report()
+
+
+/*******************************************************************************
+ * Function:        static int16_t bench_random(uint32_t *seed)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Generator state
+ *
+ * Output:          Next pseudo-random half scale Q15 value
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Linear congruential generator, so a sequence can be
+ *                  replayed from its seed.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int16_t bench_random(uint32_t *seed)
+{
+	*seed = (*seed * 1664525u) + 1013904223u;
+	return (int16_t)((int32_t)*seed >> 17);
+} // bench_random()
+
+
+/*******************************************************************************
+ * Function:        static void bench_fft(uint16_t n)
+ *
+ * PreCondition:    bench_init() has been called
+ *
+ * Input:           Transform size
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Times one n point fft_q15() of pseudo-random real data,
+ *                  then prints the cycles, the RAM used and the SNR against
+ *                  a direct DFT of the same data in 64-bit accumulators.
+ *
+ * Note:            The reference takes n^2 multiplies, about a second at
+ *                  1024 points
+ *
+ ******************************************************************************/
+static void bench_fft(uint16_t n)
+{
+	char buffer[12];
+	uint16_t stride = FFT_SIZE_MAX / n;
+	uint8_t log2n = 0;
+	uint32_t seed = BENCH_FFT_SEED;
+
+	while ((1u << log2n) < n)
+	{
+		log2n++;
+	}
+
+	for (uint16_t i = 0; i < n; i++)
+	{
+		bench_fft_data[2u * i] = bench_random(&seed);
+		bench_fft_data[(2u * i) + 1u] = 0;
+	}
+
+	uint32_t start = bench_now();
+	fft_q15(bench_fft_data, n);
+	uint32_t cycles = bench_elapsed(start);
+
+	// Reference in Q7 of the output scale
+	uint64_t signal = 0;
+	uint64_t noise = 0;
+	for (uint16_t k = 0; k < n; k++)
+	{
+		int64_t re = 0;
+		int64_t im = 0;
+
+		seed = BENCH_FFT_SEED;
+		for (uint16_t i = 0; i < n; i++)
+		{
+			int32_t x = bench_random(&seed);
+			uint16_t index = (uint16_t)(((uint32_t)k * i) % n) * stride;
+
+			re += (int64_t)x * fft_sine[(index + (FFT_SIZE_MAX / 4u)) % FFT_SIZE_MAX];
+			im -= (int64_t)x * fft_sine[index];
+		}
+
+		int32_t ref_re = (int32_t)(re >> (FFT_TWIDDLE_SHIFT - 7u + log2n));
+		int32_t ref_im = (int32_t)(im >> (FFT_TWIDDLE_SHIFT - 7u + log2n));
+		int32_t err_re = (bench_fft_data[2u * k] * 128) - ref_re;
+		int32_t err_im = (bench_fft_data[(2u * k) + 1u] * 128) - ref_im;
+
+		signal += ((int64_t)ref_re * ref_re) + ((int64_t)ref_im * ref_im);
+		noise += ((int64_t)err_re * err_re) + ((int64_t)err_im * err_im);
+	}
+
+	// 10 log10(x) = 3.0103 log2(x)
+	uint64_t ratio = signal / ((noise != 0) ? noise : 1u);
+	if (ratio > UINT32_MAX)
+	{
+		ratio = UINT32_MAX;
+	}
+	int32_t snr_x100 = (int32_t)(((int64_t)fixmath_log2_q16((uint32_t)ratio) * 301) >> 16);
+
+	UART3_Write_Text("fft_q15 ");
+	UART3_Write_Text(utoa(n, buffer, 10));
+	UART3_Write_Text(": ");
+	UART3_Write_Text(utoa(cycles, buffer, 10));
+	UART3_Write_Text(" cycles, ");
+	UART3_Write_Text(utoa(4u * n, buffer, 10));
+	UART3_Write_Text(" bytes RAM, SNR ");
+	bench_print_hundredths((snr_x100 > 0) ? (uint32_t)snr_x100 : 0);
+	UART3_Write_Text(" dB\r\n");
+} // bench_fft()
+
+
+/*******************************************************************************
+ * Function:        static void bench_alarm(void)
+ *
+ * PreCondition:    bench_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Replays synthetic desaturations through the alarm engine
+ *                  in simulated time and prints the distribution of the
+ *                  latency from the true SpO2 crossing the limit to the
+ *                  alarm being raised, less the configured delay, then the
+ *                  worst cycles of one alarm_update() and alarm_tick().
+ *                  Each trial has its own heart rate and rate of fall, and
+ *                  SpO2 is only seen at beats, with noise, as on the target.
+ *
+ * Note:            The message itself then waits at most two characters
+ *                  behind queued text, about 2 ms at 9600 baud
+ *
+ ******************************************************************************/
+static void bench_alarm(void)
+{
+	static alarm_engine_t engine;
+	char buffer[12];
+	uint32_t seed = BENCH_ALARM_SEED;
+	uint16_t bins[BENCH_ALARM_BINS] = { 0 };
+	uint32_t latency_min = UINT32_MAX, latency_max = 0, latency_sum = 0;
+	uint32_t worst_update = 0, worst_tick = 0;
+	uint16_t missed = 0;
+
+	for (uint16_t trial = 0; trial < BENCH_ALARM_TRIALS; trial++)
+	{
+		uint32_t bpm = 40u + ((trial * 37u) % 140u);
+		uint32_t beat_ms = 60000u / bpm;
+		uint32_t fall_x10 = 2u + ((trial * 13u) % 19u);     // 0.1 %/s
+		uint32_t cross_ms = BENCH_ALARM_ONSET_MS +
+			(((BENCH_ALARM_BASELINE - ALARM_SPO2_LOW) * 1000u) / fall_x10);
+		uint32_t next_beat = (trial * 7u) % beat_ms;
+		bool raised = false;
+
+		alarm_init(&engine);
+		for (uint32_t now = 0; (now < BENCH_ALARM_TIMEOUT_MS) && !raised; now += BENCH_ALARM_TICK_MS)
+		{
+			uint32_t start;
+
+			if (now >= next_beat)
+			{
+				int32_t spo2 = BENCH_ALARM_BASELINE;
+				if (now > BENCH_ALARM_ONSET_MS)
+				{
+					spo2 -= (int32_t)(((now - BENCH_ALARM_ONSET_MS) * fall_x10) / 1000u);
+				}
+				if (spo2 < BENCH_ALARM_NADIR)
+				{
+					spo2 = BENCH_ALARM_NADIR;
+				}
+				spo2 += bench_random(&seed) / 2979;              // +-5
+
+				start = bench_now();
+				raised = alarm_update(&engine, ALARM_SPO2, spo2, true, now);
+				uint32_t cycles = bench_elapsed(start);
+				if (cycles > worst_update) worst_update = cycles;
+				next_beat += beat_ms;
+			}
+
+			start = bench_now();
+			raised |= (alarm_tick(&engine, now) != 0u);
+			uint32_t cycles = bench_elapsed(start);
+			if (cycles > worst_tick) worst_tick = cycles;
+
+			if (raised)
+			{
+				int32_t late = (int32_t)(now - cross_ms) - (int32_t)ALARM_SPO2_DELAY_MS;
+				uint32_t latency = (late > 0) ? (uint32_t)late : 0u;
+				uint32_t bin = latency / BENCH_ALARM_BIN_MS;
+
+				bins[(bin < BENCH_ALARM_BINS) ? bin : (BENCH_ALARM_BINS - 1u)]++;
+				if (latency < latency_min) latency_min = latency;
+				if (latency > latency_max) latency_max = latency;
+				latency_sum += latency;
+			}
+		}
+		if (!raised)
+		{
+			missed++;
+		}
+	}
+
+	uint16_t caught = BENCH_ALARM_TRIALS - missed;
+	UART3_Write_Text("SpO2 alarm latency after the delay, ");
+	UART3_Write_Text(utoa(caught, buffer, 10));
+	UART3_Write_Text(" of ");
+	UART3_Write_Text(utoa(BENCH_ALARM_TRIALS, buffer, 10));
+	UART3_Write_Text(" desaturations: min ");
+	UART3_Write_Text(utoa((caught != 0u) ? latency_min : 0u, buffer, 10));
+	UART3_Write_Text(" ms, mean ");
+	UART3_Write_Text(utoa((caught != 0u) ? (latency_sum / caught) : 0u, buffer, 10));
+	UART3_Write_Text(" ms, max ");
+	UART3_Write_Text(utoa(latency_max, buffer, 10));
+	UART3_Write_Text(" ms\r\n");
+
+	for (uint8_t bin = 0; bin < BENCH_ALARM_BINS; bin++)
+	{
+		UART3_Write_Text((bin == (BENCH_ALARM_BINS - 1u)) ? "  >= " : "  < ");
+		UART3_Write_Text(utoa((bin + ((bin == (BENCH_ALARM_BINS - 1u)) ? 0u : 1u)) * BENCH_ALARM_BIN_MS, buffer, 10));
+		UART3_Write_Text(" ms: ");
+		UART3_Write_Text(utoa(bins[bin], buffer, 10));
+		UART3_Write_Text("\r\n");
+	}
+
+	UART3_Write_Text("alarm_update worst ");
+	UART3_Write_Text(utoa(worst_update, buffer, 10));
+	UART3_Write_Text(" cycles, alarm_tick worst ");
+	UART3_Write_Text(utoa(worst_tick, buffer, 10));
+	UART3_Write_Text(" cycles\r\n");
+} // bench_alarm()
+
+
+/*******************************************************************************
+ * Function:        void bench_init(void)
+ *
+ * PreCondition:    Clocks are configured
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    SysTick is taken over, its interrupt stays disabled
+ *
+ * Overview:        The Cortex-M0+ has no DWT cycle counter, so SysTick is run
+ *                  from the CPU clock over its full 24-bit range instead.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void bench_init(void)
+{
+	SysTick->CTRL = 0;
+	SysTick->LOAD = BENCH_SYSTICK_MASK;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+	uint32_t start = bench_now();
+	bench_overhead = bench_elapsed(start);
+} // bench_init()
+
+
+/*******************************************************************************
+ * Function:        uint32_t bench_now(void)
+ *
+ * PreCondition:    bench_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          SysTick count
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Reads the cycle counter.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint32_t bench_now(void)
+{
+	return SysTick->VAL;
+} // bench_now()
+
+
+/*******************************************************************************
+ * Function:        uint32_t bench_elapsed(uint32_t start)
+ *
+ * PreCondition:    bench_init() has been called
+ *
+ * Input:           Earlier bench_now() value
+ *
+ * Output:          Cycles since start, less the cost of the measurement
+ *
+ * Side Effects:    None
+ *
+ * Overview:        SysTick counts down, so the elapsed time is start - now,
+ *                  taken modulo 2^24 to cover one wrap.
+ *
+ * Note:            Intervals over 2^24 cycles (350 ms) alias
+ *
+ ******************************************************************************/
+uint32_t bench_elapsed(uint32_t start)
+{
+	uint32_t cycles = (start - SysTick->VAL) & BENCH_SYSTICK_MASK;
+
+	return (cycles > bench_overhead) ? (cycles - bench_overhead) : 0;
+} // bench_elapsed()
+
+
+/*******************************************************************************
+ * Function:        void bench_run(void)
+ *
+ * PreCondition:    UART3_Init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    SysTick is taken over, interrupts are masked while timing
+ *
+ * Overview:        This function runs each signal processing stage over
+ *                  BENCH_FRAMES synthetic samples and prints its cost, so the
+ *                  headroom left at a given frame rate is known.
+ *
+ * Note:            Only built into AppRun() with APP_RUN_BENCHMARKS defined
+ *
+ ******************************************************************************/
+void bench_run(void)
+{
+	uint32_t start;
+	uint32_t cycles;
+	uint32_t total;
+	uint32_t worst;
+
+	bench_init();
+	bench_fill();
+
+	__disable_irq();
+
+	// Division by a constant: reciprocal multiply against __aeabi_uidiv. The
+	// divisor is read through a volatile so the compiler cannot turn the
+	// libgcc case into a multiply itself.
+	static const fixmath_recip_t recip = FIXMATH_RECIP(BENCH_DIVISOR, 10u);
+	volatile uint32_t divisor = BENCH_DIVISOR;
+	BENCH_EACH("fixmath_div", bench_sink = fixmath_div((uint32_t)bench_ir[i] * bench_ir[i], &recip));
+	BENCH_EACH("__aeabi_uidiv", bench_sink = ((uint32_t)bench_ir[i] * bench_ir[i]) / divisor);
+
+	// Square root against soft-float sqrtf
+	BENCH_EACH("fixmath_isqrt32", bench_sink = fixmath_isqrt32((uint32_t)bench_ir[i] * bench_ir[i]));
+	BENCH_EACH("sqrtf", bench_sink_float = sqrtf((float)((uint32_t)bench_ir[i] * bench_ir[i])));
+
+	// log2 and exp2 against soft-float
+	BENCH_EACH("fixmath_log2_q16", bench_sink = (uint32_t)fixmath_log2_q16((uint32_t)bench_ir[i]));
+	BENCH_EACH("log2f", bench_sink_float = log2f((float)bench_ir[i]));
+	BENCH_EACH("fixmath_exp2_q16", bench_sink = fixmath_exp2_q16((bench_ir[i] - BENCH_IR_BASE) << 10));
+	BENCH_EACH("exp2f", bench_sink_float = exp2f((float)(bench_ir[i] - BENCH_IR_BASE) / 64.0f));
+
+	// Saturating multiply-accumulate
+	int32_t acc = 0;
+	BENCH_EACH("fixmath_mac_q15", acc = fixmath_mac_q15(acc, (int16_t)bench_ir[i], (int16_t)bench_red[i]));
+	BENCH_EACH("fixmath_mac_q31", acc = fixmath_mac_q31(acc, bench_ir[i] << 16, bench_red[i] << 16));
+	bench_sink = (uint32_t)acc;
+
+	// CIC decimator, one block in one call
+	decim_t decim;
+	decim_init(&decim);
+	static int32_t decimated[(BENCH_FRAMES / DECIM_FACTOR) + 1u];
+
+	start = bench_now();
+	decim_block(&decim, bench_ir, BENCH_FRAMES, decimated);
+	cycles = bench_elapsed(start);
+	bench_report("decim_block", cycles, BENCH_FRAMES, cycles);
+
+	// Band-pass biquad cascade
+	filter_bandpass_t bandpass;
+	filter_bandpass_init(&bandpass);
+	BENCH_EACH("filter_bandpass", filter_bandpass(&bandpass, (int16_t)bench_ir[i]));
+
+	// Smoothing FIR
+	filter_fir_t fir;
+	filter_fir_init(&fir);
+	BENCH_EACH("filter_fir", filter_fir(&fir, (int16_t)bench_ir[i]));
+
+	// Beat detector
+	beat_state_t beat;
+	beat_event_t event;
+	beat_init(&beat, BENCH_RATE_LOW_HZ, 1);
+	BENCH_EACH("beat_push", beat_push(&beat, bench_ir[i], &event));
+
+	// Signal quality, scoring a beat where the synthetic pulse starts over
+	sqi_state_t sqi;
+	event.amplitude = 15 * (BENCH_BEAT_SAMPLES / 2);
+	event.interval = BENCH_BEAT_SAMPLES;
+	event.latency = BENCH_BEAT_SAMPLES / 2;
+	sqi_init(&sqi, BENCH_RATE_LOW_HZ);
+	BENCH_EACH("sqi_push", if (bench_ir[i] == BENCH_IR_BASE) sqi_beat(&sqi, &event);
+		sqi_push(&sqi, (int16_t)(bench_ir[i] - BENCH_IR_BASE), (int16_t)(bench_red[i] - BENCH_RED_BASE),
+		(int16_t)(bench_ir[i] - BENCH_IR_BASE), false));
+
+	// Pulse shape, the peak of each synthetic beat is half a beat back
+	static morph_state_t morph;
+	morph_init(&morph, BENCH_RATE_LOW_HZ, 0);
+	BENCH_EACH("morph_push", morph_push(&morph, (int16_t)(bench_ir[i] - BENCH_IR_BASE), bench_ir[i]);
+		if (bench_ir[i] == BENCH_IR_BASE) morph_beat(&morph, &event));
+
+	// HRV, one interval per call, and the per second expiry and report maths
+	static hrv_state_t hrv;
+	hrv_result_t hrv_out;
+	hrv_init(&hrv);
+	BENCH_EACH("hrv_add", hrv_add(&hrv, (uint16_t)(bench_ir[i] - BENCH_IR_BASE + 800)));
+	BENCH_EACH("hrv_second", hrv_second(&hrv));
+	BENCH_EACH("hrv_result", bench_sink = hrv_result(&hrv, HRV_WINDOW_60MIN, &hrv_out) ? hrv_out.sdnn_x10 : 0u);
+
+	// Respiratory rate, one beat per call, the worst case is an estimate beat
+	static resp_state_t resp;
+	resp_init(&resp);
+	BENCH_EACH("resp_beat", bench_sink = resp_beat(&resp, bench_ir[i], bench_red[i] - BENCH_RED_BASE,
+		(uint16_t)(bench_ir[i] - BENCH_IR_BASE + 800), true));
+
+	// Trends, one second per call. Started so a cascade through every
+	// horizon (each 960 s) falls within the run.
+	static trend_t trend;
+	trend_result_t trend_out;
+	trend_init(&trend);
+	for (uint16_t s = 0; s < (960u - (BENCH_FRAMES / 2u)); s++)
+	{
+		trend_second(&trend, (int16_t)bench_ir[s % BENCH_FRAMES], true);
+	}
+	BENCH_EACH("trend_second", trend_second(&trend, (int16_t)bench_ir[i], true));
+	BENCH_EACH("trend_result", bench_sink = trend_result(&trend, TREND_8H, &trend_out) ? trend_out.mean : 0);
+
+	// Desaturations, one second per call with a 6 % dip every 64 seconds
+	static desat_state_t desat;
+	desat_init(&desat);
+	BENCH_EACH("desat_second", bench_sink = desat_second(&desat, (uint16_t)(970u - (((i & 63u) < 32u) ? 60u : 0u)), true));
+
+	// Alarm latency over replayed desaturations
+	bench_alarm();
+
+	// Goertzel bank, one bin group per sample. A window short enough to close
+	// within the run so the worst case includes the power and peak search.
+	static goertzel_t bank;
+	char buffer[12];
+	goertzel_init(&bank, 2);
+	UART3_Write_Text("Goertzel bins: ");
+	UART3_Write_Text(utoa(FILTER_GOERTZEL_BINS, buffer, 10));
+	UART3_Write_Text(", per sample: ");
+	UART3_Write_Text(utoa(GOERTZEL_GROUP_BINS, buffer, 10));
+	UART3_Write_Text("\r\n");
+	BENCH_EACH("goertzel_push", goertzel_push(&bank, (int16_t)(bench_ir[i] - BENCH_IR_BASE)));
+
+	// FFT at every size used by the spectral analyses
+	for (uint16_t n = 128u; n <= FFT_SIZE_MAX; n *= 2u)
+	{
+		bench_fft(n);
+	}
+
+	// SpO2, closing a beat where the synthetic pulse starts over
+	spo2_state_t spo2;
+	spo2_init(&spo2, BENCH_RATE_LOW_HZ);
+	BENCH_EACH("spo2_push", if (bench_ir[i] == BENCH_IR_BASE) spo2_beat(&spo2); spo2_push(&spo2, bench_red[i], bench_ir[i]));
+
+	__enable_irq();
+} // bench_run()
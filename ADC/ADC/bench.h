@@ -0,0 +1,59 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "app.h"
+
+// SysTick runs from the CPU clock
+#define BENCH_CPU_HZ            (48000000ul)
+
+// SysTick is a 24-bit down counter
+#define BENCH_SYSTICK_MASK      (0x00FFFFFFul)
+
+// Frame rates the headroom is reported for
+#define BENCH_RATE_LOW_HZ       (100u)
+#define BENCH_RATE_HIGH_HZ      (500u)
+
+// Synthetic samples per benchmark run
+#define BENCH_FRAMES            (256u)
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def bench_init
+ * \brief Starts SysTick free running as a CPU cycle counter, no interrupt
+ * \param none
+ */
+void bench_init(void);
+
+
+/**
+ * \def bench_now
+ * \brief Returns the current cycle count (counts down, wraps after 2^24 cycles)
+ * \param none
+ */
+uint32_t bench_now(void);
+
+
+/**
+ * \def bench_elapsed
+ * \brief Returns the cycles since a bench_now() reading, up to 2^24 - 1
+ * \param start (earlier bench_now() value)
+ */
+uint32_t bench_elapsed(uint32_t start);
+
+
+/**
+ * \def bench_run
+ * \brief Times the signal processing modules on synthetic data and prints the results
+ * \param none
+ */
+void bench_run(void);
+
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,151 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "dc_track.h"
+
+// Half an LSB of the output
+#define DC_TRACK_HALF          (1l << (DC_TRACK_FRAC_BITS - 1u))
+
+
+/*******************************************************************************
+ * Function:        void dc_track_init(dc_track_t *track, uint16_t sample_rate_hz,
+ *                                     uint16_t tau_ms)
+ *
+ * PreCondition:    None
+ *
+ * Input:           DC tracker, sample rate and time constant
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function picks the first power of two samples that
+ *                  covers tau_ms, so each update is a shift rather than a
+ *                  multiply by a coefficient.
+ *
+ * Note:            The division here runs once, not per sample
+ *
+ ******************************************************************************/
+void dc_track_init(dc_track_t *track, uint16_t sample_rate_hz, uint16_t tau_ms)
+{
+	uint32_t samples = ((uint32_t)sample_rate_hz * tau_ms + 999u) / 1000u;
+
+	track->shift = 0;
+	while (((1ul << track->shift) < samples) && (track->shift < DC_TRACK_SHIFT_MAX))
+	{
+		track->shift++;
+	}
+
+	track->acc = 0;
+	track->primed = false;
+} // dc_track_init()
+
+
+/*******************************************************************************
+ * Function:        int32_t dc_track_update(dc_track_t *track, int32_t sample)
+ *
+ * PreCondition:    dc_track_init() has been called
+ *
+ * Input:           DC tracker and one sample
+ *
+ * Output:          Rounded DC estimate
+ *
+ * Side Effects:    None
+ *
+ * Overview:        dc += (x - dc) / 2^shift, kept with DC_TRACK_FRAC_BITS of
+ *                  fraction and rounded to nearest. Truncating instead would
+ *                  let the estimate settle up to one step below the input.
+ *
+ *                  Without a seed the first sample is taken as the DC, so the
+ *                  estimate starts at the signal rather than climbing from 0.
+ *
+ * Note:            Inputs must stay within 16 bits signed or unsigned
+ *
+ ******************************************************************************/
+int32_t dc_track_update(dc_track_t *track, int32_t sample)
+{
+	int32_t x = sample * (1l << DC_TRACK_FRAC_BITS);
+
+	if (!track->primed)
+	{
+		track->acc = x;
+		track->primed = true;
+	}
+	else if (track->shift > 0)
+	{
+		track->acc += ((x - track->acc) + (1l << (track->shift - 1u))) >> track->shift;
+	}
+	else
+	{
+		track->acc = x;
+	}
+
+	return dc_track_value(track);
+} // dc_track_update()
+
+
+/*******************************************************************************
+ * Function:        void dc_track_block(dc_track_t *track, const int32_t *samples,
+ *                                      uint16_t count)
+ *
+ * PreCondition:    dc_track_init() has been called
+ *
+ * Input:           DC tracker and a block of samples
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function seeds an unprimed tracker with the mean of
+ *                  the block, which is a far better start than a single noisy
+ *                  sample. It then feeds the block through the filter.
+ *
+ * Note:            The seed costs one division per reset
+ *
+ ******************************************************************************/
+void dc_track_block(dc_track_t *track, const int32_t *samples, uint16_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (!track->primed)
+	{
+		int32_t sum = 0;
+		for (uint16_t i = 0; i < count; i++)
+		{
+			sum += samples[i];
+		}
+
+		track->acc = (int32_t)(((int64_t)sum * (1l << DC_TRACK_FRAC_BITS)) / count);
+		track->primed = true;
+	}
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		dc_track_update(track, samples[i]);
+	}
+} // dc_track_block()
+
+
+/*******************************************************************************
+ * Function:        int32_t dc_track_value(const dc_track_t *track)
+ *
+ * PreCondition:    None
+ *
+ * Input:           DC tracker
+ *
+ * Output:          Rounded DC estimate, 0 before the first sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Drops the fractional bits with rounding.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+int32_t dc_track_value(const dc_track_t *track)
+{
+	return (track->acc + DC_TRACK_HALF) >> DC_TRACK_FRAC_BITS;
+} // dc_track_value()
@@ -0,0 +1,67 @@
+#ifndef DC_TRACK_H_
+#define DC_TRACK_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fractional bits kept in the accumulator, inputs up to 16 bits stay in int32
+#define DC_TRACK_FRAC_BITS     (12u)
+
+// Longest time constant. With the rounded update the estimate stalls less
+// than 2^(shift-1) below the input, under half an LSB up to this shift
+#define DC_TRACK_SHIFT_MAX     (DC_TRACK_FRAC_BITS)
+
+// Single-pole baseline tracker for one channel
+typedef struct
+{
+	int32_t acc;       // DC in Q(DC_TRACK_FRAC_BITS)
+	uint8_t shift;     // time constant of 2^shift samples
+	bool primed;       // seeded from the first input
+} dc_track_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def dc_track_init
+ * \brief Resets a tracker with a time constant of at least tau_ms at the given rate
+ * \param track (DC tracker)
+ * \param sample_rate_hz (rate of the samples fed to the tracker)
+ * \param tau_ms (time constant in ms, rounded up to a power of two samples)
+ */
+void dc_track_init(dc_track_t *track, uint16_t sample_rate_hz, uint16_t tau_ms);
+
+
+/**
+ * \def dc_track_update
+ * \brief Adds one sample and returns the rounded DC estimate
+ * \param track (DC tracker)
+ * \param sample (input sample)
+ */
+int32_t dc_track_update(dc_track_t *track, int32_t sample);
+
+
+/**
+ * \def dc_track_block
+ * \brief Adds a block of samples, the first block after init seeds the tracker with its mean
+ * \param track (DC tracker)
+ * \param samples (input samples)
+ * \param count (number of samples)
+ */
+void dc_track_block(dc_track_t *track, const int32_t *samples, uint16_t count);
+
+
+/**
+ * \def dc_track_value
+ * \brief Returns the rounded DC estimate
+ * \param track (DC tracker)
+ */
+int32_t dc_track_value(const dc_track_t *track);
+
+
+#endif /* DC_TRACK_H_ */
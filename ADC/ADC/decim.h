@@ -0,0 +1,48 @@
+#ifndef DECIM_H_
+#define DECIM_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+// CIC decimator: rate change, number of integrator/comb stages and the shift
+// that removes the DC gain of FACTOR^STAGES
+#define DECIM_FACTOR           (8u)
+#define DECIM_STAGES           (3u)
+#define DECIM_SHIFT            (9u)
+
+// One channel of the decimator. Integrators wrap modulo 2^32 by design, the
+// comb differences come out right as long as the output fits.
+typedef struct
+{
+	uint32_t integrator[DECIM_STAGES];
+	uint32_t comb[DECIM_STAGES];
+	uint8_t phase;
+} decim_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def decim_init
+ * \brief Clears a decimator channel
+ * \param decim (decimator state)
+ */
+void decim_init(decim_t *decim);
+
+
+/**
+ * \def decim_block
+ * \brief Decimates a block by DECIM_FACTOR, returns the number of outputs written
+ * \param decim (decimator state)
+ * \param in (input samples)
+ * \param count (number of input samples)
+ * \param out (output, room for count / DECIM_FACTOR + 1 samples)
+ */
+uint16_t decim_block(decim_t *decim, const int32_t *in, uint16_t count, int32_t *out);
+
+
+#endif /* DECIM_H_ */
@@ -10,6 +10,19 @@
 #define LED0_PIN_NUMBER      (17ul)
 #define LED0_PIN_MASK        PORT_PA17
 
+// Red LED IO Pin definition (TCC0/WO[0], peripheral function E)
+#define LED_RED_PORT         PORTA
+#define LED_RED_PIN_NUMBER   (8ul)
+#define LED_RED_PIN_MASK     PORT_PA08
+
+// IR LED IO Pin definition (TCC0/WO[1], peripheral function E)
+#define LED_IR_PORT          PORTA
+#define LED_IR_PIN_NUMBER    (9ul)
+#define LED_IR_PIN_MASK      PORT_PA09
+
+// A0 on the MKR Zero is connected to ADC channel 19 (PA11)
+#define ADC_CHANNEL_A0       (19u)
+
 // GCLK_MAIN Clock output IO Pin Definition
 #define GCLK_MAIN_OUTPUT_PORT       PORTA
 #define GCLK_MAIN_OUTPUT_PIN_NUMBER (28ul)
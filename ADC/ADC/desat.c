@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "desat.h"
+
+
+/*******************************************************************************
+ * Function:        static void desat_count(desat_state_t *desat)
+ *
+ * PreCondition:    An event is open and has not been counted
+ *
+ * Input:           Detector state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Adds the open event to the ODI counts and its area so far
+ *                  to the hypoxic burden. Later seconds of the event add to
+ *                  the burden directly.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void desat_count(desat_state_t *desat)
+{
+	desat->events_3++;
+	if (desat->current.drop_4)
+	{
+		desat->events_4++;
+	}
+	desat->burden_area += desat->area;
+	desat->counted = true;
+} // desat_count()
+
+
+/*******************************************************************************
+ * Function:        void desat_init(desat_state_t *desat)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Detector state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the state. The first valid second sets the
+ *                  baseline.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void desat_init(desat_state_t *desat)
+{
+	desat->time_s = 0;
+	desat->onset_s = 0;
+	desat->baseline = 0;
+	desat->have_baseline = false;
+	desat->open = false;
+	desat->counted = false;
+	desat->area = 0;
+	desat->current = (desat_event_t){ 0 };
+	desat->valid_s = 0;
+	desat->burden_area = 0;
+	desat->events_3 = 0;
+	desat->events_4 = 0;
+	desat->last = (desat_event_t){ 0 };
+} // desat_init()
+
+
+/*******************************************************************************
+ * Function:        bool desat_second(desat_state_t *desat, uint16_t spo2_x10, bool valid)
+ *
+ * PreCondition:    desat_init() has been called
+ *
+ * Input:           Detector state, this second's SpO2 and whether there is one
+ *
+ * Output:          true when desat->last holds a new or updated event
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Outside an event the baseline follows SpO2, and the last
+ *                  second near it is kept as the onset of the next drop. A
+ *                  value DESAT_DROP_3 under the baseline opens an event from
+ *                  that onset with the baseline frozen. The event tracks its
+ *                  nadir and the area under the baseline, and closes when
+ *                  SpO2 has recovered half of the drop. Events shorter than
+ *                  DESAT_MIN_S are dropped.
+ *
+ *                  An event still open DESAT_MAX_S after its onset is
+ *                  reported and counted then, marked not recovered, so no
+ *                  nadir waits longer than that. It is reported again when
+ *                  it recovers, with its full duration, but not counted
+ *                  twice.
+ *
+ * Note:            No divisions, constant state
+ *
+ ******************************************************************************/
+bool desat_second(desat_state_t *desat, uint16_t spo2_x10, bool valid)
+{
+	uint32_t now = desat->time_s++;
+	int32_t x = spo2_x10;
+
+	if (!valid)
+	{
+		return false;
+	}
+	desat->valid_s++;
+
+	if (!desat->have_baseline)
+	{
+		desat->baseline = x << DESAT_BASELINE_FRAC_BITS;
+		desat->have_baseline = true;
+		desat->onset_s = now;
+		return false;
+	}
+
+	if (!desat->open)
+	{
+		int32_t base = (desat->baseline + (1l << (DESAT_BASELINE_FRAC_BITS - 1u))) >> DESAT_BASELINE_FRAC_BITS;
+
+		if ((x + (int32_t)DESAT_ONSET) >= base)
+		{
+			desat->onset_s = now;
+		}
+
+		if ((x + (int32_t)DESAT_DROP_3) > base)
+		{
+			int32_t error = (x << DESAT_BASELINE_FRAC_BITS) - desat->baseline;
+			desat->baseline += (error >= 0) ? (error >> DESAT_RISE_SHIFT) : -((-error) >> DESAT_FALL_SHIFT);
+			return false;
+		}
+
+		desat->open = true;
+		desat->counted = false;
+		desat->area = 0;
+		desat->current.start_s = desat->onset_s;
+		desat->current.nadir_s = now;
+		desat->current.duration_s = 0;
+		desat->current.baseline_x10 = (uint16_t)base;
+		desat->current.nadir_x10 = spo2_x10;
+		desat->current.drop_4 = false;
+		desat->current.recovered = false;
+	}
+
+	desat_event_t *event = &desat->current;
+	int32_t below = (int32_t)event->baseline_x10 - x;
+
+	if (below > 0)
+	{
+		if (desat->counted)
+		{
+			desat->burden_area += (uint32_t)below;
+		}
+		else
+		{
+			desat->area += (uint32_t)below;
+		}
+	}
+	if (spo2_x10 < event->nadir_x10)
+	{
+		event->nadir_x10 = spo2_x10;
+		event->nadir_s = now;
+	}
+
+	int32_t depth = (int32_t)event->baseline_x10 - (int32_t)event->nadir_x10;
+	event->drop_4 = (depth >= (int32_t)DESAT_DROP_4);
+	event->duration_s = (uint16_t)(now - event->start_s);
+
+	if ((x - (int32_t)event->nadir_x10) >= (depth / 2))
+	{
+		// Recovered
+		desat->open = false;
+		desat->onset_s = now;
+		if (!desat->counted && (event->duration_s < DESAT_MIN_S))
+		{
+			return false;
+		}
+		if (!desat->counted)
+		{
+			desat_count(desat);
+		}
+		event->recovered = true;
+		desat->last = *event;
+		return true;
+	}
+
+	if (!desat->counted && (event->duration_s >= DESAT_MAX_S))
+	{
+		desat_count(desat);
+		desat->last = *event;
+		return true;
+	}
+	return false;
+} // desat_second()
+
+
+/*******************************************************************************
+ * Function:        bool desat_summary(const desat_state_t *desat,
+ *                                     desat_summary_t *summary)
+ *
+ * PreCondition:    desat_init() has been called
+ *
+ * Input:           Detector state and output
+ *
+ * Output:          false if no second had an SpO2 value
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Counts and area over the hours of valid SpO2:
+ *
+ *                      ODI    = events * 3600 / valid_s
+ *                      burden = area / 60 * 3600 / valid_s   (%min/h)
+ *
+ *                  The area is in 0.1 % seconds, which gives the burden in
+ *                  0.1 %min/h.
+ *
+ * Note:            Three divisions, call at the report rate
+ *
+ ******************************************************************************/
+bool desat_summary(const desat_state_t *desat, desat_summary_t *summary)
+{
+	*summary = (desat_summary_t){ 0 };
+
+	if (desat->valid_s == 0u)
+	{
+		return false;
+	}
+
+	uint64_t odi3 = ((uint64_t)desat->events_3 * 36000u) / desat->valid_s;
+	uint64_t odi4 = ((uint64_t)desat->events_4 * 36000u) / desat->valid_s;
+	uint64_t burden = ((uint64_t)desat->burden_area * 60u) / desat->valid_s;
+
+	summary->odi3_x10 = (odi3 > UINT16_MAX) ? UINT16_MAX : (uint16_t)odi3;
+	summary->odi4_x10 = (odi4 > UINT16_MAX) ? UINT16_MAX : (uint16_t)odi4;
+	summary->burden_x10 = (burden > UINT16_MAX) ? UINT16_MAX : (uint16_t)burden;
+	return true;
+} // desat_summary()
@@ -0,0 +1,106 @@
+#ifndef DESAT_H_
+#define DESAT_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Drops below the baseline, SpO2 in 0.1 %
+#define DESAT_DROP_3              (30u)
+#define DESAT_DROP_4              (40u)
+
+// A value within this of the baseline marks the onset of the next drop
+#define DESAT_ONSET               (10u)
+
+// Shortest event counted, seconds
+#define DESAT_MIN_S               (10u)
+
+// Longest event before it is closed and reported anyway, which bounds the
+// time from any nadir to its event
+#define DESAT_MAX_S               (120u)
+
+// The baseline follows SpO2 outside events with a weight of 1/2^shift per
+// second, quickly upwards to the recovered level and slowly downwards
+#define DESAT_RISE_SHIFT          (4u)
+#define DESAT_FALL_SHIFT          (7u)
+#define DESAT_BASELINE_FRAC_BITS  (8u)
+
+// One desaturation, times in seconds since desat_init()
+typedef struct
+{
+	uint32_t start_s;        // last value within DESAT_ONSET of the baseline
+	uint32_t nadir_s;
+	uint16_t duration_s;     // start to recovery
+	uint16_t baseline_x10;   // baseline SpO2 in 0.1 %
+	uint16_t nadir_x10;      // lowest SpO2 in 0.1 %
+	bool drop_4;             // at least DESAT_DROP_4, else DESAT_DROP_3
+	bool recovered;          // false if closed at DESAT_MAX_S
+} desat_event_t;
+
+// Detector state, constant size however long it runs
+typedef struct
+{
+	uint32_t time_s;         // seconds seen
+	uint32_t onset_s;        // last second within DESAT_ONSET of the baseline
+	int32_t baseline;        // SpO2 in 0.1 % << DESAT_BASELINE_FRAC_BITS
+	bool have_baseline;
+
+	// Open event
+	bool open;
+	bool counted;            // reported at DESAT_MAX_S and counted
+	uint32_t area;           // below the baseline, 0.1 % seconds
+	desat_event_t current;
+
+	// Totals since desat_init()
+	uint32_t valid_s;        // seconds with an SpO2 value
+	uint32_t burden_area;    // area under the baseline of counted events
+	uint16_t events_3;
+	uint16_t events_4;
+
+	// Last event closed
+	desat_event_t last;
+} desat_state_t;
+
+// Summary since desat_init()
+typedef struct
+{
+	uint16_t odi3_x10;       // events of at least 3 % per hour, in 0.1
+	uint16_t odi4_x10;       // events of at least 4 % per hour, in 0.1
+	uint16_t burden_x10;     // hypoxic burden in 0.1 %min per hour
+} desat_summary_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def desat_init
+ * \brief Clears the detector and its totals
+ * \param desat (detector state)
+ */
+void desat_init(desat_state_t *desat);
+
+
+/**
+ * \def desat_second
+ * \brief Adds one second of SpO2, returns true when desat->last holds a new event
+ * \param desat (detector state)
+ * \param spo2_x10 (SpO2 in 0.1 %)
+ * \param valid (false if there is no SpO2 this second)
+ */
+bool desat_second(desat_state_t *desat, uint16_t spo2_x10, bool valid);
+
+
+/**
+ * \def desat_summary
+ * \brief ODI and hypoxic burden over the valid time, returns false before the first valid second
+ * \param desat (detector state)
+ * \param summary (output)
+ */
+bool desat_summary(const desat_state_t *desat, desat_summary_t *summary);
+
+
+#endif /* DESAT_H_ */
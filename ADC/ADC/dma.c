@@ -0,0 +1,215 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "dma.h"
+#include <stddef.h>
+
+// Descriptor and write-back sections must be 128-bit aligned (DS 19.6.2.3)
+static DmacDescriptor dma_base_section[DMA_NUM_CHANNELS] __attribute__((aligned(16)));
+static volatile DmacDescriptor dma_writeback_section[DMA_NUM_CHANNELS] __attribute__((aligned(16)));
+
+static dma_callback_t dma_callbacks[DMA_NUM_CHANNELS];
+
+
+/*******************************************************************************
+ * Function:        void dma_init(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    All channels are reset
+ *
+ * Overview:        This function enables the DMAC clocks, resets the module and
+ *                  hands it the descriptor and write-back sections.
+ *
+ * Note:            Calling it more than once is harmless, channels already set
+ *                  up by other modules are left alone after the first call.
+ *
+ ******************************************************************************/
+void dma_init(void)
+{
+	if (DMAC->CTRL.bit.DMAENABLE)
+	{
+		return;
+	}
+
+	// Enable AHB and APBB clocks for DMAC
+	PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+	PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+	// Reset DMAC
+	DMAC->CTRL.reg = 0;
+	DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+	while (DMAC->CTRL.bit.SWRST);
+
+	// Point to the descriptor sections
+	DMAC->BASEADDR.reg = (uint32_t)dma_base_section;
+	DMAC->WRBADDR.reg = (uint32_t)dma_writeback_section;
+
+	// Enable DMAC with all priority levels
+	DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+	NVIC_EnableIRQ(DMAC_IRQn);
+} // dma_init()
+
+
+/*******************************************************************************
+ * Function:        DmacDescriptor *dma_descriptor(uint8_t channel)
+ *
+ * PreCondition:    None
+ *
+ * Input:           DMAC channel number
+ *
+ * Output:          The first descriptor of the channel
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Modules fill in the returned descriptor and may link it to
+ *                  further descriptors of their own through DESCADDR.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+DmacDescriptor *dma_descriptor(uint8_t channel)
+{
+	return &dma_base_section[channel];
+} // dma_descriptor()
+
+
+/*******************************************************************************
+ * Function:        void dma_channel_init(uint8_t channel, uint8_t trigsrc,
+ *                                        dma_callback_t callback)
+ *
+ * PreCondition:    dma_init() has been called
+ *
+ * Input:           Channel number, peripheral trigger and completion callback
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function resets a channel and configures it for one
+ *                  beat per peripheral trigger.
+ *
+ * Note:            The transfer complete interrupt fires at the end of every
+ *                  block whose descriptor has BLOCKACT_INT set.
+ *
+ ******************************************************************************/
+void dma_channel_init(uint8_t channel, uint8_t trigsrc, dma_callback_t callback)
+{
+	dma_callbacks[channel] = callback;
+
+	__disable_irq();
+	DMAC->CHID.reg = DMAC_CHID_ID(channel);
+
+	// Reset channel
+	DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+	DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+	while (DMAC->CHCTRLA.bit.SWRST);
+
+	// One beat per trigger
+	DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) |
+		DMAC_CHCTRLB_TRIGSRC(trigsrc) |
+		DMAC_CHCTRLB_TRIGACT_BEAT;
+
+	if (callback != NULL)
+	{
+		DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR;
+	}
+	__enable_irq();
+} // dma_channel_init()
+
+
+/*******************************************************************************
+ * Function:        void dma_channel_enable(uint8_t channel)
+ *
+ * PreCondition:    dma_channel_init() has been called
+ *
+ * Input:           DMAC channel number
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function enables a channel.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void dma_channel_enable(uint8_t channel)
+{
+	__disable_irq();
+	DMAC->CHID.reg = DMAC_CHID_ID(channel);
+	DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+	__enable_irq();
+} // dma_channel_enable()
+
+
+/*******************************************************************************
+ * Function:        void dma_channel_disable(uint8_t channel)
+ *
+ * PreCondition:    None
+ *
+ * Input:           DMAC channel number
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function disables a channel.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void dma_channel_disable(uint8_t channel)
+{
+	__disable_irq();
+	DMAC->CHID.reg = DMAC_CHID_ID(channel);
+	DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+	while (DMAC->CHCTRLA.bit.ENABLE);
+	__enable_irq();
+} // dma_channel_disable()
+
+
+/*******************************************************************************
+ * Function:        void DMAC_Handler(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    CHID is saved and restored
+ *
+ * Overview:        Clears the flags of every channel with a pending interrupt
+ *                  and passes them on to that channel's callback.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void DMAC_Handler(void)
+{
+	uint8_t chid = DMAC->CHID.reg;
+	uint32_t pending = DMAC->INTSTATUS.reg;
+
+	for (uint8_t channel = 0; channel < DMA_NUM_CHANNELS; channel++)
+	{
+		if (pending & (1u << channel))
+		{
+			DMAC->CHID.reg = DMAC_CHID_ID(channel);
+			uint8_t flags = DMAC->CHINTFLAG.reg;
+			DMAC->CHINTFLAG.reg = flags;
+
+			if (dma_callbacks[channel] != NULL)
+			{
+				dma_callbacks[channel](flags);
+			}
+		}
+	}
+
+	DMAC->CHID.reg = chid;
+} // DMAC_Handler()
@@ -0,0 +1,62 @@
+#ifndef DMA_H_
+#define DMA_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "app.h"
+
+// Number of DMAC channels with a descriptor in the base section
+#define DMA_NUM_CHANNELS       (2u)
+
+// Called from DMAC_Handler with the channel's CHINTFLAG bits
+typedef void (*dma_callback_t)(uint8_t flags);
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def dma_init
+ * \brief Enables the DMAC and points it at the descriptor sections
+ * \param none
+ */
+void dma_init(void);
+
+
+/**
+ * \def dma_descriptor
+ * \brief Returns the base (first) descriptor of a channel
+ * \param channel (DMAC channel number)
+ */
+DmacDescriptor *dma_descriptor(uint8_t channel);
+
+
+/**
+ * \def dma_channel_init
+ * \brief Resets a channel and assigns its trigger and completion callback
+ * \param channel (DMAC channel number)
+ * \param trigsrc (peripheral trigger, eg. ADC_DMAC_ID_RESRDY)
+ * \param callback (called on block transfer complete or error, may be NULL)
+ */
+void dma_channel_init(uint8_t channel, uint8_t trigsrc, dma_callback_t callback);
+
+
+/**
+ * \def dma_channel_enable
+ * \brief Enables a channel once its descriptors are in place
+ * \param channel (DMAC channel number)
+ */
+void dma_channel_enable(uint8_t channel);
+
+
+/**
+ * \def dma_channel_disable
+ * \brief Disables a channel, any transfer in progress is aborted
+ * \param channel (DMAC channel number)
+ */
+void dma_channel_disable(uint8_t channel);
+
+
+#endif /* DMA_H_ */
@@ -0,0 +1,220 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "fft.h"
+#include "fixmath.h"
+
+#define FFT_TWIDDLE_ROUND      (1l << (FFT_TWIDDLE_SHIFT - 1u))
+
+// cos() is sin() a quarter period on
+#define FFT_QUARTER            (FFT_SIZE_MAX / 4u)
+
+
+/*******************************************************************************
+ * Function:        static void fft_rotate(int16_t *out, int32_t re, int32_t im,
+ *                                         uint16_t index)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Output pair, value and twiddle table index
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Stores (re + j im) W, with W = cos(a) - j sin(a) and
+ *                  a = 2 pi index / FFT_SIZE_MAX. Four MULS, rounded and
+ *                  saturated back to Q15.
+ *
+ * Note:            |re + j im| may reach sqrt(2) full scale, so a component
+ *                  of the result can exceed Q15 and is clamped.
+ *
+ ******************************************************************************/
+static void fft_rotate(int16_t *out, int32_t re, int32_t im, uint16_t index)
+{
+	int32_t c = fft_sine[index + FFT_QUARTER];
+	int32_t s = fft_sine[index];
+
+	out[0] = fixmath_sat16(((re * c) + (im * s) + FFT_TWIDDLE_ROUND) >> FFT_TWIDDLE_SHIFT);
+	out[1] = fixmath_sat16(((im * c) - (re * s) + FFT_TWIDDLE_ROUND) >> FFT_TWIDDLE_SHIFT);
+} // fft_rotate()
+
+
+/*******************************************************************************
+ * Function:        static void fft_radix4(int16_t *data, uint16_t n,
+ *                                         uint16_t span)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Data, transform size and butterfly span
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        One decimation in frequency radix-4 stage. Each butterfly
+ *                  takes x0..x3 a quarter span apart and stores
+ *
+ *                      x0 <- (x0 + x1 + x2 + x3) / 4
+ *                      x1 <- (x0 - x1 + x2 - x3) / 4 W^2j
+ *                      x2 <- (x0 - j x1 - x2 + j x3) / 4 W^j
+ *                      x3 <- (x0 + j x1 - x2 - j x3) / 4 W^3j
+ *
+ *                  The middle two outputs are swapped from the textbook
+ *                  order, which makes the stage equal to two radix-2 stages.
+ *                  The result then comes out in plain bit reversed order and
+ *                  a radix-2 stage can finish odd powers of two.
+ *
+ * Note:            The twiddles of one j are shared by every butterfly of
+ *                  the stage, so the loop runs over j first.
+ *
+ ******************************************************************************/
+static void fft_radix4(int16_t *data, uint16_t n, uint16_t span)
+{
+	uint16_t quarter = span / 4u;
+	uint16_t stride = FFT_SIZE_MAX / span;
+
+	for (uint16_t j = 0; j < quarter; j++)
+	{
+		uint16_t w1 = j * stride;
+
+		for (uint16_t g = j; g < n; g += span)
+		{
+			int16_t *x0 = &data[2u * g];
+			int16_t *x1 = x0 + (2u * quarter);
+			int16_t *x2 = x1 + (2u * quarter);
+			int16_t *x3 = x2 + (2u * quarter);
+
+			int32_t a_re = (int32_t)x0[0] + x2[0];
+			int32_t a_im = (int32_t)x0[1] + x2[1];
+			int32_t b_re = (int32_t)x1[0] + x3[0];
+			int32_t b_im = (int32_t)x1[1] + x3[1];
+			int32_t c_re = (int32_t)x0[0] - x2[0];
+			int32_t c_im = (int32_t)x0[1] - x2[1];
+			int32_t d_re = (int32_t)x1[0] - x3[0];
+			int32_t d_im = (int32_t)x1[1] - x3[1];
+
+			x0[0] = (int16_t)((a_re + b_re + 2) >> 2);
+			x0[1] = (int16_t)((a_im + b_im + 2) >> 2);
+
+			if (j == 0)
+			{
+				// W = 1
+				x1[0] = (int16_t)((a_re - b_re + 2) >> 2);
+				x1[1] = (int16_t)((a_im - b_im + 2) >> 2);
+				x2[0] = (int16_t)((c_re + d_im + 2) >> 2);
+				x2[1] = (int16_t)((c_im - d_re + 2) >> 2);
+				x3[0] = (int16_t)((c_re - d_im + 2) >> 2);
+				x3[1] = (int16_t)((c_im + d_re + 2) >> 2);
+			}
+			else
+			{
+				fft_rotate(x1, (a_re - b_re + 2) >> 2, (a_im - b_im + 2) >> 2, 2u * w1);
+				fft_rotate(x2, (c_re + d_im + 2) >> 2, (c_im - d_re + 2) >> 2, w1);
+				fft_rotate(x3, (c_re - d_im + 2) >> 2, (c_im + d_re + 2) >> 2, 3u * w1);
+			}
+		}
+	}
+} // fft_radix4()
+
+
+/*******************************************************************************
+ * Function:        static void fft_radix2(int16_t *data, uint16_t n)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Data and transform size
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Last stage for odd powers of two: adjacent pairs, halved.
+ *                  At a span of 2 every twiddle is 1.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void fft_radix2(int16_t *data, uint16_t n)
+{
+	for (uint16_t i = 0; i < (2u * n); i += 4u)
+	{
+		int32_t re0 = data[i];
+		int32_t im0 = data[i + 1u];
+		int32_t re1 = data[i + 2u];
+		int32_t im1 = data[i + 3u];
+
+		data[i] = (int16_t)((re0 + re1 + 1) >> 1);
+		data[i + 1u] = (int16_t)((im0 + im1 + 1) >> 1);
+		data[i + 2u] = (int16_t)((re0 - re1 + 1) >> 1);
+		data[i + 3u] = (int16_t)((im0 - im1 + 1) >> 1);
+	}
+} // fft_radix2()
+
+
+/*******************************************************************************
+ * Function:        bool fft_q15(int16_t *data, uint16_t n)
+ *
+ * PreCondition:    None
+ *
+ * Input:           n complex Q15 values as re, im pairs, and n
+ *
+ * Output:          false if n is not a power of two in
+ *                  FFT_SIZE_MIN..FFT_SIZE_MAX, data is then left alone
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Radix-4 stages down to a span of 4 (or 2, finished with
+ *                  a radix-2 stage), then the bit reversed result is put in
+ *                  natural order by swapping through fft_bitrev. Every stage
+ *                  scales by its radix so nothing can overflow, and the
+ *                  output is X[k] / n. The only memory used is data itself.
+ *
+ * Note:            Scaling by 1/n costs log2(n) / 2 bits of a weak input; a
+ *                  caller with small signals should shift them up to use the
+ *                  Q15 range first.
+ *
+ ******************************************************************************/
+bool fft_q15(int16_t *data, uint16_t n)
+{
+	uint8_t log2n = 0;
+
+	while ((1u << log2n) < n)
+	{
+		log2n++;
+	}
+
+	if ((n < FFT_SIZE_MIN) || (n > FFT_SIZE_MAX) || ((1u << log2n) != n))
+	{
+		return false;
+	}
+
+	uint16_t span = n;
+	for (; span >= 4u; span /= 4u)
+	{
+		fft_radix4(data, n, span);
+	}
+	if (span == 2u)
+	{
+		fft_radix2(data, n);
+	}
+
+	uint8_t shift = FFT_LOG2_MAX - log2n;
+	for (uint16_t i = 0; i < n; i++)
+	{
+		uint16_t r = fft_bitrev[i] >> shift;
+
+		if (i < r)
+		{
+			int16_t re = data[2u * i];
+			int16_t im = data[(2u * i) + 1u];
+
+			data[2u * i] = data[2u * r];
+			data[(2u * i) + 1u] = data[(2u * r) + 1u];
+			data[2u * r] = re;
+			data[(2u * r) + 1u] = im;
+		}
+	}
+
+	return true;
+} // fft_q15()
@@ -0,0 +1,27 @@
+#ifndef FFT_H_
+#define FFT_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "fft_tables.h"
+#include <stdbool.h>
+
+// Smallest transform
+#define FFT_SIZE_MIN              (4u)
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def fft_q15
+ * \brief In-place complex FFT scaled by 1/n, returns false if n is not supported
+ * \param data (n complex Q15 values as re, im pairs, replaced by X[k] / n in natural order)
+ * \param n (power of two, FFT_SIZE_MIN..FFT_SIZE_MAX)
+ */
+bool fft_q15(int16_t *data, uint16_t n);
+
+
+#endif /* FFT_H_ */
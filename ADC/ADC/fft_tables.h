@@ -0,0 +1,22 @@
+#ifndef FFT_TABLES_H_
+#define FFT_TABLES_H_
+
+// Generated by ADC/tools/gen_fft.py, do not edit. To regenerate:
+// python3 ADC/tools/gen_fft.py --size 1024
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+// Largest transform and its log2
+#define FFT_SIZE_MAX              (1024u)
+#define FFT_LOG2_MAX              (10u)
+
+// sin(2 pi i / FFT_SIZE_MAX) in Q15
+#define FFT_TWIDDLE_SHIFT         (15u)
+
+extern const int16_t fft_sine[FFT_SIZE_MAX];
+extern const uint16_t fft_bitrev[FFT_SIZE_MAX];
+
+#endif /* FFT_TABLES_H_ */
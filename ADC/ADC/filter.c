@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "filter.h"
+
+#define FILTER_BIQUAD_MASK     ((1u << FILTER_BIQUAD_SHIFT) - 1u)
+#define FILTER_FIR_ROUND       (1l << (FILTER_FIR_SHIFT - 1u))
+
+
+/*******************************************************************************
+ * Function:        int16_t filter_biquad(const int16_t *coeffs,
+ *                                        filter_biquad_t *section, int16_t x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Q14 coefficients, section state and one input sample
+ *
+ * Output:          Filtered sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Direct form I:
+ *
+ *                      y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2
+ *
+ *                  Five 16x16 multiplies (a single MULS each on Thumb-1) into
+ *                  a 64-bit accumulator, each add an ADDS/ADCS pair. The
+ *                  fraction dropped when shifting back to 16 bits is added to
+ *                  the next sample (first order error feedback), which keeps
+ *                  the rounding noise of poles close to z = 1 out of the low
+ *                  frequency band.
+ *
+ * Note:            Full scale noise drives the high-pass sums past 2^31. A
+ *                  32-bit sum would wrap there and saturate to the wrong
+ *                  rail, the 64-bit one saturates as the exact sum would
+ *
+ ******************************************************************************/
+int16_t filter_biquad(const int16_t *coeffs, filter_biquad_t *section, int16_t x)
+{
+	int64_t acc = section->err;
+
+	acc += (int32_t)coeffs[0] * x;
+	acc += (int32_t)coeffs[1] * section->x1;
+	acc += (int32_t)coeffs[2] * section->x2;
+	acc -= (int32_t)coeffs[3] * section->y1;
+	acc -= (int32_t)coeffs[4] * section->y2;
+
+	section->err = (uint16_t)(acc & FILTER_BIQUAD_MASK);
+	int16_t y = fixmath_sat16((int32_t)(acc >> FILTER_BIQUAD_SHIFT));
+
+	section->x2 = section->x1;
+	section->x1 = x;
+	section->y2 = section->y1;
+	section->y1 = y;
+
+	return y;
+} // filter_biquad()
+
+
+/*******************************************************************************
+ * Function:        void filter_bandpass_init(filter_bandpass_t *filter)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Band-pass state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears every section.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void filter_bandpass_init(filter_bandpass_t *filter)
+{
+	for (uint8_t i = 0; i < FILTER_BIQUAD_SECTIONS; i++)
+	{
+		filter->section[i] = (filter_biquad_t){ 0 };
+	}
+} // filter_bandpass_init()
+
+
+/*******************************************************************************
+ * Function:        int16_t filter_bandpass(filter_bandpass_t *filter, int16_t x)
+ *
+ * PreCondition:    filter_bandpass_init() has been called
+ *
+ * Input:           Band-pass state and one input sample
+ *
+ * Output:          Filtered sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function runs the cascade in table order, high-pass
+ *                  sections first so the DC is gone before the gain of the
+ *                  low-pass sections is applied.
+ *
+ * Note:            The coefficients only suit the FILTER_SAMPLE_RATE_HZ rate
+ *
+ ******************************************************************************/
+int16_t filter_bandpass(filter_bandpass_t *filter, int16_t x)
+{
+	const int16_t *coeffs = &filter_bandpass_coeffs[0][0];
+	filter_biquad_t *section = filter->section;
+
+	for (uint8_t i = 0; i < FILTER_BIQUAD_SECTIONS; i++)
+	{
+		x = filter_biquad(coeffs, section++, x);
+		coeffs += FILTER_BIQUAD_COEFFS;
+	}
+
+	return x;
+} // filter_bandpass()
+
+
+/*******************************************************************************
+ * Function:        void filter_fir_init(filter_fir_t *filter)
+ *
+ * PreCondition:    None
+ *
+ * Input:           FIR state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the delay line.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void filter_fir_init(filter_fir_t *filter)
+{
+	for (uint8_t i = 0; i < (2u * FILTER_FIR_TAPS); i++)
+	{
+		filter->line[i] = 0;
+	}
+	filter->pos = 0;
+} // filter_fir_init()
+
+
+/*******************************************************************************
+ * Function:        int16_t filter_fir(filter_fir_t *filter, int16_t x)
+ *
+ * PreCondition:    filter_fir_init() has been called
+ *
+ * Input:           FIR state and one input sample
+ *
+ * Output:          Filtered sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The newest sample is written at pos and pos + TAPS, so
+ *                  line[pos .. pos + TAPS - 1] always holds the taps from the
+ *                  newest to the oldest. The kernel is linear phase, so the
+ *                  two samples sharing a coefficient are added first, which
+ *                  halves the multiplies and coefficient loads.
+ *
+ * Note:            Result is rounded, DC gain is exactly 1
+ *
+ ******************************************************************************/
+int16_t filter_fir(filter_fir_t *filter, int16_t x)
+{
+	if (filter->pos == 0)
+	{
+		filter->pos = FILTER_FIR_TAPS;
+	}
+	filter->pos--;
+
+	filter->line[filter->pos] = x;
+	filter->line[filter->pos + FILTER_FIR_TAPS] = x;
+
+	const int16_t *newest = &filter->line[filter->pos];
+	const int16_t *oldest = newest + (FILTER_FIR_TAPS - 1u);
+	const int16_t *coeffs = filter_fir_coeffs;
+	int32_t acc = FILTER_FIR_ROUND;
+
+	for (uint8_t i = 0; i < (FILTER_FIR_TAPS / 2u); i++)
+	{
+		acc += ((int32_t)*newest++ + *oldest--) * *coeffs++;
+	}
+	acc += (int32_t)*newest * *coeffs;
+
+	return fixmath_sat16(acc >> FILTER_FIR_SHIFT);
+} // filter_fir()
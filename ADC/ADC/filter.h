@@ -0,0 +1,85 @@
+#ifndef FILTER_H_
+#define FILTER_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include "fixmath.h"
+#include "filter_coeffs.h"
+
+// One biquad section, direct form I
+typedef struct
+{
+	int16_t x1, x2;      // last two inputs
+	int16_t y1, y2;      // last two outputs
+	uint16_t err;        // fraction dropped from the last output (error feedback)
+} filter_biquad_t;
+
+// Band-pass cascade from filter_bandpass_coeffs
+typedef struct
+{
+	filter_biquad_t section[FILTER_BIQUAD_SECTIONS];
+} filter_bandpass_t;
+
+// Smoothing FIR from filter_fir_coeffs. Each sample is stored twice, so the
+// taps are always one contiguous run and the kernel never checks for a wrap.
+typedef struct
+{
+	int16_t line[2u * FILTER_FIR_TAPS];
+	uint8_t pos;
+} filter_fir_t;
+
+// The FIR is linear phase, every frequency comes out this many samples late
+#define FILTER_FIR_DELAY          ((FILTER_FIR_TAPS - 1u) / 2u)
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def filter_biquad
+ * \brief Runs one sample through one biquad section
+ * \param coeffs (b0, b1, b2, a1, a2 in Q14)
+ * \param section (section state)
+ * \param x (input sample)
+ */
+int16_t filter_biquad(const int16_t *coeffs, filter_biquad_t *section, int16_t x);
+
+
+/**
+ * \def filter_bandpass_init
+ * \brief Clears the band-pass cascade state
+ * \param filter (band-pass state)
+ */
+void filter_bandpass_init(filter_bandpass_t *filter);
+
+
+/**
+ * \def filter_bandpass
+ * \brief Runs one sample through the generated band-pass cascade
+ * \param filter (band-pass state)
+ * \param x (input sample)
+ */
+int16_t filter_bandpass(filter_bandpass_t *filter, int16_t x);
+
+
+/**
+ * \def filter_fir_init
+ * \brief Clears the FIR delay line
+ * \param filter (FIR state)
+ */
+void filter_fir_init(filter_fir_t *filter);
+
+
+/**
+ * \def filter_fir
+ * \brief Runs one sample through the generated smoothing FIR
+ * \param filter (FIR state)
+ * \param x (input sample)
+ */
+int16_t filter_fir(filter_fir_t *filter, int16_t x);
+
+
+#endif /* FILTER_H_ */
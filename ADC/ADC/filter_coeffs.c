@@ -0,0 +1,51 @@
+// Generated by ADC/tools/gen_filter.py, do not edit. To regenerate:
+// python3 ADC/tools/gen_filter.py --fs 100 --low 0.5 --high 5 --order 4 --fir-taps 31 --fir-high 10 --goertzel-decim 4 --bpm-min 30 --bpm-max 240 --bpm-step 1
+
+#include "filter_coeffs.h"
+
+const int16_t filter_bandpass_coeffs[FILTER_BIQUAD_SECTIONS][FILTER_BIQUAD_COEFFS] =
+{
+	{  16185, -32370,  16185, -32363,  15995 },  // high-pass 0.50 Hz, Q 1.3066
+	{  15918, -31836,  15918, -31828,  15460 },  // high-pass 0.50 Hz, Q 0.5412
+	{    358,    716,    358, -27869,  12919 },  // low-pass 5.00 Hz, Q 1.3066
+	{    312,    624,    312, -24243,   9107 }   // low-pass 5.00 Hz, Q 0.5412
+};
+
+const int16_t filter_fir_coeffs[FILTER_FIR_TAPS] =
+{
+	    0,    39,    91,   139,   129,     0,  -271,  -609,
+	 -832,  -696,     0,  1297,  3011,  4755,  6059,  6544,
+	 6059,  4755,  3011,  1297,     0,  -696,  -832,  -609,
+	 -271,     0,   129,   139,    91,    39,     0
+};
+
+const int16_t filter_goertzel_coeffs[FILTER_GOERTZEL_BINS] =
+{
+	32510, 32492, 32474, 32455, 32436, 32416, 32396, 32375,  // 30 bpm
+	32354, 32332, 32309, 32286, 32262, 32238, 32213, 32188,  // 38 bpm
+	32162, 32135, 32108, 32080, 32052, 32023, 31994, 31964,  // 46 bpm
+	31933, 31902, 31871, 31838, 31806, 31772, 31739, 31704,  // 54 bpm
+	31669, 31634, 31598, 31561, 31524, 31486, 31448, 31409,  // 62 bpm
+	31369, 31329, 31289, 31248, 31206, 31164, 31122, 31078,  // 70 bpm
+	31035, 30990, 30945, 30900, 30854, 30807, 30760, 30713,  // 78 bpm
+	30665, 30616, 30567, 30517, 30467, 30416, 30365, 30313,  // 86 bpm
+	30261, 30208, 30154, 30100, 30046, 29991, 29935, 29879,  // 94 bpm
+	29822, 29765, 29708, 29649, 29591, 29531, 29472, 29411,  // 102 bpm
+	29351, 29289, 29228, 29165, 29102, 29039, 28975, 28911,  // 110 bpm
+	28846, 28781, 28715, 28648, 28582, 28514, 28446, 28378,  // 118 bpm
+	28309, 28240, 28170, 28099, 28029, 27957, 27885, 27813,  // 126 bpm
+	27740, 27667, 27593, 27519, 27444, 27369, 27293, 27217,  // 134 bpm
+	27140, 27063, 26986, 26907, 26829, 26750, 26670, 26590,  // 142 bpm
+	26510, 26429, 26348, 26266, 26183, 26101, 26017, 25934,  // 150 bpm
+	25850, 25765, 25680, 25595, 25509, 25422, 25335, 25248,  // 158 bpm
+	25160, 25072, 24984, 24895, 24805, 24715, 24625, 24534,  // 166 bpm
+	24443, 24351, 24259, 24167, 24074, 23981, 23887, 23793,  // 174 bpm
+	23698, 23603, 23508, 23412, 23316, 23219, 23122, 23024,  // 182 bpm
+	22927, 22828, 22730, 22631, 22531, 22431, 22331, 22230,  // 190 bpm
+	22129, 22028, 21926, 21824, 21721, 21618, 21515, 21411,  // 198 bpm
+	21307, 21203, 21098, 20993, 20887, 20781, 20675, 20568,  // 206 bpm
+	20461, 20354, 20246, 20138, 20029, 19921, 19812, 19702,  // 214 bpm
+	19592, 19482, 19371, 19261, 19149, 19038, 18926, 18814,  // 222 bpm
+	18701, 18588, 18475, 18362, 18248, 18134, 18019, 17904,  // 230 bpm
+	17789, 17674, 17558  // 238 bpm
+};
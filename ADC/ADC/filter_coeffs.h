@@ -0,0 +1,34 @@
+#ifndef FILTER_COEFFS_H_
+#define FILTER_COEFFS_H_
+
+// Generated by ADC/tools/gen_filter.py, do not edit. To regenerate:
+// python3 ADC/tools/gen_filter.py --fs 100 --low 0.5 --high 5 --order 4 --fir-taps 31 --fir-high 10 --goertzel-decim 4 --bpm-min 30 --bpm-max 240 --bpm-step 1
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+// fs 100 Hz, pass band 0.5-5 Hz, order 4, 31 FIR taps to 10 Hz
+#define FILTER_SAMPLE_RATE_HZ     (100u)
+
+// Band-pass biquads: b0, b1, b2, a1, a2 in Q14 (a0 = 1)
+#define FILTER_BIQUAD_SHIFT       (14u)
+#define FILTER_BIQUAD_COEFFS      (5u)
+#define FILTER_BIQUAD_SECTIONS    (4u)
+
+// Smoothing FIR in Q15, symmetric
+#define FILTER_FIR_SHIFT          (15u)
+#define FILTER_FIR_TAPS           (31u)
+
+// Goertzel bank at 25 Hz: 2 cos(w) in Q14 for 30-240 bpm in 1 bpm steps
+#define FILTER_GOERTZEL_DECIM     (4u)
+#define FILTER_GOERTZEL_BPM_MIN   (30u)
+#define FILTER_GOERTZEL_BPM_STEP  (1u)
+#define FILTER_GOERTZEL_BINS      (211u)
+
+extern const int16_t filter_bandpass_coeffs[FILTER_BIQUAD_SECTIONS][FILTER_BIQUAD_COEFFS];
+extern const int16_t filter_fir_coeffs[FILTER_FIR_TAPS];
+extern const int16_t filter_goertzel_coeffs[FILTER_GOERTZEL_BINS];
+
+#endif /* FILTER_COEFFS_H_ */
@@ -0,0 +1,288 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "fixmath.h"
+
+// Table steps: 32 segments per octave
+#define FIXMATH_TABLE_BITS        (5u)
+
+// log2(1 + i/32) in Q16
+static const uint32_t fixmath_log2_table[(1u << FIXMATH_TABLE_BITS) + 1u] =
+{
+	0, 2909, 5732, 8473, 11136, 13727, 16248, 18704,
+	21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346,
+	38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207,
+	52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047,
+	65536
+};
+
+// 2^(i/32) in Q16
+static const uint32_t fixmath_exp2_table[(1u << FIXMATH_TABLE_BITS) + 1u] =
+{
+	65536, 66971, 68438, 69936, 71468, 73032, 74632, 76266,
+	77936, 79642, 81386, 83169, 84990, 86851, 88752, 90696,
+	92682, 94711, 96785, 98905, 101070, 103283, 105545, 107856,
+	110218, 112631, 115098, 117618, 120194, 122825, 125515, 128263,
+	131072
+};
+
+
+/*******************************************************************************
+ * Function:        int32_t fixmath_mul_q31(int32_t a, int32_t b)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Two Q31 values
+ *
+ * Output:          Q31 product
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The signed 64-bit product is built from the unsigned high
+ *                  word (fixmath_umulhi) with the usual sign correction, then
+ *                  shifted left by one with the top bit of the low word.
+ *                  This avoids the libgcc 64-bit multiply.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+int32_t fixmath_mul_q31(int32_t a, int32_t b)
+{
+	if ((a == INT32_MIN) && (b == INT32_MIN))
+	{
+		return INT32_MAX;
+	}
+
+	uint32_t hi = fixmath_umulhi((uint32_t)a, (uint32_t)b);
+	uint32_t lo = (uint32_t)a * (uint32_t)b;
+
+	if (a < 0) hi -= (uint32_t)b;
+	if (b < 0) hi -= (uint32_t)a;
+
+	return (int32_t)((hi << 1) | (lo >> 31));
+} // fixmath_mul_q31()
+
+
+/*******************************************************************************
+ * Function:        int32_t fixmath_mac_q31(int32_t acc, int32_t a, int32_t b)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Q31 accumulator and two Q31 values
+ *
+ * Output:          acc + a * b, saturated
+ *
+ * Side Effects:    None
+ *
+ * Overview:        None
+ *
+ * Note:
+ *
+ ******************************************************************************/
+int32_t fixmath_mac_q31(int32_t acc, int32_t a, int32_t b)
+{
+	return fixmath_add_sat32(acc, fixmath_mul_q31(a, b));
+} // fixmath_mac_q31()
+
+
+/*******************************************************************************
+ * Function:        void fixmath_recip_init(fixmath_recip_t *recip, uint32_t d)
+ *
+ * PreCondition:    d is not 0
+ *
+ * Input:           Divisor
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Same multiplier as FIXMATH_RECIP, for divisors that are
+ *                  fixed for a while (frame rate, block length) but not known
+ *                  at compile time. Costs one 64-bit division, every
+ *                  fixmath_div() after it costs none.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void fixmath_recip_init(fixmath_recip_t *recip, uint32_t d)
+{
+	uint8_t l = 0;
+	while ((l < 32u) && ((1ull << l) < d))
+	{
+		l++;
+	}
+
+	recip->mul = (uint32_t)((((1ull << 32) * ((1ull << l) - d)) / d) + 1u);
+	recip->shift1 = (l != 0) ? 1u : 0u;
+	recip->shift2 = (l != 0) ? (uint8_t)(l - 1u) : 0u;
+} // fixmath_recip_init()
+
+
+/*******************************************************************************
+ * Function:        uint8_t fixmath_clz32(uint32_t x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Value
+ *
+ * Output:          Number of leading zero bits
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Binary search in five compares, instead of the libgcc
+ *                  __clzsi2 call that __builtin_clz becomes on ARMv6-M.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint8_t fixmath_clz32(uint32_t x)
+{
+	uint8_t n = 0;
+
+	if (x == 0)
+	{
+		return 32;
+	}
+
+	if (x <= 0x0000FFFFu) { n += 16; x <<= 16; }
+	if (x <= 0x00FFFFFFu) { n += 8; x <<= 8; }
+	if (x <= 0x0FFFFFFFu) { n += 4; x <<= 4; }
+	if (x <= 0x3FFFFFFFu) { n += 2; x <<= 2; }
+	if (x <= 0x7FFFFFFFu) { n += 1; }
+
+	return n;
+} // fixmath_clz32()
+
+
+/*******************************************************************************
+ * Function:        uint16_t fixmath_isqrt32(uint32_t x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Value
+ *
+ * Output:          floor(sqrt(x))
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Digit by digit square root, one result bit per step with
+ *                  shifts, adds and compares only. At most 16 steps.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint16_t fixmath_isqrt32(uint32_t x)
+{
+	uint32_t root = 0;
+	uint32_t bit = 1ul << 30;
+
+	while (bit > x)
+	{
+		bit >>= 2;
+	}
+
+	while (bit != 0)
+	{
+		if (x >= (root + bit))
+		{
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint16_t)root;
+} // fixmath_isqrt32()
+
+
+/*******************************************************************************
+ * Function:        int32_t fixmath_log2_q16(uint32_t x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Value
+ *
+ * Output:          log2(x) in Q16
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The integer part is the position of the top bit. The
+ *                  mantissa, normalised to 1.xxx, is interpolated linearly in
+ *                  a 33 entry table: the next 5 bits pick the entry, the 16
+ *                  after them the position between entries.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+int32_t fixmath_log2_q16(uint32_t x)
+{
+	if (x == 0)
+	{
+		return INT32_MIN;
+	}
+
+	uint8_t clz = fixmath_clz32(x);
+	uint32_t m = x << clz;
+	uint32_t index = (m >> (31u - FIXMATH_TABLE_BITS)) & ((1u << FIXMATH_TABLE_BITS) - 1u);
+	uint32_t frac = (m >> (15u - FIXMATH_TABLE_BITS)) & 0xFFFFu;
+	uint32_t step = fixmath_log2_table[index + 1u] - fixmath_log2_table[index];
+
+	return ((int32_t)(31u - clz) * FIXMATH_Q16_ONE) +
+		(int32_t)(fixmath_log2_table[index] + ((step * frac) >> 16));
+} // fixmath_log2_q16()
+
+
+/*******************************************************************************
+ * Function:        uint32_t fixmath_exp2_q16(int32_t x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Exponent in Q16
+ *
+ * Output:          2^x in Q16
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The fraction of x is interpolated in a 33 entry table of
+ *                  2^(i/32), the integer part becomes a shift. A right shift
+ *                  rounds, so the result is within half an LSB of the
+ *                  mantissa it came from.
+ *
+ * Note:            The chord between table entries lies above the curve by
+ *                  up to 6.3e-5, about 8 LSB of the mantissa. A right shift
+ *                  divides that, so measured over every Q16 input the error
+ *                  is within 1.2e-4 relative for x >= -3 (1.4 LSB on
+ *                  [-3, -2)) and within 1 LSB below x = -3, which is 0.2 %
+ *                  at x = -8 and 3 % at x = -12. Results under 2^-17 come
+ *                  out as 0, over 65535.99 as UINT32_MAX
+ *
+ ******************************************************************************/
+uint32_t fixmath_exp2_q16(int32_t x)
+{
+	int32_t whole = x >> 16;
+	uint32_t frac = (uint32_t)x & 0xFFFFu;
+
+	if (whole >= 16)
+	{
+		return UINT32_MAX;
+	}
+	if (whole < -17)
+	{
+		return 0;
+	}
+
+	uint32_t index = frac >> (16u - FIXMATH_TABLE_BITS);
+	uint32_t pos = (frac << FIXMATH_TABLE_BITS) & 0xFFFFu;
+	uint32_t step = fixmath_exp2_table[index + 1u] - fixmath_exp2_table[index];
+	uint32_t mantissa = fixmath_exp2_table[index] + ((step * pos) >> 16);
+
+	if (whole >= 0)
+	{
+		return mantissa << whole;
+	}
+	return (mantissa + (1u << (-whole - 1))) >> -whole;
+} // fixmath_exp2_q16()
@@ -0,0 +1,181 @@
+#ifndef FIXMATH_H_
+#define FIXMATH_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+// Q formats
+#define FIXMATH_Q15_ONE           (32768l)
+#define FIXMATH_Q16_ONE           (65536l)
+
+// Division by an invariant d as a multiply (Granlund-Montgomery). l is
+// ceil(log2(d)), the multiplier is 2^32 * (2^l - d) / d + 1 and is folded
+// by the compiler when d is a constant, eg. FIXMATH_RECIP(750000u, 20u).
+#define FIXMATH_RECIP(d, l)       { (uint32_t)((((1ull << 32) * ((1ull << (l)) - (d))) / (d)) + 1u), \
+                                    ((l) ? 1u : 0u), ((l) ? ((l) - 1u) : 0u) }
+
+// Reciprocal of a divisor
+typedef struct
+{
+	uint32_t mul;
+	uint8_t shift1;
+	uint8_t shift2;
+} fixmath_recip_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def fixmath_sat16
+ * \brief Clamps a value to the int16_t range
+ * \param value (value to clamp)
+ */
+static inline int16_t fixmath_sat16(int32_t value)
+{
+	if (value > INT16_MAX) return INT16_MAX;
+	if (value < INT16_MIN) return INT16_MIN;
+	return (int16_t)value;
+}
+
+
+/**
+ * \def fixmath_add_sat32
+ * \brief Adds two int32_t values, clamping instead of wrapping
+ * \param a (first operand)
+ * \param b (second operand)
+ */
+static inline int32_t fixmath_add_sat32(int32_t a, int32_t b)
+{
+	int32_t sum = (int32_t)((uint32_t)a + (uint32_t)b);
+
+	// Overflow when both operands have the same sign and the sum does not
+	if (((a ^ sum) & (b ^ sum)) < 0)
+	{
+		return (a < 0) ? INT32_MIN : INT32_MAX;
+	}
+	return sum;
+}
+
+
+/**
+ * \def fixmath_umulhi
+ * \brief Upper 32 bits of a 32x32 unsigned product, from four 16x16 MULS
+ * \param a (first operand)
+ * \param b (second operand)
+ */
+static inline uint32_t fixmath_umulhi(uint32_t a, uint32_t b)
+{
+	uint32_t al = a & 0xFFFFu, ah = a >> 16;
+	uint32_t bl = b & 0xFFFFu, bh = b >> 16;
+	uint32_t lh = al * bh;
+	uint32_t hl = ah * bl;
+	uint32_t mid = ((al * bl) >> 16) + (lh & 0xFFFFu) + (hl & 0xFFFFu);
+
+	return (ah * bh) + (lh >> 16) + (hl >> 16) + (mid >> 16);
+}
+
+
+/**
+ * \def fixmath_div
+ * \brief Divides by the divisor of a reciprocal, exact for every uint32_t x
+ * \param x (dividend)
+ * \param recip (from FIXMATH_RECIP or fixmath_recip_init)
+ */
+static inline uint32_t fixmath_div(uint32_t x, const fixmath_recip_t *recip)
+{
+	uint32_t t = fixmath_umulhi(x, recip->mul);
+
+	return (t + ((x - t) >> recip->shift1)) >> recip->shift2;
+}
+
+
+/**
+ * \def fixmath_mul_q15
+ * \brief Rounded Q15 product, -1 x -1 saturates to just under 1
+ * \param a (Q15 operand)
+ * \param b (Q15 operand)
+ */
+static inline int16_t fixmath_mul_q15(int16_t a, int16_t b)
+{
+	return fixmath_sat16((((int32_t)a * b) + (1l << 14)) >> 15);
+}
+
+
+/**
+ * \def fixmath_mac_q15
+ * \brief Adds a Q15 x Q15 product to a Q30 accumulator with saturation
+ * \param acc (Q30 accumulator)
+ * \param a (Q15 operand)
+ * \param b (Q15 operand)
+ */
+static inline int32_t fixmath_mac_q15(int32_t acc, int16_t a, int16_t b)
+{
+	return fixmath_add_sat32(acc, (int32_t)a * b);
+}
+
+
+/**
+ * \def fixmath_mul_q31
+ * \brief Q31 product, truncated, -1 x -1 saturates to just under 1
+ * \param a (Q31 operand)
+ * \param b (Q31 operand)
+ */
+int32_t fixmath_mul_q31(int32_t a, int32_t b);
+
+
+/**
+ * \def fixmath_mac_q31
+ * \brief Adds a Q31 product to a Q31 accumulator with saturation
+ * \param acc (Q31 accumulator)
+ * \param a (Q31 operand)
+ * \param b (Q31 operand)
+ */
+int32_t fixmath_mac_q31(int32_t acc, int32_t a, int32_t b);
+
+
+/**
+ * \def fixmath_recip_init
+ * \brief Computes the reciprocal of a divisor known only at run time (one division)
+ * \param recip (output)
+ * \param d (divisor, not 0)
+ */
+void fixmath_recip_init(fixmath_recip_t *recip, uint32_t d);
+
+
+/**
+ * \def fixmath_clz32
+ * \brief Counts leading zero bits, 32 for 0 (the M0+ has no CLZ instruction)
+ * \param x (value)
+ */
+uint8_t fixmath_clz32(uint32_t x);
+
+
+/**
+ * \def fixmath_isqrt32
+ * \brief Integer square root, floor(sqrt(x))
+ * \param x (value)
+ */
+uint16_t fixmath_isqrt32(uint32_t x);
+
+
+/**
+ * \def fixmath_log2_q16
+ * \brief log2(x) in Q16, within 2e-4, INT32_MIN for 0
+ * \param x (value)
+ */
+int32_t fixmath_log2_q16(uint32_t x);
+
+
+/**
+ * \def fixmath_exp2_q16
+ * \brief 2^x in Q16 for x in Q16, saturates at UINT32_MAX. Relative error within 1.2e-4 for x >= -3, below that within 1 LSB of Q16 (0.2 % at x = -8)
+ * \param x (Q16 exponent)
+ */
+uint32_t fixmath_exp2_q16(int32_t x);
+
+
+#endif /* FIXMATH_H_ */
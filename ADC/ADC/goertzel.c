@@ -0,0 +1,291 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "goertzel.h"
+
+#define GOERTZEL_COEFF_SHIFT   (FILTER_BIQUAD_SHIFT)
+
+
+/*******************************************************************************
+ * Function:        static int32_t goertzel_scale(int32_t c, int32_t s)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Q14 coefficient and resonator output
+ *
+ * Output:          (c * s) >> 14
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The product needs more than 32 bits, so s is split in
+ *                  halves and the two 16x32 products are shifted separately,
+ *                  two MULS instead of a call to the 64-bit multiply.
+ *
+ * Note:            Exact for |s| < 2^29 and 0 <= c < 2^15
+ *
+ ******************************************************************************/
+static int32_t goertzel_scale(int32_t c, int32_t s)
+{
+	int32_t hi = s >> 16;
+	uint32_t lo = (uint32_t)s & 0xFFFFu;
+
+	return (int32_t)(((uint32_t)(c * hi) << (16u - GOERTZEL_COEFF_SHIFT)) +
+		(((uint32_t)c * lo) >> GOERTZEL_COEFF_SHIFT));
+} // goertzel_scale()
+
+
+/*******************************************************************************
+ * Function:        static void goertzel_close(goertzel_t *bank, uint16_t bin)
+ *
+ * PreCondition:    The window of bin is complete
+ *
+ * Input:           Bank state and bin number
+ *
+ * Output:          None
+ *
+ * Side Effects:    The bin's resonator is cleared for the next window
+ *
+ * Overview:        Power of the bin,
+ *
+ *                      |X|^2 = s1^2 + s2^2 - c s1 s2
+ *
+ *                  then kept as the peak if it is the largest so far. Bins
+ *                  close in ascending order, so the peak's neighbours are the
+ *                  previous bin and the next one closed, and no spectrum is
+ *                  stored.
+ *
+ * Note:            Three 64-bit multiplies per bin, once per window
+ *
+ ******************************************************************************/
+static void goertzel_close(goertzel_t *bank, uint16_t bin)
+{
+	int32_t s1 = bank->s1[bin];
+	int32_t s2 = bank->s2[bin];
+	int64_t power = ((int64_t)s1 * s1) + ((int64_t)s2 * s2) -
+		((int64_t)goertzel_scale(filter_goertzel_coeffs[bin], s1) * s2);
+
+	uint64_t p = (power > 0) ? (uint64_t)power : 0;
+
+	if ((bin == 0) || (p > bank->power_peak))
+	{
+		bank->peak_bin = bin;
+		bank->power_peak = p;
+		bank->power_left = bank->power_prev;
+		bank->power_right = 0;
+	}
+	else if (bin == (bank->peak_bin + 1u))
+	{
+		bank->power_right = p;
+	}
+
+	bank->power_prev = p;
+	bank->power_total += p;
+	bank->s1[bin] = 0;
+	bank->s2[bin] = 0;
+} // goertzel_close()
+
+
+/*******************************************************************************
+ * Function:        static void goertzel_estimate(goertzel_t *bank)
+ *
+ * PreCondition:    Every bin of the window has been closed
+ *
+ * Input:           Bank state
+ *
+ * Output:          None
+ *
+ * Side Effects:    The peak search is cleared
+ *
+ * Overview:        Fits a parabola through the peak bin and its neighbours
+ *                  for a rate finer than the bin spacing,
+ *
+ *                      d = (L - R) / (2 (L - 2P + R))   bins, |d| <= 1/2
+ *
+ *                  and rates the estimate by the share of the total power in
+ *                  the peak's main lobe. A clean pulse puts most of its
+ *                  power there; motion spreads it over the band.
+ *
+ * Note:            The two divisions run once per window
+ *
+ ******************************************************************************/
+static void goertzel_estimate(goertzel_t *bank)
+{
+	int32_t bpm_x10 = (int32_t)(FILTER_GOERTZEL_BPM_MIN + (bank->peak_bin * FILTER_GOERTZEL_BPM_STEP)) * 10;
+
+	if (bank->power_total == 0)
+	{
+		bank->valid = false;
+	}
+	else
+	{
+		// Edge bins have one neighbour only and are not interpolated
+		if ((bank->peak_bin != 0) && (bank->peak_bin != (FILTER_GOERTZEL_BINS - 1u)))
+		{
+			int64_t left = (int64_t)(bank->power_left >> 2);
+			int64_t right = (int64_t)(bank->power_right >> 2);
+			int64_t curve = (2 * (int64_t)(bank->power_peak >> 2)) - left - right;
+
+			if (curve > 0)
+			{
+				int32_t d_x10 = (int32_t)((5 * (right - left)) / curve);
+
+				if (d_x10 > 5) d_x10 = 5;
+				if (d_x10 < -5) d_x10 = -5;
+				bpm_x10 += d_x10 * (int32_t)FILTER_GOERTZEL_BPM_STEP;
+			}
+		}
+
+		// The main lobe of a pure tone covers 60 / (window_s * step) bins,
+		// which is also how many times its total exceeds its peak
+		uint64_t peak = bank->power_peak;
+		uint64_t total = bank->power_total;
+		while (total >= (1ull << 40))
+		{
+			peak >>= 8;
+			total >>= 8;
+		}
+		uint64_t purity = (peak * (100u * 60u * GOERTZEL_RATE_HZ)) /
+			(total * bank->window * FILTER_GOERTZEL_BPM_STEP);
+
+		bank->bpm_x10 = (uint16_t)bpm_x10;
+		bank->purity = (uint8_t)((purity > 100u) ? 100u : purity);
+		bank->valid = true;
+	}
+
+	bank->power_prev = 0;
+	bank->power_peak = 0;
+	bank->power_left = 0;
+	bank->power_right = 0;
+	bank->power_total = 0;
+	bank->peak_bin = 0;
+} // goertzel_estimate()
+
+
+/*******************************************************************************
+ * Function:        void goertzel_init(goertzel_t *bank, uint8_t window_s)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Bank state and window length in seconds
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears every resonator. The window is clamped to
+ *                  1..GOERTZEL_WINDOW_S_MAX seconds.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void goertzel_init(goertzel_t *bank, uint8_t window_s)
+{
+	for (uint16_t i = 0; i < FILTER_GOERTZEL_BINS; i++)
+	{
+		bank->s1[i] = 0;
+		bank->s2[i] = 0;
+	}
+
+	if (window_s < 1u) window_s = 1u;
+	if (window_s > GOERTZEL_WINDOW_S_MAX) window_s = GOERTZEL_WINDOW_S_MAX;
+
+	bank->sum = 0;
+	bank->input = 0;
+	bank->phase = 0;
+	bank->input_valid = false;
+	bank->window = (uint16_t)(window_s * GOERTZEL_RATE_HZ);
+	bank->filled = 0;
+
+	bank->bpm_x10 = 0;
+	bank->purity = 0;
+
+	// Nothing has been closed, this only clears the peak search
+	goertzel_estimate(bank);
+} // goertzel_init()
+
+
+/*******************************************************************************
+ * Function:        bool goertzel_push(goertzel_t *bank, int16_t x)
+ *
+ * PreCondition:    goertzel_init() has been called
+ *
+ * Input:           Bank state and one band-passed pulse sample
+ *
+ * Output:          true when the window closed and bpm_x10/purity were
+ *                  updated (valid tells whether there was any signal)
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Input samples are summed FILTER_GOERTZEL_DECIM at a time
+ *                  into one bank sample. While the next one is summed, the
+ *                  last is fed to one group of bins per call, so each call
+ *                  costs GOERTZEL_GROUP_BINS resonator updates:
+ *
+ *                      s = x + c s1 - s2
+ *
+ *                  rather than a whole spectrum at once. The group that takes
+ *                  the last bank sample of the window also closes its bins,
+ *                  and the estimate is ready after the last group.
+ *
+ * Note:            Bank samples are sums of up to 2^17, and the resonators
+ *                  gain at most 1 / sin(w) per sample, so s stays under 2^29
+ *                  for windows up to GOERTZEL_WINDOW_S_MAX.
+ *
+ ******************************************************************************/
+bool goertzel_push(goertzel_t *bank, int16_t x)
+{
+	bool ready = false;
+	uint8_t group = bank->phase;
+
+	if (bank->input_valid)
+	{
+		uint16_t first = group * GOERTZEL_GROUP_BINS;
+		uint16_t last = first + GOERTZEL_GROUP_BINS;
+		int32_t input = bank->input;
+
+		if (last > FILTER_GOERTZEL_BINS)
+		{
+			last = FILTER_GOERTZEL_BINS;
+		}
+
+		for (uint16_t i = first; i < last; i++)
+		{
+			int32_t s = input + goertzel_scale(filter_goertzel_coeffs[i], bank->s1[i]) - bank->s2[i];
+
+			bank->s2[i] = bank->s1[i];
+			bank->s1[i] = s;
+		}
+
+		if ((bank->filled + 1u) >= bank->window)
+		{
+			for (uint16_t i = first; i < last; i++)
+			{
+				goertzel_close(bank, i);
+			}
+
+			if (group == (GOERTZEL_GROUPS - 1u))
+			{
+				goertzel_estimate(bank);
+				ready = true;
+			}
+		}
+	}
+
+	bank->sum += x;
+
+	if (++bank->phase >= GOERTZEL_GROUPS)
+	{
+		// Every group has taken the previous bank sample
+		if (bank->input_valid && (++bank->filled >= bank->window))
+		{
+			bank->filled = 0;
+		}
+
+		bank->phase = 0;
+		bank->input = bank->sum;
+		bank->input_valid = true;
+		bank->sum = 0;
+	}
+
+	return ready;
+} // goertzel_push()
@@ -0,0 +1,74 @@
+#ifndef GOERTZEL_H_
+#define GOERTZEL_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "filter_coeffs.h"
+#include <stdbool.h>
+
+// The bank runs at FILTER_SAMPLE_RATE_HZ / FILTER_GOERTZEL_DECIM. Its bins are
+// split into as many groups, and one group is updated per input sample.
+#define GOERTZEL_RATE_HZ          (FILTER_SAMPLE_RATE_HZ / FILTER_GOERTZEL_DECIM)
+#define GOERTZEL_GROUPS           (FILTER_GOERTZEL_DECIM)
+#define GOERTZEL_GROUP_BINS       ((FILTER_GOERTZEL_BINS + GOERTZEL_GROUPS - 1u) / GOERTZEL_GROUPS)
+
+// Longest window in seconds. Bins are about 60 / window bpm wide, so a
+// shorter window follows changes faster and a longer one separates closer
+// peaks. The resonators stay in int32 up to this length.
+#define GOERTZEL_WINDOW_S_MAX     (16u)
+
+// Bank state, a pair of resonator outputs per bin
+typedef struct
+{
+	int32_t s1[FILTER_GOERTZEL_BINS];
+	int32_t s2[FILTER_GOERTZEL_BINS];
+
+	// Decimation to the bank rate
+	int32_t sum;             // input samples of the current bank sample
+	int32_t input;           // last complete bank sample
+	uint8_t phase;           // group updated by the next goertzel_push()
+	bool input_valid;
+
+	// Window
+	uint16_t window;         // bank samples per window
+	uint16_t filled;         // bank samples taken in the current window
+
+	// Peak search, bins are closed in ascending order
+	uint64_t power_prev;     // power of the previous bin closed
+	uint64_t power_peak;
+	uint64_t power_left;     // neighbours of the peak
+	uint64_t power_right;
+	uint64_t power_total;
+	uint16_t peak_bin;
+
+	// Last window
+	uint16_t bpm_x10;        // spectral heart rate in 0.1 bpm
+	uint8_t purity;          // share of the window's power around the peak, %
+	bool valid;
+} goertzel_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def goertzel_init
+ * \brief Resets the bank with a window of window_s seconds
+ * \param bank (bank state)
+ * \param window_s (window length in seconds, 1..GOERTZEL_WINDOW_S_MAX)
+ */
+void goertzel_init(goertzel_t *bank, uint8_t window_s);
+
+
+/**
+ * \def goertzel_push
+ * \brief Adds one sample, returns true when a window closed with a new estimate
+ * \param bank (bank state)
+ * \param x (band-passed pulse at FILTER_SAMPLE_RATE_HZ)
+ */
+bool goertzel_push(goertzel_t *bank, int16_t x);
+
+
+#endif /* GOERTZEL_H_ */
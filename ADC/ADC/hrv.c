@@ -0,0 +1,269 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "hrv.h"
+#include "fixmath.h"
+
+// Seconds per bucket of each window
+static const uint16_t hrv_bucket_s[HRV_WINDOW_COUNT] =
+{
+	HRV_WINDOW_1MIN_S / HRV_BUCKETS,
+	HRV_WINDOW_5MIN_S / HRV_BUCKETS,
+	HRV_WINDOW_60MIN_S / HRV_BUCKETS
+};
+
+
+/*******************************************************************************
+ * Function:        static void hrv_sums_add(hrv_sums_t *a, const hrv_sums_t *b)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Sums to add to and sums to add
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        a += b
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void hrv_sums_add(hrv_sums_t *a, const hrv_sums_t *b)
+{
+	a->sum += b->sum;
+	a->sum2 += b->sum2;
+	a->diff2 += b->diff2;
+	a->count += b->count;
+	a->diffs += b->diffs;
+	a->nn50 += b->nn50;
+} // hrv_sums_add()
+
+
+/*******************************************************************************
+ * Function:        static void hrv_sums_sub(hrv_sums_t *a, const hrv_sums_t *b)
+ *
+ * PreCondition:    b has been added to a
+ *
+ * Input:           Sums to subtract from and sums to subtract
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        a -= b, exact since every sum is an integer
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void hrv_sums_sub(hrv_sums_t *a, const hrv_sums_t *b)
+{
+	a->sum -= b->sum;
+	a->sum2 -= b->sum2;
+	a->diff2 -= b->diff2;
+	a->count -= b->count;
+	a->diffs -= b->diffs;
+	a->nn50 -= b->nn50;
+} // hrv_sums_sub()
+
+
+/*******************************************************************************
+ * Function:        void hrv_init(hrv_state_t *hrv)
+ *
+ * PreCondition:    None
+ *
+ * Input:           HRV state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears all buckets and totals.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void hrv_init(hrv_state_t *hrv)
+{
+	for (uint8_t w = 0; w < HRV_WINDOW_COUNT; w++)
+	{
+		hrv_ring_t *ring = &hrv->window[w];
+
+		for (uint8_t b = 0; b < HRV_BUCKETS; b++)
+		{
+			ring->bucket[b] = (hrv_sums_t){ 0 };
+		}
+		ring->total = (hrv_sums_t){ 0 };
+		ring->bucket_s = hrv_bucket_s[w];
+		ring->elapsed_s = 0;
+		ring->head = 0;
+	}
+	hrv->last_ms = 0;
+} // hrv_init()
+
+
+/*******************************************************************************
+ * Function:        void hrv_add(hrv_state_t *hrv, uint16_t interval_ms)
+ *
+ * PreCondition:    hrv_init() has been called
+ *
+ * Input:           HRV state and beat to beat interval
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Builds the interval's terms once and adds them to the
+ *                  current bucket and the total of every window. The
+ *                  successive difference is taken only if the previous
+ *                  interval was added with no gap since.
+ *
+ * Note:            O(1), two multiplies per interval
+ *
+ ******************************************************************************/
+void hrv_add(hrv_state_t *hrv, uint16_t interval_ms)
+{
+	hrv_sums_t beat = { 0 };
+
+	if (interval_ms == 0u)
+	{
+		hrv_gap(hrv);
+		return;
+	}
+
+	beat.sum = interval_ms;
+	beat.sum2 = (uint32_t)interval_ms * interval_ms;
+	beat.count = 1;
+
+	if (hrv->last_ms != 0u)
+	{
+		uint16_t diff = (interval_ms > hrv->last_ms) ? (interval_ms - hrv->last_ms) : (hrv->last_ms - interval_ms);
+
+		beat.diff2 = (uint32_t)diff * diff;
+		beat.diffs = 1;
+		beat.nn50 = (diff > HRV_NN50_MS) ? 1u : 0u;
+	}
+	hrv->last_ms = interval_ms;
+
+	for (uint8_t w = 0; w < HRV_WINDOW_COUNT; w++)
+	{
+		hrv_ring_t *ring = &hrv->window[w];
+
+		hrv_sums_add(&ring->bucket[ring->head], &beat);
+		hrv_sums_add(&ring->total, &beat);
+	}
+} // hrv_add()
+
+
+/*******************************************************************************
+ * Function:        void hrv_gap(hrv_state_t *hrv)
+ *
+ * PreCondition:    None
+ *
+ * Input:           HRV state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Forgets the previous interval so the next one starts a new
+ *                  run of successive differences.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void hrv_gap(hrv_state_t *hrv)
+{
+	hrv->last_ms = 0;
+} // hrv_gap()
+
+
+/*******************************************************************************
+ * Function:        void hrv_second(hrv_state_t *hrv)
+ *
+ * PreCondition:    hrv_init() has been called
+ *
+ * Input:           HRV state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        When a window's current bucket is full the ring moves on,
+ *                  and the oldest bucket, now the current one, is taken out of
+ *                  the total and cleared.
+ *
+ * Note:            O(1) per window
+ *
+ ******************************************************************************/
+void hrv_second(hrv_state_t *hrv)
+{
+	for (uint8_t w = 0; w < HRV_WINDOW_COUNT; w++)
+	{
+		hrv_ring_t *ring = &hrv->window[w];
+
+		if (++ring->elapsed_s < ring->bucket_s)
+		{
+			continue;
+		}
+		ring->elapsed_s = 0;
+		ring->head = (ring->head + 1u) % HRV_BUCKETS;
+
+		hrv_sums_sub(&ring->total, &ring->bucket[ring->head]);
+		ring->bucket[ring->head] = (hrv_sums_t){ 0 };
+	}
+} // hrv_second()
+
+
+/*******************************************************************************
+ * Function:        bool hrv_result(const hrv_state_t *hrv, hrv_window_t window,
+ *                                  hrv_result_t *result)
+ *
+ * PreCondition:    hrv_init() has been called
+ *
+ * Input:           HRV state, window and output
+ *
+ * Output:          true if the window holds at least two intervals
+ *
+ * Side Effects:    None
+ *
+ * Overview:        From the window totals:
+ *
+ *                      SDNN  = sqrt((n SUMx2 - SUMx^2) / (n (n - 1)))
+ *                      RMSSD = sqrt(SUMd2 / m)
+ *                      pNN50 = NN50 / m
+ *
+ *                  with n intervals and m successive differences. The
+ *                  integer sums are exact, so the variance does not suffer
+ *                  the cancellation of the same formula in floating point.
+ *
+ * Note:            Two 64 bit divisions, call at the report rate
+ *
+ ******************************************************************************/
+bool hrv_result(const hrv_state_t *hrv, hrv_window_t window, hrv_result_t *result)
+{
+	const hrv_sums_t *total = &hrv->window[window].total;
+
+	*result = (hrv_result_t){ 0 };
+	result->count = total->count;
+
+	if (total->count < 2u)
+	{
+		return false;
+	}
+
+	// Variance in ms^2, scaled by 100 for 0.1 ms after the root
+	uint32_t n = total->count;
+	uint64_t spread = (n * total->sum2) - ((uint64_t)total->sum * total->sum);
+	uint64_t variance = (spread * 100u) / (n * (n - 1u));
+	result->sdnn_x10 = fixmath_isqrt32((variance > UINT32_MAX) ? UINT32_MAX : (uint32_t)variance);
+
+	if (total->diffs > 0u)
+	{
+		uint64_t mean_square = (total->diff2 * 100u) / total->diffs;
+		result->rmssd_x10 = fixmath_isqrt32((mean_square > UINT32_MAX) ? UINT32_MAX : (uint32_t)mean_square);
+		result->pnn50_x10 = (uint16_t)(((uint32_t)total->nn50 * 1000u) / total->diffs);
+	}
+
+	return true;
+} // hrv_result()
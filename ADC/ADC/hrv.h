@@ -0,0 +1,118 @@
+#ifndef HRV_H_
+#define HRV_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Each window is a ring of this many time buckets. It slides one bucket at a
+// time and always covers between BUCKETS - 1 and BUCKETS of them.
+#define HRV_BUCKETS               (12u)
+
+// Rolling windows in seconds
+#define HRV_WINDOW_1MIN_S         (60u)
+#define HRV_WINDOW_5MIN_S         (300u)
+#define HRV_WINDOW_60MIN_S        (3600u)
+
+// pNN50 threshold in ms
+#define HRV_NN50_MS               (50u)
+
+// Window selection for hrv_result()
+typedef enum
+{
+	HRV_WINDOW_1MIN = 0,
+	HRV_WINDOW_5MIN,
+	HRV_WINDOW_60MIN,
+	HRV_WINDOW_COUNT
+} hrv_window_t;
+
+// Sums over a bucket or a whole window. Being integers, a bucket can be
+// subtracted exactly when it expires, which a floating point running mean
+// and variance (Welford) cannot do.
+typedef struct
+{
+	uint32_t sum;            // intervals, ms
+	uint64_t sum2;           // squared intervals
+	uint64_t diff2;          // squared successive differences
+	uint16_t count;          // intervals
+	uint16_t diffs;          // successive differences
+	uint16_t nn50;           // differences over HRV_NN50_MS
+} hrv_sums_t;
+
+// One rolling window
+typedef struct
+{
+	hrv_sums_t bucket[HRV_BUCKETS];
+	hrv_sums_t total;        // sum of the buckets
+	uint16_t bucket_s;       // seconds per bucket
+	uint16_t elapsed_s;      // seconds into the current bucket
+	uint8_t head;            // current bucket
+} hrv_ring_t;
+
+// HRV state, the same size whatever the window lengths
+typedef struct
+{
+	hrv_ring_t window[HRV_WINDOW_COUNT];
+	uint16_t last_ms;        // previous interval, 0 after a gap
+} hrv_state_t;
+
+// Statistics of one window
+typedef struct
+{
+	uint16_t sdnn_x10;       // SDNN in 0.1 ms
+	uint16_t rmssd_x10;      // RMSSD in 0.1 ms
+	uint16_t pnn50_x10;      // pNN50 in 0.1 %
+	uint16_t count;          // intervals in the window
+} hrv_result_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def hrv_init
+ * \brief Clears every window
+ * \param hrv (HRV state)
+ */
+void hrv_init(hrv_state_t *hrv);
+
+
+/**
+ * \def hrv_add
+ * \brief Adds one beat to beat interval
+ * \param hrv (HRV state)
+ * \param interval_ms (interval in ms, from a beat accepted by the SQI)
+ */
+void hrv_add(hrv_state_t *hrv, uint16_t interval_ms);
+
+
+/**
+ * \def hrv_gap
+ * \brief Marks a missing or rejected beat, no successive difference spans it
+ * \param hrv (HRV state)
+ */
+void hrv_gap(hrv_state_t *hrv);
+
+
+/**
+ * \def hrv_second
+ * \brief Advances the window clocks by one second, expiring old buckets
+ * \param hrv (HRV state)
+ */
+void hrv_second(hrv_state_t *hrv);
+
+
+/**
+ * \def hrv_result
+ * \brief Computes SDNN, RMSSD and pNN50 of a window, returns false with fewer than 2 intervals
+ * \param hrv (HRV state)
+ * \param window (window to report)
+ * \param result (output)
+ */
+bool hrv_result(const hrv_state_t *hrv, hrv_window_t window, hrv_result_t *result);
+
+
+#endif /* HRV_H_ */
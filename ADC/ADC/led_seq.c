@@ -0,0 +1,317 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "led_seq.h"
+#include "adc.h"
+#include "dma.h"
+#include <stddef.h>
+
+// Pattern generator values: both outputs are always overridden (PGE),
+// PGV selects which LED is lit. WO[0] is red, WO[1] is IR.
+#define LED_SEQ_PATT_RED     (TCC_PATT_PGE0 | TCC_PATT_PGE1 | TCC_PATT_PGV0)
+#define LED_SEQ_PATT_IR      (TCC_PATT_PGE0 | TCC_PATT_PGE1 | TCC_PATT_PGV1)
+#define LED_SEQ_PATT_DARK    (TCC_PATT_PGE0 | TCC_PATT_PGE1)
+
+// PATTB written by the DMAC after each overflow. The value written during
+// phase n is loaded at the end of it, so the table runs two phases ahead:
+// red and IR are preloaded by led_seq_start(), the DMAC continues with dark.
+static const uint16_t led_seq_pattern[LED_SEQ_PHASES] =
+{
+	LED_SEQ_PATT_DARK,
+	LED_SEQ_PATT_RED,
+	LED_SEQ_PATT_IR,
+};
+
+// Pattern of each phase, indexed by LED_SEQ_SLOT_x
+static const uint16_t led_seq_slot_pattern[LED_SEQ_PHASES] =
+{
+	LED_SEQ_PATT_RED,
+	LED_SEQ_PATT_IR,
+	LED_SEQ_PATT_DARK,
+};
+
+// ADC trigger point in each phase, in TCC0 ticks
+static uint32_t led_seq_settle = 0;
+
+
+/*******************************************************************************
+ * Function:        static uint32_t led_seq_period(uint16_t frame_rate_hz)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Frame rate in Hz
+ *
+ * Output:          Phase length in TCC0 ticks
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clamps the frame rate to the supported range and converts it
+ *                  into the length of one phase.
+ *
+ * Note:            333 ticks per phase at 1 kHz, 13333 at 25 Hz
+ *
+ ******************************************************************************/
+static uint32_t led_seq_period(uint16_t frame_rate_hz)
+{
+	if (frame_rate_hz < LED_SEQ_RATE_MIN_HZ)
+	{
+		frame_rate_hz = LED_SEQ_RATE_MIN_HZ;
+	}
+	else if (frame_rate_hz > LED_SEQ_RATE_MAX_HZ)
+	{
+		frame_rate_hz = LED_SEQ_RATE_MAX_HZ;
+	}
+
+	return LED_SEQ_TCC_CLK_FREQ / ((uint32_t)frame_rate_hz * LED_SEQ_PHASES);
+} // led_seq_period()
+
+
+/*******************************************************************************
+ * Function:        static void led_seq_set_timing(uint32_t period)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Phase length in TCC0 ticks
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Sets the phase length and places the ADC trigger (CC2
+ *                  match) at the settle delay, kept inside the phase when the
+ *                  phase gets shorter.
+ *
+ * Note:            While TCC0 runs the buffered PERB and CCB2 are written, so
+ *                  both change together at the next overflow and the phase
+ *                  order is kept.
+ *
+ ******************************************************************************/
+static void led_seq_set_timing(uint32_t period)
+{
+	uint32_t settle = led_seq_settle;
+
+	if (settle >= period)
+	{
+		settle = period - 1;
+	}
+
+	if (TCC0->CTRLA.bit.ENABLE)
+	{
+		TCC0->PERB.reg = period - 1;
+		while (TCC0->SYNCBUSY.bit.PERB);
+		TCC0->CCB[2].reg = settle;
+		while (TCC0->SYNCBUSY.bit.CCB2);
+	}
+	else
+	{
+		TCC0->PER.reg = period - 1;
+		while (TCC0->SYNCBUSY.bit.PER);
+		TCC0->CC[2].reg = settle;
+		while (TCC0->SYNCBUSY.bit.CC2);
+	}
+} // led_seq_set_timing()
+
+
+/*******************************************************************************
+ * Function:        void led_seq_init(uint16_t frame_rate_hz, uint16_t settle_us)
+ *
+ * PreCondition:    ClocksInit(), adc_init() and adc_scan_init() have been called
+ *
+ * Input:           Frame rate in Hz, settle delay in microseconds
+ *
+ * Output:          None
+ *
+ * Side Effects:    The ADC only converts on START events from now on
+ *
+ * Overview:        This function sets up the whole red / IR / dark sequence in
+ *                  hardware:
+ *
+ *                  - TCC0 overflows once per phase. Its pattern generator
+ *                    drives WO[0] (red) and WO[1] (IR) directly.
+ *                  - On every overflow the DMAC writes the pattern for the
+ *                    phase after next into PATTB, which TCC0 loads at the
+ *                    following overflow.
+ *                  - The CC2 match, settle_us into each phase, is routed
+ *                    through EVSYS to the ADC START input.
+ *
+ *                  The CPU is not involved per phase or per sample. Each frame
+ *                  gives LED_SEQ_PHASES results in red, IR, dark order.
+ *
+ * Note:            The conversion (including any averaging set by the ADC
+ *                  profile) must finish before the phase ends.
+ *
+ ******************************************************************************/
+void led_seq_init(uint16_t frame_rate_hz, uint16_t settle_us)
+{
+	led_seq_settle = settle_us;
+
+	// Enable APBC clock for TCC0
+	REG_PM_APBCMASK |= PM_APBCMASK_TCC0;
+
+	// Assign the 8 MHz clock to TCC0
+	GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC0_TCC1 |
+		GCLK_CLKCTRL_GEN(GENERIC_CLOCK_GENERATOR_OSC8M) |
+		GCLK_CLKCTRL_CLKEN;
+	while (GCLK->STATUS.bit.SYNCBUSY);
+
+	// Give PA08 and PA09 to TCC0, peripheral function E
+	PORT->Group[LED_RED_PORT].DIRSET.reg = LED_RED_PIN_MASK | LED_IR_PIN_MASK;
+	PORT->Group[LED_RED_PORT].OUTCLR.reg = LED_RED_PIN_MASK | LED_IR_PIN_MASK;
+	PORT->Group[LED_RED_PORT].PINCFG[LED_RED_PIN_NUMBER].reg |= PORT_PINCFG_PMUXEN;
+	PORT->Group[LED_RED_PORT].PMUX[LED_RED_PIN_NUMBER >> 1].bit.PMUXE = PORT_PMUX_PMUXE_E_Val;
+	PORT->Group[LED_IR_PORT].PINCFG[LED_IR_PIN_NUMBER].reg |= PORT_PINCFG_PMUXEN;
+	PORT->Group[LED_IR_PORT].PMUX[LED_IR_PIN_NUMBER >> 1].bit.PMUXO = PORT_PMUX_PMUXO_E_Val;
+
+	// Reset TCC0
+	TCC0->CTRLA.reg = TCC_CTRLA_SWRST;
+	while (TCC0->SYNCBUSY.bit.SWRST);
+
+	// 8 MHz / 8 = 1 MHz, normal PWM so the counter runs 0..PER
+	TCC0->CTRLA.reg = TCC_CTRLA_PRESCALER_DIV8 | TCC_CTRLA_PRESCSYNC_PRESC;
+	TCC0->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;
+	while (TCC0->SYNCBUSY.bit.WAVE);
+
+	led_seq_set_timing(led_seq_period(frame_rate_hz));
+
+	// Both LEDs off until the sequence starts
+	TCC0->PATT.reg = LED_SEQ_PATT_DARK;
+	while (TCC0->SYNCBUSY.bit.PATT);
+
+	// Emit an event on the CC2 match
+	TCC0->EVCTRL.reg = TCC_EVCTRL_MCEO2;
+
+	// DMAC copies the pattern table into PATTB on every overflow, forever
+	dma_init();
+	dma_channel_init(LED_SEQ_DMA_CHANNEL, TCC0_DMAC_ID_OVF, NULL);
+
+	DmacDescriptor *desc = dma_descriptor(LED_SEQ_DMA_CHANNEL);
+	desc->BTCTRL.reg = DMAC_BTCTRL_VALID |
+		DMAC_BTCTRL_BLOCKACT_NOACT |
+		DMAC_BTCTRL_BEATSIZE_HWORD |
+		DMAC_BTCTRL_SRCINC;
+	desc->BTCNT.reg = LED_SEQ_PHASES;
+	desc->SRCADDR.reg = (uint32_t)(led_seq_pattern + LED_SEQ_PHASES);
+	desc->DSTADDR.reg = (uint32_t)&TCC0->PATTB.reg;
+	desc->DESCADDR.reg = (uint32_t)desc;
+
+	// TCC0 MC2 -> EVSYS channel -> ADC START
+	adc_start_event(LED_SEQ_EVSYS_CHANNEL, EVSYS_ID_GEN_TCC0_MCX_2);
+} // led_seq_init()
+
+
+/*******************************************************************************
+ * Function:        void led_seq_set_rate(uint16_t frame_rate_hz)
+ *
+ * PreCondition:    led_seq_init() has been called
+ *
+ * Input:           Frame rate in Hz
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function changes the phase length. While running, the
+ *                  current phase completes at the old rate.
+ *
+ * Note:            The settle delay given to led_seq_init() is kept
+ *
+ ******************************************************************************/
+void led_seq_set_rate(uint16_t frame_rate_hz)
+{
+	led_seq_set_timing(led_seq_period(frame_rate_hz));
+} // led_seq_set_rate()
+
+
+/*******************************************************************************
+ * Function:        void led_seq_start(void)
+ *
+ * PreCondition:    led_seq_init() has been called, ADC DMA is started
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function loads the red pattern for the first phase and
+ *                  the IR pattern for the second, re-arms the pattern DMAC
+ *                  channel at the top of its table and starts TCC0.
+ *
+ * Note:            The first ADC result after this call is a red sample, so
+ *                  start with an empty ADC DMA ring to keep frames aligned.
+ *
+ ******************************************************************************/
+void led_seq_start(void)
+{
+	TCC0->PATT.reg = LED_SEQ_PATT_RED;
+	while (TCC0->SYNCBUSY.bit.PATT);
+	TCC0->PATTB.reg = LED_SEQ_PATT_IR;
+	while (TCC0->SYNCBUSY.bit.PATTB);
+
+	dma_channel_enable(LED_SEQ_DMA_CHANNEL);
+
+	TCC0->CTRLA.reg |= TCC_CTRLA_ENABLE;
+	while (TCC0->SYNCBUSY.bit.ENABLE);
+} // led_seq_start()
+
+
+/*******************************************************************************
+ * Function:        void led_seq_hold(uint8_t slot)
+ *
+ * PreCondition:    led_seq_start() has been called
+ *
+ * Input:           Phase to hold
+ *
+ * Output:          None
+ *
+ * Side Effects:    Frames are no longer red, IR, dark
+ *
+ * Overview:        This function stops the pattern DMAC channel and keeps the
+ *                  LED of one phase lit. TCC0 keeps running, so the ADC is
+ *                  still triggered once per period, every sample now coming
+ *                  from the held phase. Used to probe for a finger at a low
+ *                  rate with one LED.
+ *
+ * Note:            Call led_seq_stop() and led_seq_start() to resume the
+ *                  normal sequence.
+ *
+ ******************************************************************************/
+void led_seq_hold(uint8_t slot)
+{
+	dma_channel_disable(LED_SEQ_DMA_CHANNEL);
+
+	// Override whatever the DMAC left in the buffer as well
+	TCC0->PATTB.reg = led_seq_slot_pattern[slot];
+	while (TCC0->SYNCBUSY.bit.PATTB);
+	TCC0->PATT.reg = led_seq_slot_pattern[slot];
+	while (TCC0->SYNCBUSY.bit.PATT);
+} // led_seq_hold()
+
+
+/*******************************************************************************
+ * Function:        void led_seq_stop(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function stops TCC0 and the pattern DMAC channel and
+ *                  forces both LEDs off.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void led_seq_stop(void)
+{
+	TCC0->CTRLA.reg &= ~TCC_CTRLA_ENABLE;
+	while (TCC0->SYNCBUSY.bit.ENABLE);
+
+	dma_channel_disable(LED_SEQ_DMA_CHANNEL);
+
+	TCC0->PATT.reg = LED_SEQ_PATT_DARK;
+	while (TCC0->SYNCBUSY.bit.PATT);
+} // led_seq_stop()
@@ -0,0 +1,72 @@
+#ifndef LED_SEQ_H_
+#define LED_SEQ_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+// Phases in one frame, and the slot each phase's sample lands in
+#define LED_SEQ_PHASES             (3u)
+#define LED_SEQ_SLOT_RED           (0u)
+#define LED_SEQ_SLOT_IR            (1u)
+#define LED_SEQ_SLOT_DARK          (2u)
+
+// Supported frame rates (one red, one IR and one dark sample per frame)
+#define LED_SEQ_RATE_MIN_HZ        (25u)
+#define LED_SEQ_RATE_MAX_HZ        (1000u)
+
+// EVSYS and DMAC channels used by the sequencer
+#define LED_SEQ_EVSYS_CHANNEL      (1u)
+#define LED_SEQ_DMA_CHANNEL        (1u)
+
+// TCC0 counts OSC8M (GCLK3) divided by 8
+#define LED_SEQ_TCC_CLK_FREQ       (1000000u)
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def led_seq_init
+ * \brief Sets up TCC0 to drive red, IR and dark phases and trigger the ADC in each
+ * \param frame_rate_hz (frames per second, LED_SEQ_RATE_MIN_HZ to LED_SEQ_RATE_MAX_HZ)
+ * \param settle_us (delay from the start of a phase to the ADC trigger)
+ */
+void led_seq_init(uint16_t frame_rate_hz, uint16_t settle_us);
+
+
+/**
+ * \def led_seq_set_rate
+ * \brief Changes the frame rate, takes effect from the next phase
+ * \param frame_rate_hz (frames per second, LED_SEQ_RATE_MIN_HZ to LED_SEQ_RATE_MAX_HZ)
+ */
+void led_seq_set_rate(uint16_t frame_rate_hz);
+
+
+/**
+ * \def led_seq_start
+ * \brief Starts the sequence with the red phase
+ * \param none
+ */
+void led_seq_start(void);
+
+
+/**
+ * \def led_seq_hold
+ * \brief Keeps one phase lit in every period, the ADC is still triggered once per period
+ * \param slot (LED_SEQ_SLOT_RED, LED_SEQ_SLOT_IR or LED_SEQ_SLOT_DARK)
+ */
+void led_seq_hold(uint8_t slot);
+
+
+/**
+ * \def led_seq_stop
+ * \brief Stops the sequence and turns both LEDs off
+ * \param none
+ */
+void led_seq_stop(void);
+
+
+#endif /* LED_SEQ_H_ */
@@ -0,0 +1,450 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "morph.h"
+
+#define MORPH_MASK             (MORPH_BUFFER - 1u)
+
+// Shape sample at an absolute index
+#define MORPH_AT(state, i)     ((int32_t)(state)->shape[(i) & MORPH_MASK])
+
+
+/*******************************************************************************
+ * Function:        static uint32_t morph_crossing(morph_state_t *state,
+ *                                                 uint32_t i, int32_t level)
+ *
+ * PreCondition:    The level is crossed between samples i - 1 and i
+ *
+ * Input:           Extractor state, index after the crossing and level
+ *
+ * Output:          Crossing position in 1/2^MORPH_FRAC_BITS samples
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Linear interpolation between the two samples, rising or
+ *                  falling.
+ *
+ * Note:            One division per crossing
+ *
+ ******************************************************************************/
+static uint32_t morph_crossing(morph_state_t *state, uint32_t i, int32_t level)
+{
+	int32_t a = MORPH_AT(state, i - 1u);
+	int32_t b = MORPH_AT(state, i);
+	uint32_t frac = 0;
+
+	if (b != a)
+	{
+		frac = (uint32_t)(((level - a) * (1l << MORPH_FRAC_BITS)) / (b - a));
+	}
+	return ((i - 1u) << MORPH_FRAC_BITS) + frac;
+} // morph_crossing()
+
+
+/*******************************************************************************
+ * Function:        static uint16_t morph_ms(morph_state_t *state,
+ *                                           uint32_t frac_samples)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Extractor state and a time in 1/2^MORPH_FRAC_BITS samples
+ *
+ * Output:          The time in ms
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Converts a time to ms at the sample rate.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static uint16_t morph_ms(morph_state_t *state, uint32_t frac_samples)
+{
+	return (uint16_t)((frac_samples * 1000u) / ((uint32_t)state->sample_rate_hz << MORPH_FRAC_BITS));
+} // morph_ms()
+
+
+/*******************************************************************************
+ * Function:        static uint32_t morph_tangent(morph_state_t *state,
+ *                                                uint32_t low, uint32_t steep)
+ *
+ * PreCondition:    Samples low to steep are buffered and steep - 1 to steep
+ *                  rises
+ *
+ * Input:           Extractor state, index of the lowest sample before the
+ *                  upstroke and index after its steepest step
+ *
+ * Output:          Foot in 1/2^MORPH_FRAC_BITS samples
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Where the tangent at the steepest step meets the level of
+ *                  the lowest sample. A rounded foot moves the lowest sample
+ *                  about, the tangent much less.
+ *
+ * Note:            One division per beat
+ *
+ ******************************************************************************/
+static uint32_t morph_tangent(morph_state_t *state, uint32_t low, uint32_t steep)
+{
+	int32_t a = MORPH_AT(state, steep - 1u);
+	int32_t b = MORPH_AT(state, steep);
+	int32_t level = MORPH_AT(state, low);
+
+	// From the middle of the step back down to the level
+	uint32_t middle = (steep << MORPH_FRAC_BITS) - (1u << (MORPH_FRAC_BITS - 1u));
+	uint32_t back = (uint32_t)((((a + b) - (2 * level)) * (1l << (MORPH_FRAC_BITS - 1u))) / (b - a));
+
+	return ((middle - (low << MORPH_FRAC_BITS)) > back) ? (middle - back) : (low << MORPH_FRAC_BITS);
+} // morph_tangent()
+
+
+/*******************************************************************************
+ * Function:        static bool morph_analyse(morph_state_t *state,
+ *                                            uint32_t foot_next)
+ *
+ * PreCondition:    state->foot to foot_next is buffered
+ *
+ * Input:           Extractor state and index of the next beat's foot
+ *
+ * Output:          true if state->last was filled
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The beat runs from state->foot to foot_next. A first pass
+ *                  finds the systolic peak S, the highest sample, and so the
+ *                  half amplitude level. A second pass finds:
+ *
+ *                  - foot to S: the rising half amplitude crossing
+ *                  - S to the next foot: the falling crossing, the first
+ *                    minimum followed by a clear rise (dicrotic notch) and
+ *                    the highest sample after it (diastolic peak)
+ *
+ *                  The rise time runs from the tangent foot to S.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool morph_analyse(morph_state_t *state, uint32_t foot_next)
+{
+	uint32_t foot = state->foot;
+	int32_t foot_value = MORPH_AT(state, foot);
+
+	uint32_t peak = foot;
+	for (uint32_t i = foot + 1u; i < foot_next; i++)
+	{
+		if (MORPH_AT(state, i) > MORPH_AT(state, peak))
+		{
+			peak = i;
+		}
+	}
+
+	int32_t amplitude = MORPH_AT(state, peak) - foot_value;
+	int32_t half = foot_value + (amplitude / 2);
+	int32_t hysteresis = amplitude >> MORPH_NOTCH_SHIFT;
+
+	uint32_t rise_cross = 0, fall_cross = 0;
+	bool rise_found = false, fall_found = false;
+
+	uint32_t notch_index = peak;
+	int32_t notch = MORPH_AT(state, peak);
+	int32_t diastole = notch;
+	bool notch_found = false;
+
+	for (uint32_t i = foot + 1u; i <= foot_next; i++)
+	{
+		int32_t x = MORPH_AT(state, i);
+
+		if (i <= peak)
+		{
+			if (!rise_found && (x >= half))
+			{
+				rise_cross = morph_crossing(state, i, half);
+				rise_found = true;
+			}
+			continue;
+		}
+
+		if (!fall_found && (x < half))
+		{
+			fall_cross = morph_crossing(state, i, half);
+			fall_found = true;
+		}
+
+		if (!notch_found)
+		{
+			if (x < notch)
+			{
+				notch = x;
+				notch_index = i;
+			}
+			else if ((x - notch) > hysteresis)
+			{
+				notch_found = true;
+				diastole = x;
+			}
+		}
+		else if (x > diastole)
+		{
+			diastole = x;
+		}
+	}
+
+	if ((amplitude <= 0) || !rise_found || !fall_found || ((peak << MORPH_FRAC_BITS) <= state->foot_frac))
+	{
+		return false;
+	}
+
+	morph_features_t *f = &state->last;
+	f->rise_ms = morph_ms(state, (peak << MORPH_FRAC_BITS) - state->foot_frac);
+	f->width_ms = morph_ms(state, fall_cross - rise_cross);
+
+	// A notch under the foot is baseline drift, not a reflected wave
+	f->notch = notch_found && (notch >= foot_value);
+	if (f->notch)
+	{
+		f->notch_ms = morph_ms(state, (notch_index - peak) << MORPH_FRAC_BITS);
+		f->notch_pct = (uint8_t)(((notch - foot_value) * 100) / amplitude);
+		f->ri_pct = (uint8_t)(((diastole - foot_value) * 100) / amplitude);
+	}
+	else
+	{
+		f->notch_ms = 0;
+		f->notch_pct = 0;
+		f->ri_pct = 0;
+	}
+
+	return true;
+} // morph_analyse()
+
+
+/*******************************************************************************
+ * Function:        static bool morph_upstroke(morph_state_t *state)
+ *
+ * PreCondition:    The shape is buffered to MORPH_SETTLE_MS past state->mark
+ *
+ * Input:           Extractor state
+ *
+ * Output:          true if state->last was filled
+ *
+ * Side Effects:    state->foot moves to the foot before state->mark
+ *
+ * Overview:        The upstroke is the steepest step from halfway between
+ *                  the last two marks on. Its foot is the lowest sample just
+ *                  before it, found by walking back down from the step while
+ *                  the shape keeps falling, so a low point earlier in the
+ *                  beat is never taken. The beat that ends there is then
+ *                  analysed, so features come one beat late.
+ *
+ * Note:            A beat too long for MORPH_BUFFER is skipped
+ *
+ ******************************************************************************/
+static bool morph_upstroke(morph_state_t *state)
+{
+	uint32_t oldest = (state->index > MORPH_BUFFER) ? (state->index - MORPH_BUFFER) : 0u;
+	uint32_t start = state->mark_prev + ((state->mark - state->mark_prev) / 2u);
+	bool ready = false;
+
+	if (start <= oldest)
+	{
+		state->have_foot = false;
+		return false;
+	}
+
+	uint32_t steep = start;
+	int32_t slope = 0;
+	for (uint32_t i = start + 1u; i < state->index; i++)
+	{
+		int32_t step = MORPH_AT(state, i) - MORPH_AT(state, i - 1u);
+
+		if (step > slope)
+		{
+			slope = step;
+			steep = i;
+		}
+	}
+	if (slope <= 0)
+	{
+		state->have_foot = false;
+		return false;
+	}
+
+	uint32_t low = steep - 1u;
+	while ((low > oldest) && (MORPH_AT(state, low - 1u) < MORPH_AT(state, low)))
+	{
+		low--;
+	}
+
+	if (state->have_foot && (state->foot >= oldest) && (state->foot < low))
+	{
+		ready = morph_analyse(state, low);
+	}
+
+	state->foot = low;
+	state->foot_frac = morph_tangent(state, low, steep);
+	state->have_foot = true;
+	return ready;
+} // morph_upstroke()
+
+
+/*******************************************************************************
+ * Function:        static void morph_begin_beat(morph_state_t *state)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Extractor state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the IR extremes and sum.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void morph_begin_beat(morph_state_t *state)
+{
+	state->ir_min = INT32_MAX;
+	state->ir_max = INT32_MIN;
+	state->ir_sum = 0;
+	state->ir_count = 0;
+} // morph_begin_beat()
+
+
+/*******************************************************************************
+ * Function:        void morph_init(morph_state_t *state, uint16_t sample_rate_hz,
+ *                                  uint16_t delay)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Extractor state, sample rate and the delay of the shape
+ *                  against the signal given to beat_push()
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the state. The first features come two beats after
+ *                  the first foot.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void morph_init(morph_state_t *state, uint16_t sample_rate_hz, uint16_t delay)
+{
+	state->index = 0;
+	state->mark = 0;
+	state->mark_prev = 0;
+	state->have_mark = false;
+	state->pending = false;
+	state->foot = 0;
+	state->foot_frac = 0;
+	state->have_foot = false;
+	state->pi_x100 = 0;
+	state->sample_rate_hz = sample_rate_hz;
+	state->delay = delay;
+	state->settle = (uint16_t)(((uint32_t)MORPH_SETTLE_MS * sample_rate_hz) / 1000u);
+	state->valid = false;
+	state->last = (morph_features_t){ 0 };
+
+	morph_begin_beat(state);
+} // morph_init()
+
+
+/*******************************************************************************
+ * Function:        bool morph_push(morph_state_t *state, int16_t shape, int32_t ir)
+ *
+ * PreCondition:    morph_init() has been called
+ *
+ * Input:           Extractor state, shape and IR sample
+ *
+ * Output:          true when state->last holds the features of the beat that
+ *                  ended at the last foot found
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Stores the shape in the ring and keeps the IR extremes and
+ *                  sum, no multiplies. Once the shape is MORPH_SETTLE_MS past
+ *                  the last mark its upstroke is searched.
+ *
+ * Note:            The shape must keep its form: DC-removed and low-passed,
+ *                  not high-passed, or the foot becomes the undershoot
+ *
+ ******************************************************************************/
+bool morph_push(morph_state_t *state, int16_t shape, int32_t ir)
+{
+	state->shape[state->index & MORPH_MASK] = shape;
+	state->index++;
+
+	// Longer beats are skipped, and the sum stays in range
+	if (state->ir_count < MORPH_BUFFER)
+	{
+		if (ir < state->ir_min) state->ir_min = ir;
+		if (ir > state->ir_max) state->ir_max = ir;
+		state->ir_sum += ir;
+		state->ir_count++;
+	}
+
+	if (!state->pending || (state->index < (state->mark + state->settle + 1u)))
+	{
+		return false;
+	}
+
+	state->pending = false;
+	state->valid = morph_upstroke(state);
+	if (state->valid)
+	{
+		state->last.pi_x100 = state->pi_x100;
+	}
+	return state->valid;
+} // morph_push()
+
+
+/*******************************************************************************
+ * Function:        void morph_beat(morph_state_t *state, const beat_event_t *event)
+ *
+ * PreCondition:    morph_push() has been given the sample that produced the
+ *                  event
+ *
+ * Input:           Extractor state and the beat_push() event
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The new peak is event->latency samples back in the
+ *                  beat_push() signal and state->delay samples later in the
+ *                  shape. It marks the upstroke morph_push() searches once
+ *                  the shape has caught up. The perfusion index is the IR
+ *                  swing over the samples since the last event against their
+ *                  mean, and goes out with the features of the beat that
+ *                  ends at this upstroke:
+ *
+ *                      PI = (IRmax - IRmin) n / SUMir
+ *
+ * Note:            An upstroke still waiting is dropped with its beat
+ *
+ ******************************************************************************/
+void morph_beat(morph_state_t *state, const beat_event_t *event)
+{
+	uint32_t mark = state->index - 1u - event->latency + state->delay;
+
+	state->pi_x100 = 0;
+	if (state->ir_sum > 0)
+	{
+		uint32_t pi = (uint32_t)(((uint64_t)(uint32_t)(state->ir_max - state->ir_min) * state->ir_count * 10000u) /
+			(uint32_t)state->ir_sum);
+		state->pi_x100 = (pi > UINT16_MAX) ? UINT16_MAX : (uint16_t)pi;
+	}
+
+	if (state->pending)
+	{
+		state->have_foot = false;
+	}
+	state->pending = state->have_mark;
+	state->mark_prev = state->mark;
+	state->mark = mark;
+	state->have_mark = true;
+	morph_begin_beat(state);
+} // morph_beat()
@@ -0,0 +1,102 @@
+#ifndef MORPH_H_
+#define MORPH_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "beat.h"
+
+// Shape history, a power of two holding one beat at BEAT_BPM_MIN from foot
+// to the next upstroke at rates up to 100 Hz
+#define MORPH_BUFFER              (256u)
+
+// How long past the detected peak the next upstroke is looked for, covering
+// a band-passed peak that leads the peak of the shape
+#define MORPH_SETTLE_MS           (100u)
+
+// A dicrotic notch must be followed by a rise of at least 1/2^shift of the
+// beat amplitude, smaller wiggles are noise
+#define MORPH_NOTCH_SHIFT         (5u)
+
+// Sub-sample resolution of the half amplitude crossings and the foot
+#define MORPH_FRAC_BITS           (4u)
+
+// Features of one beat, foot to foot
+typedef struct
+{
+	uint16_t pi_x100;        // perfusion index, IR AC / DC in 0.01 %
+	uint16_t rise_ms;        // foot (max slope tangent) to systolic peak
+	uint16_t width_ms;       // width at half amplitude
+	uint16_t notch_ms;       // systolic peak to dicrotic notch, 0 if none
+	uint8_t notch_pct;       // notch height over the foot, % of amplitude
+	uint8_t ri_pct;          // reflection index: diastolic / systolic height, %
+	bool notch;              // a notch and diastolic wave were found
+} morph_features_t;
+
+// Extractor state
+typedef struct
+{
+	int16_t shape[MORPH_BUFFER];
+	uint32_t index;          // samples pushed
+
+	// Detected peaks, moved to shape indices
+	uint32_t mark;           // last peak
+	uint32_t mark_prev;      // the one before it
+	bool have_mark;
+	bool pending;            // the upstroke before mark is not searched yet
+
+	// Foot of the beat in progress
+	uint32_t foot;           // index of the lowest sample before the upstroke
+	uint32_t foot_frac;      // tangent foot in 1/2^MORPH_FRAC_BITS samples
+	bool have_foot;
+
+	// IR over the current beat, for the perfusion index
+	int32_t ir_min, ir_max;
+	int32_t ir_sum;
+	uint16_t ir_count;
+	uint16_t pi_x100;        // of the last detected beat
+
+	uint16_t sample_rate_hz;
+	uint16_t delay;          // samples the shape lags the beat_push() input
+	uint16_t settle;         // MORPH_SETTLE_MS in samples
+
+	// Last beat
+	morph_features_t last;
+	bool valid;
+} morph_state_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def morph_init
+ * \brief Resets the extractor
+ * \param state (extractor state)
+ * \param sample_rate_hz (rate of the samples fed to morph_push)
+ * \param delay (samples the shape signal lags the signal given to beat_push)
+ */
+void morph_init(morph_state_t *state, uint16_t sample_rate_hz, uint16_t delay);
+
+
+/**
+ * \def morph_push
+ * \brief Adds one sample, before beat_push is given its own, returns true when state->last holds a beat's features
+ * \param state (extractor state)
+ * \param shape (DC-removed, low-pass-only pulse, rising with blood volume)
+ * \param ir (ambient-free IR sample)
+ */
+bool morph_push(morph_state_t *state, int16_t shape, int32_t ir);
+
+
+/**
+ * \def morph_beat
+ * \brief Takes a beat_push() event, which marks where the next upstroke is looked for
+ * \param state (extractor state)
+ * \param event (beat event)
+ */
+void morph_beat(morph_state_t *state, const beat_event_t *event);
+
+
+#endif /* MORPH_H_ */
@@ -0,0 +1,200 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "probe.h"
+#include "adc.h"
+#include "adc_dma.h"
+#include "led_seq.h"
+#include "tick.h"
+
+#define F_CPU 48000000UL
+#include "delay.h"
+
+// Window limits, in the units of the current ADC resolution
+static uint16_t probe_lower;
+static uint16_t probe_upper;
+
+// Frame rate to return to once the finger is back
+static uint16_t probe_frame_rate;
+
+static volatile bool probe_pending = false;
+static bool probe_present = true;
+
+// Hold-off: results are leaving the window, since probe_first_ms
+static bool probe_suspect = false;
+static uint32_t probe_first_ms;
+static uint32_t probe_last_ms;
+
+
+/*******************************************************************************
+ * Function:        static void probe_window(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    Runs in ADC_Handler context
+ *
+ * Overview:        Window monitor callback. The monitor is one-shot, so this
+ *                  only records that the state has to change and leaves the
+ *                  reconfiguration to probe_update().
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void probe_window(void)
+{
+	probe_pending = true;
+} // probe_window()
+
+
+/*******************************************************************************
+ * Function:        void probe_init(uint16_t lower, uint16_t upper,
+ *                                  uint16_t frame_rate_hz)
+ *
+ * PreCondition:    LED sequence and ADC DMA acquisition are running
+ *
+ * Input:           Window limits and full frame rate
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function arms the window monitor to fire on the first
+ *                  result outside lower..upper. The ADC checks every red, IR
+ *                  and dark sample in hardware, so the main loop never scans
+ *                  samples for limits.
+ *
+ * Note:            Dark samples are checked too, so lower must sit below the
+ *                  dark level of the front end (its offset). A result under it
+ *                  then means an open or unplugged probe. With a finger
+ *                  removed from a transmissive probe the lit phases saturate
+ *                  and trip upper.
+ *
+ ******************************************************************************/
+void probe_init(uint16_t lower, uint16_t upper, uint16_t frame_rate_hz)
+{
+	probe_lower = lower;
+	probe_upper = upper;
+	probe_frame_rate = frame_rate_hz;
+	probe_pending = false;
+	probe_present = true;
+	probe_suspect = false;
+
+	adc_window_init(probe_lower, probe_upper, ADC_WINDOW_OUTSIDE, probe_window);
+} // probe_init()
+
+
+/*******************************************************************************
+ * Function:        probe_event_t probe_update(void)
+ *
+ * PreCondition:    probe_init() and tick_init() have been called
+ *
+ * Input:           None
+ *
+ * Output:          The transition made, if any
+ *
+ * Side Effects:    Acquisition is reconfigured on a transition
+ *
+ * Overview:        Called from the main loop, costs two flag tests when
+ *                  nothing happened.
+ *
+ *                  Hold-off: while the finger is present the first result
+ *                  outside the window only starts a watch. The monitor is
+ *                  re-armed each time it fires, and the signal is lost once
+ *                  it has kept firing for PROBE_HOLDOFF_MS. A quiet spell of
+ *                  PROBE_QUIET_MS ends the watch, so a glitch costs nothing.
+ *
+ *                  Signal lost: the IR LED is held on, the sequence drops to
+ *                  PROBE_RATE_HZ, DMA acquisition stops and the window monitor
+ *                  is re-armed to fire on the first result back inside the
+ *                  window.
+ *
+ *                  Signal found: the sequence and DMA ring are restarted at
+ *                  the full rate, aligned on a red sample, and the window
+ *                  monitor goes back to watching for the signal leaving.
+ *
+ * Note:            Callers should reset any state that spans blocks (ambient
+ *                  estimate, filters) on PROBE_EVENT_FOUND.
+ *
+ ******************************************************************************/
+probe_event_t probe_update(void)
+{
+	if (probe_suspect && ((tick_ms() - probe_last_ms) >= PROBE_QUIET_MS))
+	{
+		probe_suspect = false;
+	}
+
+	if (!probe_pending)
+	{
+		return PROBE_EVENT_NONE;
+	}
+	probe_pending = false;
+
+	if (probe_present)
+	{
+		uint32_t now = tick_ms();
+
+		if (!probe_suspect)
+		{
+			probe_suspect = true;
+			probe_first_ms = now;
+		}
+		probe_last_ms = now;
+
+		if ((now - probe_first_ms) < PROBE_HOLDOFF_MS)
+		{
+			adc_window_init(probe_lower, probe_upper, ADC_WINDOW_OUTSIDE, probe_window);
+			return PROBE_EVENT_NONE;
+		}
+
+		probe_suspect = false;
+		probe_present = false;
+
+		led_seq_hold(LED_SEQ_SLOT_IR);
+		led_seq_set_rate(PROBE_RATE_HZ);
+		adc_dma_stop();
+
+		adc_window_init(probe_lower, probe_upper, ADC_WINDOW_INSIDE, probe_window);
+		return PROBE_EVENT_LOST;
+	}
+
+	probe_present = true;
+
+	// Let the last conversion finish so it cannot land in the new ring
+	led_seq_stop();
+	delay_ms(PROBE_DRAIN_MS);
+
+	led_seq_set_rate(probe_frame_rate);
+	adc_dma_init(LED_SEQ_PHASES);
+	adc_dma_start();
+	led_seq_start();
+
+	adc_window_init(probe_lower, probe_upper, ADC_WINDOW_OUTSIDE, probe_window);
+	return PROBE_EVENT_FOUND;
+} // probe_update()
+
+
+/*******************************************************************************
+ * Function:        bool probe_active(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          true while acquiring at the full rate
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function tells the main loop whether blocks carry
+ *                  a valid signal.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+bool probe_active(void)
+{
+	return probe_present;
+} // probe_active()
@@ -0,0 +1,63 @@
+#ifndef PROBE_H_
+#define PROBE_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frame rate while waiting for a finger
+#define PROBE_RATE_HZ          (25u)
+
+// Longest conversion (16-bit oversampled) that may still be running when
+// the LED sequence is stopped
+#define PROBE_DRAIN_MS         (2u)
+
+// Results must keep leaving the window for PROBE_HOLDOFF_MS, with no quiet
+// spell of PROBE_QUIET_MS, before the probe is taken as off. A lone sample
+// out of the window then does not restart acquisition. The quiet spell is
+// longer than one DMA block and its processing, the time between two looks.
+#define PROBE_HOLDOFF_MS       (200u)
+#define PROBE_QUIET_MS         (50u)
+
+// What probe_update() did
+typedef enum
+{
+	PROBE_EVENT_NONE = 0,
+	PROBE_EVENT_LOST,      // signal left the window, now probing at low rate
+	PROBE_EVENT_FOUND      // signal back in the window, full rate acquisition restarted
+} probe_event_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def probe_init
+ * \brief Arms the ADC window monitor around the valid signal range
+ * \param lower (below this the probe is off or disconnected)
+ * \param upper (above this the detector is saturated, eg. no finger)
+ * \param frame_rate_hz (full acquisition frame rate)
+ */
+void probe_init(uint16_t lower, uint16_t upper, uint16_t frame_rate_hz);
+
+
+/**
+ * \def probe_update
+ * \brief Switches between full rate and probing when the window monitor fired
+ * \param none
+ */
+probe_event_t probe_update(void);
+
+
+/**
+ * \def probe_active
+ * \brief Returns true while a finger is present and full rate blocks are valid
+ * \param none
+ */
+bool probe_active(void);
+
+
+#endif /* PROBE_H_ */
@@ -0,0 +1,326 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "resp.h"
+#include "fft.h"
+#include "fixmath.h"
+
+#define RESP_LOG2              (6u)
+#define RESP_BINS              (RESP_BEATS / 2u)
+
+#if (1u << RESP_LOG2) != RESP_BEATS
+#error "RESP_LOG2 must match RESP_BEATS"
+#endif
+
+// Step through fft_sine for the Hann window, sin^2(pi i / RESP_BEATS)
+#define RESP_HANN_STEP         (FFT_SIZE_MAX / (2u * RESP_BEATS))
+
+// Detrended series are scaled to peak under 2^RESP_PEAK_BITS, leaving
+// headroom for the window and transform
+#define RESP_PEAK_BITS         (14u)
+
+// Scratch for one estimate, shared by the three series
+static int32_t resp_series[RESP_BEATS];
+static int16_t resp_fft[2u * RESP_BEATS];
+static uint32_t resp_fused[RESP_BINS];
+
+
+/*******************************************************************************
+ * Function:        static bool resp_spectrum(uint8_t k_min, uint8_t k_max)
+ *
+ * PreCondition:    resp_series holds one series in time order
+ *
+ * Input:           Band in bins
+ *
+ * Output:          false if the series is flat over the band
+ *
+ * Side Effects:    resp_series is modified, resp_fused[k_min..k_max] is
+ *                  added to
+ *
+ * Overview:        Removes the line through the end points and the mean, so
+ *                  a drifting baseline does not leak into the low bins,
+ *                  scales the series to the Q15 range, applies a Hann window
+ *                  and transforms it. The band powers are then normalised to
+ *                  a sum of 1.0 in Q15, so each of the three series has an
+ *                  equal say in the fused spectrum whatever its units.
+ *
+ * Note:            One 64-point fft_q15() and one reciprocal
+ *
+ ******************************************************************************/
+static bool resp_spectrum(uint8_t k_min, uint8_t k_max)
+{
+	int32_t first = resp_series[0];
+	int32_t slope = resp_series[RESP_BEATS - 1u] - first;
+	int32_t sum = 0;
+
+	for (uint8_t i = 0; i < RESP_BEATS; i++)
+	{
+		resp_series[i] -= first + (int32_t)(((int64_t)slope * i) >> RESP_LOG2);
+		sum += resp_series[i];
+	}
+
+	int32_t mean = sum / (int32_t)RESP_BEATS;
+	uint32_t peak = 0;
+	for (uint8_t i = 0; i < RESP_BEATS; i++)
+	{
+		resp_series[i] -= mean;
+		uint32_t magnitude = (uint32_t)((resp_series[i] < 0) ? -resp_series[i] : resp_series[i]);
+		if (magnitude > peak) peak = magnitude;
+	}
+	if (peak == 0u)
+	{
+		return false;
+	}
+
+	// Shift so the peak's top bit is bit RESP_PEAK_BITS - 1
+	int8_t shift = (int8_t)fixmath_clz32(peak) - (int8_t)(32u - RESP_PEAK_BITS);
+	for (uint8_t i = 0; i < RESP_BEATS; i++)
+	{
+		int32_t x = (shift >= 0) ? (resp_series[i] * (1l << shift)) : (resp_series[i] >> -shift);
+		int32_t s = fft_sine[i * RESP_HANN_STEP];
+		int32_t hann = (s * s) >> FFT_TWIDDLE_SHIFT;
+
+		resp_fft[2u * i] = (int16_t)((x * hann) >> FFT_TWIDDLE_SHIFT);
+		resp_fft[(2u * i) + 1u] = 0;
+	}
+	fft_q15(resp_fft, RESP_BEATS);
+
+	// Band powers, kept in resp_series to avoid a second pass over the transform
+	uint64_t total = 0;
+	for (uint8_t k = k_min; k <= k_max; k++)
+	{
+		int32_t re = resp_fft[2u * k];
+		int32_t im = resp_fft[(2u * k) + 1u];
+		uint32_t power = (uint32_t)(re * re) + (uint32_t)(im * im);
+
+		resp_series[k] = (int32_t)(power >> 1);
+		total += power >> 1;
+	}
+	if (total == 0u)
+	{
+		return false;
+	}
+
+	// Bring the total under 2^16 so share << 15 fits 32 bits
+	uint8_t norm = 0;
+	while ((total >> norm) >= (1ul << 16))
+	{
+		norm++;
+	}
+	fixmath_recip_t recip;
+	fixmath_recip_init(&recip, (uint32_t)(total >> norm));
+
+	for (uint8_t k = k_min; k <= k_max; k++)
+	{
+		resp_fused[k] += fixmath_div(((uint32_t)resp_series[k] >> norm) << 15, &recip);
+	}
+	return true;
+} // resp_spectrum()
+
+
+/*******************************************************************************
+ * Function:        static void resp_estimate(resp_state_t *resp)
+ *
+ * PreCondition:    The window is full
+ *
+ * Input:           Estimator state
+ *
+ * Output:          None
+ *
+ * Side Effects:    resp->brpm_x10, quality and valid are updated
+ *
+ * Overview:        Baseline wander, amplitude and interval modulation are
+ *                  each transformed over the beats of the window and their
+ *                  normalised spectra summed. The series are indexed by
+ *                  beat, so a bin is in cycles per window and becomes a rate
+ *                  through the window's length in time:
+ *
+ *                      brpm = k * 60000 / span_ms
+ *
+ *                  The peak is refined with a parabola as in the Goertzel
+ *                  bank, and the estimate is rated by the share of the fused
+ *                  band power in the peak and its neighbours. Breathing
+ *                  moves all three series at one rate; motion and noise do
+ *                  not agree and spread over the band.
+ *
+ * Note:            Three 64-point FFTs, about every RESP_UPDATE_BEATS beats
+ *
+ ******************************************************************************/
+static void resp_estimate(resp_state_t *resp)
+{
+	uint32_t k_min = ((RESP_BRPM_MIN * resp->span_ms) + 59999u) / 60000u;
+	uint32_t k_max = (RESP_BRPM_MAX * resp->span_ms) / 60000u;
+
+	if (k_min < 1u) k_min = 1u;
+	if (k_max > (RESP_BINS - 1u)) k_max = RESP_BINS - 1u;
+
+	resp->valid = false;
+	if ((resp->held > RESP_HELD_MAX) || ((k_min + 2u) > k_max))
+	{
+		return;
+	}
+
+	for (uint8_t k = 0; k < RESP_BINS; k++)
+	{
+		resp_fused[k] = 0;
+	}
+
+	uint8_t used = 0;
+	for (uint8_t series = 0; series < 3u; series++)
+	{
+		for (uint8_t i = 0; i < RESP_BEATS; i++)
+		{
+			uint8_t j = (resp->head + i) % RESP_BEATS;
+
+			resp_series[i] = (series == 0u) ? resp->dc[j] :
+				(series == 1u) ? resp->amplitude[j] : (int32_t)resp->interval[j];
+		}
+		if (resp_spectrum((uint8_t)k_min, (uint8_t)k_max))
+		{
+			used++;
+		}
+	}
+	if (used == 0u)
+	{
+		return;
+	}
+
+	uint32_t total = 0, peak = 0;
+	uint8_t peak_bin = (uint8_t)k_min;
+	for (uint8_t k = (uint8_t)k_min; k <= k_max; k++)
+	{
+		total += resp_fused[k];
+		if (resp_fused[k] > peak)
+		{
+			peak = resp_fused[k];
+			peak_bin = k;
+		}
+	}
+
+	int32_t k_x10 = (int32_t)peak_bin * 10;
+	uint32_t lobe = peak;
+	if ((peak_bin > k_min) && (peak_bin < k_max))
+	{
+		int32_t left = (int32_t)resp_fused[peak_bin - 1u];
+		int32_t right = (int32_t)resp_fused[peak_bin + 1u];
+		int32_t curve = (2 * (int32_t)peak) - left - right;
+
+		if (curve > 0)
+		{
+			int32_t d_x10 = (5 * (right - left)) / curve;
+
+			if (d_x10 > 5) d_x10 = 5;
+			if (d_x10 < -5) d_x10 = -5;
+			k_x10 += d_x10;
+		}
+		lobe += (uint32_t)(left + right);
+	}
+
+	resp->brpm_x10 = (uint16_t)(((uint32_t)k_x10 * 60000u) / resp->span_ms);
+	resp->quality = (uint8_t)(((uint64_t)lobe * 100u) / total);
+	resp->valid = (resp->quality >= RESP_QUALITY_MIN);
+} // resp_estimate()
+
+
+/*******************************************************************************
+ * Function:        void resp_init(resp_state_t *resp)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Estimator state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Empties the window. The first estimate comes RESP_BEATS
+ *                  beats after the first accepted one.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void resp_init(resp_state_t *resp)
+{
+	resp->held_mask = 0;
+	resp->span_ms = 0;
+	resp->head = 0;
+	resp->count = 0;
+	resp->held = 0;
+	resp->since = 0;
+	resp->have_last = false;
+	resp->brpm_x10 = 0;
+	resp->quality = 0;
+	resp->valid = false;
+} // resp_init()
+
+
+/*******************************************************************************
+ * Function:        bool resp_beat(resp_state_t *resp, int32_t dc, int32_t amplitude,
+ *                                 uint16_t interval_ms, bool accepted)
+ *
+ * PreCondition:    resp_init() has been called
+ *
+ * Input:           Estimator state, the beat's baseline, amplitude and
+ *                  interval, and whether its SQI was acceptable
+ *
+ * Output:          true when a new estimate was made, see resp->valid
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Appends the beat to the window, replacing the oldest. A
+ *                  rejected beat repeats the last accepted values so the
+ *                  series stay evenly indexed, but its true interval still
+ *                  counts towards the window's span. Too many held beats
+ *                  make the estimate invalid.
+ *
+ * Note:            O(1) except on estimate beats
+ *
+ ******************************************************************************/
+bool resp_beat(resp_state_t *resp, int32_t dc, int32_t amplitude, uint16_t interval_ms, bool accepted)
+{
+	if (accepted)
+	{
+		resp->last_dc = dc;
+		resp->last_amplitude = amplitude;
+		resp->last_interval = interval_ms;
+		resp->have_last = true;
+	}
+	else if (!resp->have_last)
+	{
+		return false;
+	}
+
+	uint8_t j = resp->head;
+	if (resp->count == RESP_BEATS)
+	{
+		resp->span_ms -= resp->elapsed[j];
+		if (resp->held_mask & (1ull << (RESP_BEATS - 1u)))
+		{
+			resp->held--;
+		}
+	}
+	else
+	{
+		resp->count++;
+	}
+
+	resp->dc[j] = resp->last_dc;
+	resp->amplitude[j] = resp->last_amplitude;
+	resp->interval[j] = resp->last_interval;
+	resp->elapsed[j] = interval_ms;
+	resp->span_ms += interval_ms;
+	resp->held_mask = (resp->held_mask << 1) | (accepted ? 0u : 1u);
+	if (!accepted)
+	{
+		resp->held++;
+	}
+	resp->head = (j + 1u) % RESP_BEATS;
+
+	if ((resp->count < RESP_BEATS) || (++resp->since < RESP_UPDATE_BEATS))
+	{
+		return false;
+	}
+	resp->since = 0;
+	resp_estimate(resp);
+	return true;
+} // resp_beat()
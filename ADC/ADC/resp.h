@@ -0,0 +1,79 @@
+#ifndef RESP_H_
+#define RESP_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Beats in the analysis window, a power of two for fft_q15(). One bit per
+// beat of the window is kept in a uint64_t.
+#define RESP_BEATS                (64u)
+
+// A new estimate every this many beats once the window is full
+#define RESP_UPDATE_BEATS         (8u)
+
+// Respiratory band in breaths per minute. Rates above half the heart rate
+// alias in the beat series and cannot be told apart.
+#define RESP_BRPM_MIN             (4u)
+#define RESP_BRPM_MAX             (40u)
+
+// Most beats of the window that may be held over rejected beats
+#define RESP_HELD_MAX             (16u)
+
+// Least share of the fused band power around the peak (%) for a valid rate
+#define RESP_QUALITY_MIN          (40u)
+
+// Estimator state, the three per-beat series in time order from head
+typedef struct
+{
+	int32_t dc[RESP_BEATS];          // baseline at each beat (BW)
+	int32_t amplitude[RESP_BEATS];   // pulse amplitude (AM)
+	uint16_t interval[RESP_BEATS];   // beat interval, ms (FM)
+	uint16_t elapsed[RESP_BEATS];    // true time since the previous beat, ms
+	uint64_t held_mask;              // beats that repeat the last accepted values
+	uint32_t span_ms;                // sum of elapsed[]
+	uint8_t head;                    // oldest beat, next to be replaced
+	uint8_t count;                   // beats in the window
+	uint8_t held;                    // bits set in held_mask
+	uint8_t since;                   // beats since the last estimate
+
+	// Last accepted beat
+	int32_t last_dc;
+	int32_t last_amplitude;
+	uint16_t last_interval;
+	bool have_last;
+
+	// Last estimate
+	uint16_t brpm_x10;               // respiratory rate in 0.1 breaths/min
+	uint8_t quality;                 // share of the fused power around the peak, %
+	bool valid;
+} resp_state_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def resp_init
+ * \brief Clears the window
+ * \param resp (estimator state)
+ */
+void resp_init(resp_state_t *resp);
+
+
+/**
+ * \def resp_beat
+ * \brief Adds one beat, returns true when a new estimate was made
+ * \param resp (estimator state)
+ * \param dc (IR baseline at the beat)
+ * \param amplitude (beat amplitude)
+ * \param interval_ms (time since the previous beat)
+ * \param accepted (false to hold the series at the last accepted beat)
+ */
+bool resp_beat(resp_state_t *resp, int32_t dc, int32_t amplitude, uint16_t interval_ms, bool accepted);
+
+
+#endif /* RESP_H_ */
@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "spo2.h"
+#include "spo2_cal.h"
+
+/*******************************************************************************
+ * Function:        static void spo2_begin_beat(spo2_state_t *state)
+ *
+ * PreCondition:    None
+ *
+ * Input:           SpO2 state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the per beat sums and extremes.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void spo2_begin_beat(spo2_state_t *state)
+{
+	state->sum_red = 0;
+	state->sum_ir = 0;
+	state->min_red = INT32_MAX;
+	state->max_red = INT32_MIN;
+	state->min_ir = INT32_MAX;
+	state->max_ir = INT32_MIN;
+	state->count = 0;
+	state->open = true;
+} // spo2_begin_beat()
+
+
+/*******************************************************************************
+ * Function:        void spo2_init(spo2_state_t *state, uint16_t sample_rate_hz)
+ *
+ * PreCondition:    None
+ *
+ * Input:           SpO2 state and red/IR frame rate
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function clears the state. Samples are only kept
+ *                  once the first spo2_beat() marks the start of a beat.
+ *
+ * Note:            The division here runs once, not per sample
+ *
+ ******************************************************************************/
+void spo2_init(spo2_state_t *state, uint16_t sample_rate_hz)
+{
+	spo2_begin_beat(state);
+	state->open = false;
+
+	state->max_samples = (uint16_t)(((uint32_t)sample_rate_hz * 60u) / SPO2_BPM_MIN);
+
+	state->ratio = 0;
+	state->spo2 = 0;
+	state->beat_samples = 0;
+} // spo2_init()
+
+
+/*******************************************************************************
+ * Function:        void spo2_push(spo2_state_t *state, int32_t red, int32_t ir)
+ *
+ * PreCondition:    spo2_init() has been called
+ *
+ * Input:           SpO2 state, one ambient-free red and IR sample
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Adds the pair to the sums and extremes of the current beat,
+ *                  two adds and four compares per sample. A beat longer than
+ *                  the SPO2_BPM_MIN interval is dropped.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void spo2_push(spo2_state_t *state, int32_t red, int32_t ir)
+{
+	if (!state->open)
+	{
+		return;
+	}
+
+	state->sum_red += red;
+	state->sum_ir += ir;
+	if (red < state->min_red) state->min_red = red;
+	if (red > state->max_red) state->max_red = red;
+	if (ir < state->min_ir) state->min_ir = ir;
+	if (ir > state->max_ir) state->max_ir = ir;
+
+	// Too long for a beat, wait for the next one
+	if (++state->count >= state->max_samples)
+	{
+		state->open = false;
+	}
+} // spo2_push()
+
+
+/*******************************************************************************
+ * Function:        bool spo2_beat(spo2_state_t *state)
+ *
+ * PreCondition:    spo2_init() has been called
+ *
+ * Input:           SpO2 state
+ *
+ * Output:          true when the beat gave a new reading in state->ratio and
+ *                  state->spo2
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Called on each beat_push() event. The samples since the
+ *                  previous event span one full pulse, so their peak to peak
+ *                  swing is the AC and their mean the DC:
+ *
+ *                      R = (ACred / DCred) / (ACir / DCir)
+ *                        = (ACred * SUMir) / (ACir * SUMred)
+ *
+ *                  The sample count cancels, so the sums are used directly and
+ *                  the only division is this one, once per beat. A new beat
+ *                  starts straight away.
+ *
+ * Note:            AC < 2^16 and sums < 2^28, the shifted numerator fits in
+ *                  64 bits.
+ *
+ ******************************************************************************/
+bool spo2_beat(spo2_state_t *state)
+{
+	bool reading = false;
+
+	if (state->open)
+	{
+		int32_t ac_red = state->max_red - state->min_red;
+		int32_t ac_ir = state->max_ir - state->min_ir;
+
+		if ((ac_red > 0) && (ac_ir > 0) && (state->sum_red > 0) && (state->sum_ir > 0))
+		{
+			uint64_t num = (uint64_t)(uint32_t)ac_red * (uint32_t)state->sum_ir;
+			uint64_t den = (uint64_t)(uint32_t)ac_ir * (uint32_t)state->sum_red;
+			uint64_t ratio = (num << 15) / den;
+
+			if (ratio <= SPO2_RATIO_MAX)
+			{
+				state->ratio = (uint32_t)ratio;
+				state->spo2 = spo2_cal_lookup(state->ratio);
+				state->beat_samples = state->count;
+				reading = true;
+			}
+		}
+	}
+
+	spo2_begin_beat(state);
+	return reading;
+} // spo2_beat()
+
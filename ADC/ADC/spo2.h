@@ -0,0 +1,68 @@
+#ifndef SPO2_H_
+#define SPO2_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Longest beat accumulated, in beats per minute
+#define SPO2_BPM_MIN              (30u)
+
+// R above this is not a usable pulse (0x10000 is 2.0)
+#define SPO2_RATIO_MAX            (0x10000ul)
+
+// Streaming state, one red/IR sample pair at a time
+typedef struct
+{
+	// Current beat
+	int32_t sum_red;
+	int32_t sum_ir;
+	int32_t min_red, max_red;
+	int32_t min_ir, max_ir;
+	uint16_t count;
+	bool open;
+
+	// Longest beat in samples, keeps the sums in range
+	uint16_t max_samples;
+
+	// Last beat
+	uint32_t ratio;          // R in Q15 (32768 is 1.0)
+	uint16_t spo2;           // SpO2 in 0.1 %
+	uint16_t beat_samples;   // beat length in samples
+} spo2_state_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def spo2_init
+ * \brief Resets the SpO2 state for a given sample rate
+ * \param state (SpO2 state)
+ * \param sample_rate_hz (red/IR frame rate)
+ */
+void spo2_init(spo2_state_t *state, uint16_t sample_rate_hz);
+
+
+/**
+ * \def spo2_push
+ * \brief Adds one red/IR sample pair to the current beat
+ * \param state (SpO2 state)
+ * \param red (ambient-free red sample)
+ * \param ir (ambient-free IR sample)
+ */
+void spo2_push(spo2_state_t *state, int32_t red, int32_t ir);
+
+
+/**
+ * \def spo2_beat
+ * \brief Closes the current beat, returns true when it produced a new reading
+ * \param state (SpO2 state)
+ */
+bool spo2_beat(spo2_state_t *state);
+
+
+#endif /* SPO2_H_ */
@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "spo2_cal.h"
+
+// Segment from SpO2 a to SpO2 b
+#define SPO2_CAL_SEG(a, b)        { (a), (int16_t)((b) - (a)) }
+
+#define SPO2_CAL_FRAC_MASK        ((1u << SPO2_CAL_SHIFT) - 1u)
+#define SPO2_CAL_RATIO_MAX        ((uint32_t)SPO2_CAL_SEGMENTS << SPO2_CAL_SHIFT)
+
+// 110 - 25R, clipped at 100 %
+static const spo2_cal_segment_t spo2_cal_linear[SPO2_CAL_POINTS] =
+{
+	SPO2_CAL_SEG(1000, 1000), SPO2_CAL_SEG(1000, 1000), SPO2_CAL_SEG(1000, 1000), SPO2_CAL_SEG(1000, 975),
+	SPO2_CAL_SEG(975, 944), SPO2_CAL_SEG(944, 913), SPO2_CAL_SEG(913, 881), SPO2_CAL_SEG(881, 850),
+	SPO2_CAL_SEG(850, 819), SPO2_CAL_SEG(819, 788), SPO2_CAL_SEG(788, 756), SPO2_CAL_SEG(756, 725),
+	SPO2_CAL_SEG(725, 694), SPO2_CAL_SEG(694, 663), SPO2_CAL_SEG(663, 631), SPO2_CAL_SEG(631, 600),
+	SPO2_CAL_SEG(600, 600)
+};
+
+// -45.06R^2 + 30.354R + 94.845, clipped at 0 %
+static const spo2_cal_segment_t spo2_cal_quadratic[SPO2_CAL_POINTS] =
+{
+	SPO2_CAL_SEG(948, 979), SPO2_CAL_SEG(979, 996), SPO2_CAL_SEG(996, 999), SPO2_CAL_SEG(999, 988),
+	SPO2_CAL_SEG(988, 962), SPO2_CAL_SEG(962, 923), SPO2_CAL_SEG(923, 869), SPO2_CAL_SEG(869, 801),
+	SPO2_CAL_SEG(801, 720), SPO2_CAL_SEG(720, 624), SPO2_CAL_SEG(624, 514), SPO2_CAL_SEG(514, 390),
+	SPO2_CAL_SEG(390, 252), SPO2_CAL_SEG(252, 100), SPO2_CAL_SEG(100, 0), SPO2_CAL_SEG(0, 0),
+	SPO2_CAL_SEG(0, 0)
+};
+
+// Per probe or skin tone curve, unused until loaded
+static spo2_cal_segment_t spo2_cal_custom[SPO2_CAL_POINTS];
+static bool spo2_cal_custom_valid = false;
+
+// Curve in use
+static const spo2_cal_segment_t *spo2_cal_active = spo2_cal_linear;
+static spo2_cal_curve_t spo2_cal_current = SPO2_CAL_LINEAR;
+
+
+/*******************************************************************************
+ * Function:        void spo2_cal_select(spo2_cal_curve_t curve)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Curve to use
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Switching curves is a pointer swap, readings from the next
+ *                  beat on use the new curve.
+ *
+ * Note:            SPO2_CAL_CUSTOM is ignored until spo2_cal_set_custom() has
+ *                  loaded it
+ *
+ ******************************************************************************/
+void spo2_cal_select(spo2_cal_curve_t curve)
+{
+	switch (curve)
+	{
+		case SPO2_CAL_LINEAR:
+			spo2_cal_active = spo2_cal_linear;
+			break;
+
+		case SPO2_CAL_QUADRATIC:
+			spo2_cal_active = spo2_cal_quadratic;
+			break;
+
+		case SPO2_CAL_CUSTOM:
+			if (!spo2_cal_custom_valid)
+			{
+				return;
+			}
+			spo2_cal_active = spo2_cal_custom;
+			break;
+
+		default:
+			return;
+	}
+
+	spo2_cal_current = curve;
+} // spo2_cal_select()
+
+
+/*******************************************************************************
+ * Function:        spo2_cal_curve_t spo2_cal_selected(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          Curve in use
+ *
+ * Side Effects:    None
+ *
+ * Overview:        None
+ *
+ * Note:
+ *
+ ******************************************************************************/
+spo2_cal_curve_t spo2_cal_selected(void)
+{
+	return spo2_cal_current;
+} // spo2_cal_selected()
+
+
+/*******************************************************************************
+ * Function:        bool spo2_cal_set_custom(const uint16_t *points)
+ *
+ * PreCondition:    None
+ *
+ * Input:           SPO2_CAL_POINTS SpO2 values in 0.1 % at R = 0, 1/8 ... 2.0
+ *
+ * Output:          false if a point is above SPO2_CAL_MAX
+ *
+ * Side Effects:    If the custom curve is in use it changes immediately
+ *
+ * Overview:        This function turns the points into base/slope segments
+ *                  once, so a lookup never has to take a difference.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+bool spo2_cal_set_custom(const uint16_t *points)
+{
+	for (uint8_t i = 0; i < SPO2_CAL_POINTS; i++)
+	{
+		if (points[i] > SPO2_CAL_MAX)
+		{
+			return false;
+		}
+	}
+
+	for (uint8_t i = 0; i < SPO2_CAL_SEGMENTS; i++)
+	{
+		spo2_cal_custom[i].base = points[i];
+		spo2_cal_custom[i].slope = (int16_t)((int32_t)points[i + 1u] - (int32_t)points[i]);
+	}
+	spo2_cal_custom[SPO2_CAL_SEGMENTS].base = points[SPO2_CAL_SEGMENTS];
+	spo2_cal_custom[SPO2_CAL_SEGMENTS].slope = 0;
+
+	spo2_cal_custom_valid = true;
+	return true;
+} // spo2_cal_set_custom()
+
+
+/*******************************************************************************
+ * Function:        uint16_t spo2_cal_lookup(uint32_t ratio)
+ *
+ * PreCondition:    None
+ *
+ * Input:           R in Q15
+ *
+ * Output:          SpO2 in 0.1 %
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The upper bits of R pick the segment and the lower bits
+ *                  place R within it, so a lookup is one segment load and one
+ *                  multiply. R at or above 2.0 lands on the last point, whose
+ *                  slope is 0.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint16_t spo2_cal_lookup(uint32_t ratio)
+{
+	if (ratio > SPO2_CAL_RATIO_MAX)
+	{
+		ratio = SPO2_CAL_RATIO_MAX;
+	}
+
+	spo2_cal_segment_t segment = spo2_cal_active[ratio >> SPO2_CAL_SHIFT];
+	int32_t frac = (int32_t)(ratio & SPO2_CAL_FRAC_MASK);
+
+	return (uint16_t)((int32_t)segment.base + ((segment.slope * frac) >> SPO2_CAL_SHIFT));
+} // spo2_cal_lookup()
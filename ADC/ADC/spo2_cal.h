@@ -0,0 +1,72 @@
+#ifndef SPO2_CAL_H_
+#define SPO2_CAL_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Curves cover R from 0 to 2.0 (Q15 0..0x10000) in segments of 1/8, so the
+// segment is R >> SPO2_CAL_SHIFT and the position within it the low bits
+#define SPO2_CAL_SHIFT            (12u)
+#define SPO2_CAL_SEGMENTS         (16u)
+#define SPO2_CAL_POINTS           (SPO2_CAL_SEGMENTS + 1u)
+
+// Highest SpO2 a curve may hold, in 0.1 %
+#define SPO2_CAL_MAX              (1000u)
+
+// One segment: SpO2 at its start (0.1 %) and the change across it
+typedef struct
+{
+	uint16_t base;
+	int16_t slope;
+} spo2_cal_segment_t;
+
+// Available curves
+typedef enum
+{
+	SPO2_CAL_LINEAR = 0,      // 110 - 25R, the usual empirical line
+	SPO2_CAL_QUADRATIC,       // -45.06R^2 + 30.354R + 94.845, common reference design fit
+	SPO2_CAL_CUSTOM,          // loaded at runtime with spo2_cal_set_custom(), from a 'C' line on UART3
+	SPO2_CAL_COUNT
+} spo2_cal_curve_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def spo2_cal_select
+ * \brief Makes a curve the one used by spo2_cal_lookup
+ * \param curve (one of spo2_cal_curve_t)
+ */
+void spo2_cal_select(spo2_cal_curve_t curve);
+
+
+/**
+ * \def spo2_cal_selected
+ * \brief Returns the curve in use
+ * \param none
+ */
+spo2_cal_curve_t spo2_cal_selected(void);
+
+
+/**
+ * \def spo2_cal_set_custom
+ * \brief Loads the custom curve from SPO2_CAL_POINTS SpO2 values (0.1 %), false if out of range
+ * \param points (SpO2 at R = 0, 1/8 ... 2.0)
+ */
+bool spo2_cal_set_custom(const uint16_t *points);
+
+
+/**
+ * \def spo2_cal_lookup
+ * \brief Maps a ratio of ratios to SpO2 in 0.1 % through the selected curve
+ * \param ratio (R in Q15, clamped at 2.0)
+ */
+uint16_t spo2_cal_lookup(uint32_t ratio);
+
+
+#endif /* SPO2_CAL_H_ */
@@ -0,0 +1,416 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "sqi.h"
+#include "fixmath.h"
+
+#define SQI_ONE                (32767)
+
+// Red / IR inputs are scaled down so the beat's sums stay in int32
+#define SQI_COHERENCE_SHIFT    (4u)
+
+// Expected length of the first beat, at 60 bpm
+#define SQI_DEFAULT_BPM        (60u)
+
+
+/*******************************************************************************
+ * Function:        static uint32_t sqi_sqrt64(uint64_t value, uint8_t *shift)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Value and where to return the scale
+ *
+ * Output:          sqrt(value) / 2^shift
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Drops pairs of low bits until the value fits
+ *                  fixmath_isqrt32(), keeping 16 significant bits.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static uint32_t sqi_sqrt64(uint64_t value, uint8_t *shift)
+{
+	*shift = 0;
+	while (value > UINT32_MAX)
+	{
+		value >>= 2;
+		(*shift)++;
+	}
+	return fixmath_isqrt32((uint32_t)value);
+} // sqi_sqrt64()
+
+
+/*******************************************************************************
+ * Function:        static int16_t sqi_correlation(int32_t n, int32_t sx,
+ *                                                 int32_t sy, int32_t sxx,
+ *                                                 int32_t syy, int32_t sxy)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Count and the sums of x, y, x^2, y^2 and xy
+ *
+ * Output:          Pearson correlation in Q15, 0 if either side is flat
+ *
+ * Side Effects:    None
+ *
+ * Overview:        r = (n Sxy - Sx Sy) / sqrt((n Sxx - Sx^2)(n Syy - Sy^2))
+ *
+ *                  The correlation ignores offset and gain, so raw samples
+ *                  can be compared with the normalised template.
+ *
+ * Note:            One 64-bit division, run once per beat
+ *
+ ******************************************************************************/
+static int16_t sqi_correlation(int32_t n, int32_t sx, int32_t sy, int32_t sxx, int32_t syy, int32_t sxy)
+{
+	int64_t cov = ((int64_t)n * sxy) - ((int64_t)sx * sy);
+	int64_t var_x = ((int64_t)n * sxx) - ((int64_t)sx * sx);
+	int64_t var_y = ((int64_t)n * syy) - ((int64_t)sy * sy);
+
+	if ((var_x <= 0) || (var_y <= 0))
+	{
+		return 0;
+	}
+
+	uint8_t shift_x, shift_y;
+	int64_t den = (int64_t)sqi_sqrt64((uint64_t)var_x, &shift_x) * sqi_sqrt64((uint64_t)var_y, &shift_y);
+	int64_t r = ((cov * 32768) >> (shift_x + shift_y)) / ((den != 0) ? den : 1);
+
+	if (r > SQI_ONE) r = SQI_ONE;
+	if (r < -SQI_ONE) r = -SQI_ONE;
+	return (int16_t)r;
+} // sqi_correlation()
+
+
+/*******************************************************************************
+ * Function:        static int16_t sqi_shape(sqi_state_t *sqi)
+ *
+ * PreCondition:    The beat has been closed
+ *
+ * Input:           Scorer state
+ *
+ * Output:          Correlation of the beat with the template in Q15
+ *
+ * Side Effects:    The beat points are normalised to the template scale
+ *
+ * Overview:        Normalises the beat to 0..2^SQI_TEMPLATE_FRAC_BITS between
+ *                  its lowest and highest point, then correlates the points
+ *                  both the beat and the template have.
+ *
+ * Note:            SQI_POINTS multiplies, once per beat
+ *
+ ******************************************************************************/
+static int16_t sqi_shape(sqi_state_t *sqi)
+{
+	int16_t low = INT16_MAX;
+	int16_t high = INT16_MIN;
+
+	for (uint8_t p = 0; p < SQI_POINTS; p++)
+	{
+		if (sqi->beat_mask & (1ul << p))
+		{
+			if (sqi->beat[p] < low) low = sqi->beat[p];
+			if (sqi->beat[p] > high) high = sqi->beat[p];
+		}
+	}
+
+	if (high <= low)
+	{
+		sqi->beat_mask = 0;
+		return 0;
+	}
+
+	uint32_t gain = (1ul << (SQI_TEMPLATE_FRAC_BITS + 16u)) / (uint32_t)(high - low);
+	uint32_t mask = sqi->beat_mask & sqi->template_mask;
+	int32_t n = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+
+	for (uint8_t p = 0; p < SQI_POINTS; p++)
+	{
+		if (sqi->beat_mask & (1ul << p))
+		{
+			int32_t x = (int32_t)(((uint32_t)(sqi->beat[p] - low) * gain) >> 16);
+			sqi->beat[p] = (int16_t)x;
+
+			if (mask & (1ul << p))
+			{
+				int32_t y = sqi->template[p];
+
+				n++;
+				sx += x;
+				sy += y;
+				sxx += x * x;
+				syy += y * y;
+				sxy += x * y;
+			}
+		}
+	}
+
+	return sqi_correlation(n, sx, sy, sxx, syy, sxy);
+} // sqi_shape()
+
+
+/*******************************************************************************
+ * Function:        static void sqi_begin_beat(sqi_state_t *sqi,
+ *                                             uint16_t expected)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Scorer state and expected beat length in samples
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the beat sums. The beat is resampled by stepping
+ *                  SQI_POINTS / expected points per sample. Without an
+ *                  expected length (first beat) it is scored but not learnt.
+ *
+ * Note:            One division per beat
+ *
+ ******************************************************************************/
+static void sqi_begin_beat(sqi_state_t *sqi, uint16_t expected)
+{
+	sqi->timed = (expected != 0);
+	if (!sqi->timed)
+	{
+		expected = sqi->default_samples;
+	}
+
+	sqi->beat_mask = 0;
+	sqi->phase = 0;
+	sqi->step = ((uint32_t)SQI_POINTS << 16) / expected;
+	sqi->sum_red = 0;
+	sqi->sum_ir = 0;
+	sqi->sum_red2 = 0;
+	sqi->sum_ir2 = 0;
+	sqi->sum_red_ir = 0;
+	sqi->count = 0;
+	sqi->clipped = 0;
+	sqi->open = true;
+} // sqi_begin_beat()
+
+
+/*******************************************************************************
+ * Function:        void sqi_init(sqi_state_t *sqi, uint16_t sample_rate_hz)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Scorer state and sample rate
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Clears the state and the template. Samples are only kept
+ *                  once the first sqi_beat() marks the start of a beat.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void sqi_init(sqi_state_t *sqi, uint16_t sample_rate_hz)
+{
+	sqi->max_samples = (uint16_t)(((uint32_t)sample_rate_hz * 60u) / SQI_BPM_MIN);
+	sqi->default_samples = (uint16_t)(((uint32_t)sample_rate_hz * 60u) / SQI_DEFAULT_BPM);
+
+	sqi_begin_beat(sqi, 0);
+	sqi->open = false;
+	sqi->template_mask = 0;
+	sqi->learned = 0;
+	sqi->rejected = 0;
+	sqi->amplitude = 0;
+
+	sqi->shape = 0;
+	sqi->stability = 0;
+	sqi->coherence = 0;
+	sqi->clean = 0;
+	sqi->score = 0;
+} // sqi_init()
+
+
+/*******************************************************************************
+ * Function:        void sqi_push(sqi_state_t *sqi, int16_t pulse,
+ *                                int16_t red_ac, int16_t ir_ac, bool clipped)
+ *
+ * PreCondition:    sqi_init() has been called
+ *
+ * Input:           Scorer state, pulse sample, red and IR less their baselines
+ *                  and whether either channel is clipped
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Stores the pulse at its resampled point (averaging with a
+ *                  sample already there) and adds red and IR to the
+ *                  coherence sums, three multiplies per sample. A beat longer
+ *                  than the SQI_BPM_MIN interval is dropped.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void sqi_push(sqi_state_t *sqi, int16_t pulse, int16_t red_ac, int16_t ir_ac, bool clipped)
+{
+	if (!sqi->open)
+	{
+		return;
+	}
+
+	uint32_t p = sqi->phase >> 16;
+	if (p < SQI_POINTS)
+	{
+		if (sqi->beat_mask & (1ul << p))
+		{
+			sqi->beat[p] = (int16_t)(((int32_t)sqi->beat[p] + pulse) >> 1);
+		}
+		else
+		{
+			sqi->beat[p] = pulse;
+			sqi->beat_mask |= 1ul << p;
+		}
+	}
+	sqi->phase += sqi->step;
+
+	int32_t red = red_ac >> SQI_COHERENCE_SHIFT;
+	int32_t ir = ir_ac >> SQI_COHERENCE_SHIFT;
+	sqi->sum_red += red;
+	sqi->sum_ir += ir;
+	sqi->sum_red2 += red * red;
+	sqi->sum_ir2 += ir * ir;
+	sqi->sum_red_ir += red * ir;
+
+	if (clipped)
+	{
+		sqi->clipped++;
+	}
+
+	// Too long for a beat, wait for the next one
+	if (++sqi->count >= sqi->max_samples)
+	{
+		sqi->open = false;
+	}
+} // sqi_push()
+
+
+/*******************************************************************************
+ * Function:        uint8_t sqi_beat(sqi_state_t *sqi, const beat_event_t *event)
+ *
+ * PreCondition:    sqi_init() has been called
+ *
+ * Input:           Scorer state and the beat_push() event
+ *
+ * Output:          Score of the beat that just closed in %, 0 if there was
+ *                  no complete beat
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Called on each beat_push() event, the samples since the
+ *                  previous one are a beat. Four factors, each 0 to 1:
+ *
+ *                  - shape: correlation with the template of accepted beats
+ *                    (taken as 1 while the template is learnt)
+ *                  - stability: how close the amplitude is to the mean of
+ *                    accepted beats
+ *                  - coherence: correlation of red with IR; motion and light
+ *                    leaks move them differently, blood moves them together
+ *                  - clean: falls to 0 once a quarter of the beat is clipped
+ *
+ *                  The score is their product. Beats scoring SQI_ACCEPT or
+ *                  more are blended into the template and mean amplitude, so
+ *                  one bad beat does not teach the scorer to accept more.
+ *                  After SQI_RELEARN_BEATS rejected beats in a row the
+ *                  template is learnt again.
+ *
+ * Note:            A few divisions, once per beat
+ *
+ ******************************************************************************/
+uint8_t sqi_beat(sqi_state_t *sqi, const beat_event_t *event)
+{
+	uint8_t score = 0;
+
+	if (sqi->open && (sqi->count != 0))
+	{
+		int32_t n = sqi->count;
+
+		// Shape
+		int16_t shape = sqi_shape(sqi);
+		bool learning = (sqi->learned < SQI_LEARN_BEATS);
+		sqi->shape = learning ? SQI_ONE : ((shape > 0) ? shape : 0);
+
+		// Amplitude against the running mean
+		if (sqi->amplitude == 0)
+		{
+			sqi->amplitude = event->amplitude;
+		}
+		int32_t deviation = event->amplitude - sqi->amplitude;
+		if (deviation < 0)
+		{
+			deviation = -deviation;
+		}
+		int32_t stability = SQI_ONE;
+		if (sqi->amplitude > 0)
+		{
+			stability -= (int32_t)(((int64_t)deviation << 15) / sqi->amplitude);
+		}
+		sqi->stability = (int16_t)((stability > 0) ? stability : 0);
+
+		// Red / IR coherence
+		int16_t coherence = sqi_correlation(n, sqi->sum_red, sqi->sum_ir,
+			sqi->sum_red2, sqi->sum_ir2, sqi->sum_red_ir);
+		sqi->coherence = (coherence > 0) ? coherence : 0;
+
+		// Clipping
+		int32_t clean = SQI_ONE - (int32_t)(((uint32_t)sqi->clipped << 17) / (uint32_t)n);
+		sqi->clean = (int16_t)((clean > 0) ? clean : 0);
+
+		int16_t q = fixmath_mul_q15(fixmath_mul_q15(sqi->shape, sqi->stability),
+			fixmath_mul_q15(sqi->coherence, sqi->clean));
+		score = (uint8_t)(((int32_t)q * 100 + (1l << 14)) >> 15);
+
+		// Learn from good beats only. While learning the score rests on the
+		// other three factors, which keeps motion out of a new template.
+		if (score >= SQI_ACCEPT)
+		{
+			sqi->rejected = 0;
+		}
+		else if (++sqi->rejected >= SQI_RELEARN_BEATS)
+		{
+			sqi->rejected = 0;
+			sqi->learned = 0;
+			sqi->template_mask = 0;
+			sqi->amplitude = event->amplitude;
+		}
+
+		if ((score >= SQI_ACCEPT) && sqi->timed && (sqi->beat_mask != 0))
+		{
+			uint8_t shift = learning ? 1u : SQI_TEMPLATE_SHIFT;
+
+			for (uint8_t p = 0; p < SQI_POINTS; p++)
+			{
+				if (sqi->beat_mask & (1ul << p))
+				{
+					if (sqi->template_mask & (1ul << p))
+					{
+						sqi->template[p] += (int16_t)((sqi->beat[p] - sqi->template[p]) >> shift);
+					}
+					else
+					{
+						sqi->template[p] = sqi->beat[p];
+					}
+				}
+			}
+			sqi->template_mask |= sqi->beat_mask;
+			sqi->amplitude += (event->amplitude - sqi->amplitude) >> SQI_AMPLITUDE_SHIFT;
+
+			if (learning)
+			{
+				sqi->learned++;
+			}
+		}
+	}
+
+	sqi->score = score;
+	sqi_begin_beat(sqi, event->interval);
+	return score;
+} // sqi_beat()
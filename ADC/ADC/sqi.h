@@ -0,0 +1,102 @@
+#ifndef SQI_H_
+#define SQI_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "beat.h"
+
+// Points a beat is resampled to for the shape comparison
+#define SQI_POINTS                (32u)
+
+// Longest beat scored, in beats per minute
+#define SQI_BPM_MIN               (30u)
+
+// Beats taken into the template before the shape is scored, each with a
+// weight of 1/2
+#define SQI_LEARN_BEATS           (4u)
+
+// Rejected beats in a row after which the template is learnt again, so a
+// lasting change of pulse shape is followed
+#define SQI_RELEARN_BEATS         (16u)
+
+// Template and mean amplitude follow accepted beats with a weight of 1/2^shift
+#define SQI_TEMPLATE_SHIFT        (3u)
+#define SQI_AMPLITUDE_SHIFT       (3u)
+
+// Beats scoring at least this (%) update the template and mean amplitude
+#define SQI_ACCEPT                (50u)
+
+// Template points in Q12, trough 0 and peak 4096
+#define SQI_TEMPLATE_FRAC_BITS    (12u)
+
+// Scorer state, one beat template and running sums for the current beat
+typedef struct
+{
+	// Template of accepted beats and the current beat, resampled
+	int16_t template[SQI_POINTS];
+	int16_t beat[SQI_POINTS];
+	uint32_t template_mask;    // template points set
+	uint32_t beat_mask;        // points the current beat reached
+	uint32_t phase;            // current point in Q16
+	uint32_t step;             // points per sample in Q16
+
+	// Red / IR coherence sums, inputs >> 4
+	int32_t sum_red, sum_ir;
+	int32_t sum_red2, sum_ir2, sum_red_ir;
+
+	uint16_t count;            // samples in the current beat
+	uint16_t clipped;          // of which clipped
+	uint16_t max_samples;      // longest beat in samples
+	uint16_t default_samples;  // expected length of the first beat
+	uint8_t learned;           // beats taken into the template, up to SQI_LEARN_BEATS
+	uint8_t rejected;          // beats in a row under SQI_ACCEPT
+	bool open;
+	bool timed;                // the beat's expected length was known
+
+	int32_t amplitude;         // mean amplitude of accepted beats
+
+	// Last beat, factors in Q15 (32767 is 1.0)
+	int16_t shape;             // correlation with the template
+	int16_t stability;         // 1 - |amplitude - mean| / mean
+	int16_t coherence;         // red / IR correlation
+	int16_t clean;             // 1 - 4 * clipped share
+	uint8_t score;             // product of the four, %
+} sqi_state_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def sqi_init
+ * \brief Resets the scorer and forgets the template
+ * \param sqi (scorer state)
+ * \param sample_rate_hz (rate of the samples fed to sqi_push)
+ */
+void sqi_init(sqi_state_t *sqi, uint16_t sample_rate_hz);
+
+
+/**
+ * \def sqi_push
+ * \brief Adds one sample to the current beat
+ * \param sqi (scorer state)
+ * \param pulse (pulse signal given to beat_push)
+ * \param red_ac (red less its baseline)
+ * \param ir_ac (IR less its baseline)
+ * \param clipped (true if red or IR is outside the valid ADC window)
+ */
+void sqi_push(sqi_state_t *sqi, int16_t pulse, int16_t red_ac, int16_t ir_ac, bool clipped);
+
+
+/**
+ * \def sqi_beat
+ * \brief Scores the beat closed by a beat_push() event, returns the score in % (0 if none)
+ * \param sqi (scorer state)
+ * \param event (beat event that closed the beat)
+ */
+uint8_t sqi_beat(sqi_state_t *sqi, const beat_event_t *event);
+
+
+#endif /* SQI_H_ */
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "tick.h"
+
+static volatile uint32_t tick_count;
+
+
+/*******************************************************************************
+ * Function:        void tick_init(void)
+ *
+ * PreCondition:    Clocks are configured
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    SysTick is reloaded every ms with its interrupt enabled
+ *
+ * Overview:        Millisecond time that runs whatever the acquisition is
+ *                  doing, including while the DMA is stopped for a probe off.
+ *
+ * Note:            bench_run() uses SysTick as a free running counter, so
+ *                  this comes after it
+ *
+ ******************************************************************************/
+void tick_init(void)
+{
+	tick_count = 0;
+
+	SysTick->CTRL = 0;
+	SysTick->LOAD = (TICK_CPU_HZ / 1000u) - 1u;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+} // tick_init()
+
+
+/*******************************************************************************
+ * Function:        uint32_t tick_ms(void)
+ *
+ * PreCondition:    tick_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          Milliseconds since tick_init()
+ *
+ * Side Effects:    None
+ *
+ * Overview:        A single 32-bit read, atomic on the Cortex-M0+.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+uint32_t tick_ms(void)
+{
+	return tick_count;
+} // tick_ms()
+
+
+/*******************************************************************************
+ * Function:        void SysTick_Handler(void)
+ *
+ * PreCondition:    tick_init() has been called
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Counts milliseconds.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void SysTick_Handler(void)
+{
+	tick_count++;
+} // SysTick_Handler()
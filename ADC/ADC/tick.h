@@ -0,0 +1,33 @@
+#ifndef TICK_H_
+#define TICK_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "app.h"
+
+// SysTick runs from the CPU clock
+#define TICK_CPU_HZ               (48000000ul)
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def tick_init
+ * \brief Starts a 1 ms SysTick interrupt, after bench_run() which takes SysTick over
+ * \param none
+ */
+void tick_init(void);
+
+
+/**
+ * \def tick_ms
+ * \brief Returns milliseconds since tick_init(), wraps after 49 days
+ * \param none
+ */
+uint32_t tick_ms(void);
+
+
+#endif /* TICK_H_ */
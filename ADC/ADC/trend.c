@@ -0,0 +1,263 @@
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include "trend.h"
+
+// Inputs per bucket of each horizon: seconds for the first, closed buckets
+// of the horizon before for the others
+static const uint8_t trend_parts[TREND_HORIZONS] = { 2u, 15u, 4u, 8u };
+
+// Position k from the front of a deque
+#define TREND_QUEUE_AT(head, k)   (((head) + (k)) % TREND_BUCKETS)
+
+
+/*******************************************************************************
+ * Function:        static void trend_merge(trend_bucket_t *into,
+ *                                          const trend_bucket_t *from)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Bucket to merge into and bucket to merge
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Combines two summaries. An empty bucket changes nothing.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void trend_merge(trend_bucket_t *into, const trend_bucket_t *from)
+{
+	if (from->count == 0u)
+	{
+		return;
+	}
+	if (into->count == 0u)
+	{
+		into->min = from->min;
+		into->max = from->max;
+	}
+	else
+	{
+		if (from->min < into->min) into->min = from->min;
+		if (from->max > into->max) into->max = from->max;
+	}
+	into->sum += from->sum;
+	into->count += from->count;
+} // trend_merge()
+
+
+/*******************************************************************************
+ * Function:        static void trend_close(trend_level_t *level,
+ *                                          const trend_bucket_t *closed)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Horizon and the bucket that just closed
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Stores the bucket in place of the oldest. The oldest
+ *                  leaves the sums, and the front of a deque if it is there;
+ *                  being the oldest it can be nowhere else. The new bucket
+ *                  then enters the back of each deque after the buckets it
+ *                  makes redundant are dropped: a bucket with a minimum no
+ *                  lower, or a maximum no higher, that will expire first can
+ *                  never be reported again.
+ *
+ * Note:            Amortised O(1), each bucket enters and leaves a deque once
+ *
+ ******************************************************************************/
+static void trend_close(trend_level_t *level, const trend_bucket_t *closed)
+{
+	uint8_t slot = level->head;
+
+	if (level->filled == TREND_BUCKETS)
+	{
+		level->sum -= level->bucket[slot].sum;
+		level->count -= level->bucket[slot].count;
+
+		if ((level->min_len != 0u) && (level->min_queue[level->min_head] == slot))
+		{
+			level->min_head = TREND_QUEUE_AT(level->min_head, 1u);
+			level->min_len--;
+		}
+		if ((level->max_len != 0u) && (level->max_queue[level->max_head] == slot))
+		{
+			level->max_head = TREND_QUEUE_AT(level->max_head, 1u);
+			level->max_len--;
+		}
+	}
+	else
+	{
+		level->filled++;
+	}
+
+	level->bucket[slot] = *closed;
+	level->sum += closed->sum;
+	level->count += closed->count;
+	level->head = (slot + 1u) % TREND_BUCKETS;
+
+	if (closed->count == 0u)
+	{
+		return;
+	}
+
+	while ((level->min_len != 0u) &&
+		(level->bucket[level->min_queue[TREND_QUEUE_AT(level->min_head, level->min_len - 1u)]].min >= closed->min))
+	{
+		level->min_len--;
+	}
+	level->min_queue[TREND_QUEUE_AT(level->min_head, level->min_len)] = slot;
+	level->min_len++;
+
+	while ((level->max_len != 0u) &&
+		(level->bucket[level->max_queue[TREND_QUEUE_AT(level->max_head, level->max_len - 1u)]].max <= closed->max))
+	{
+		level->max_len--;
+	}
+	level->max_queue[TREND_QUEUE_AT(level->max_head, level->max_len)] = slot;
+	level->max_len++;
+} // trend_close()
+
+
+/*******************************************************************************
+ * Function:        void trend_init(trend_t *trend)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Trend state
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Empties every horizon.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+void trend_init(trend_t *trend)
+{
+	for (uint8_t h = 0; h < TREND_HORIZONS; h++)
+	{
+		trend_level_t *level = &trend->level[h];
+
+		level->current = (trend_bucket_t){ 0 };
+		level->min_head = 0;
+		level->min_len = 0;
+		level->max_head = 0;
+		level->max_len = 0;
+		level->sum = 0;
+		level->count = 0;
+		level->head = 0;
+		level->filled = 0;
+		level->parts = 0;
+	}
+} // trend_init()
+
+
+/*******************************************************************************
+ * Function:        void trend_second(trend_t *trend, int16_t value, bool valid)
+ *
+ * PreCondition:    trend_init() has been called
+ *
+ * Input:           Trend state, this second's value and whether there is one
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Adds the value to the first horizon's current bucket. A
+ *                  bucket that fills up is closed into its ring and becomes
+ *                  one input of the next horizon, so each horizon sees only
+ *                  summaries and memory depends on the bucket count, not on
+ *                  the horizon length.
+ *
+ * Note:            A cascade through all four horizons happens once every
+ *                  16 minutes
+ *
+ ******************************************************************************/
+void trend_second(trend_t *trend, int16_t value, bool valid)
+{
+	trend_bucket_t input = { 0 };
+
+	if (valid)
+	{
+		input.sum = value;
+		input.count = 1;
+		input.min = value;
+		input.max = value;
+	}
+
+	for (uint8_t h = 0; h < TREND_HORIZONS; h++)
+	{
+		trend_level_t *level = &trend->level[h];
+
+		trend_merge(&level->current, &input);
+		if (++level->parts < trend_parts[h])
+		{
+			break;
+		}
+
+		input = level->current;
+		level->current = (trend_bucket_t){ 0 };
+		level->parts = 0;
+		trend_close(level, &input);
+	}
+} // trend_second()
+
+
+/*******************************************************************************
+ * Function:        bool trend_result(const trend_t *trend, trend_horizon_t horizon,
+ *                                    trend_result_t *result)
+ *
+ * PreCondition:    trend_init() has been called
+ *
+ * Input:           Trend state, horizon and output
+ *
+ * Output:          true if the horizon holds at least one value
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The ring's extremes are at the deque fronts. The buckets
+ *                  still being filled at this and every shorter horizon are
+ *                  merged in, so the result is current to the last second.
+ *
+ * Note:            One division, for the mean
+ *
+ ******************************************************************************/
+bool trend_result(const trend_t *trend, trend_horizon_t horizon, trend_result_t *result)
+{
+	const trend_level_t *level = &trend->level[horizon];
+	trend_bucket_t total = { 0 };
+
+	if (level->count != 0u)
+	{
+		total.sum = level->sum;
+		total.count = level->count;
+		total.min = level->bucket[level->min_queue[level->min_head]].min;
+		total.max = level->bucket[level->max_queue[level->max_head]].max;
+	}
+	for (uint8_t h = 0; h <= horizon; h++)
+	{
+		trend_merge(&total, &trend->level[h].current);
+	}
+
+	*result = (trend_result_t){ 0 };
+	if (total.count == 0u)
+	{
+		return false;
+	}
+
+	int32_t half = (int32_t)(total.count / 2u);
+	result->mean = (int16_t)(((total.sum < 0) ? (total.sum - half) : (total.sum + half)) / (int32_t)total.count);
+	result->min = total.min;
+	result->max = total.max;
+	result->count = total.count;
+	return true;
+} // trend_result()
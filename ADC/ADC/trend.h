@@ -0,0 +1,99 @@
+#ifndef TREND_H_
+#define TREND_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Include and defines
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+// Summary buckets per horizon. Each horizon covers its last TREND_BUCKETS
+// closed buckets and the one being filled.
+#define TREND_BUCKETS             (30u)
+
+// Horizons, each built from closed buckets of the one before: 2 s buckets
+// for 1 min, 30 s for 15 min, 2 min for 1 h and 16 min for 8 h
+typedef enum
+{
+	TREND_1MIN = 0,
+	TREND_15MIN,
+	TREND_1H,
+	TREND_8H,
+	TREND_HORIZONS
+} trend_horizon_t;
+
+// Summary of the values in a bucket
+typedef struct
+{
+	int32_t sum;
+	uint16_t count;          // values, 0 if none were valid
+	int16_t min;
+	int16_t max;
+} trend_bucket_t;
+
+// One horizon: a ring of closed buckets with monotonic deques of their
+// slots, minima ascending and maxima descending from the front
+typedef struct
+{
+	trend_bucket_t bucket[TREND_BUCKETS];
+	trend_bucket_t current;  // bucket being filled
+	uint8_t min_queue[TREND_BUCKETS];
+	uint8_t max_queue[TREND_BUCKETS];
+	uint8_t min_head, min_len;
+	uint8_t max_head, max_len;
+	int32_t sum;             // of the closed buckets in the ring
+	uint16_t count;
+	uint8_t head;            // next slot, the oldest once the ring is full
+	uint8_t filled;          // closed buckets in the ring
+	uint8_t parts;           // inputs in the current bucket
+} trend_level_t;
+
+// Trend of one value
+typedef struct
+{
+	trend_level_t level[TREND_HORIZONS];
+} trend_t;
+
+// Statistics over a horizon, in the units of the input
+typedef struct
+{
+	int16_t min;
+	int16_t max;
+	int16_t mean;
+	uint16_t count;          // valid values
+} trend_result_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Function Prototypes
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * \def trend_init
+ * \brief Clears every horizon
+ * \param trend (trend state)
+ */
+void trend_init(trend_t *trend);
+
+
+/**
+ * \def trend_second
+ * \brief Adds one second, with or without a value
+ * \param trend (trend state)
+ * \param value (value for this second)
+ * \param valid (false if there is no value, time still advances)
+ */
+void trend_second(trend_t *trend, int16_t value, bool valid);
+
+
+/**
+ * \def trend_result
+ * \brief Min, max and mean over a horizon, returns false if it holds no value
+ * \param trend (trend state)
+ * \param horizon (horizon to report)
+ * \param result (output)
+ */
+bool trend_result(const trend_t *trend, trend_horizon_t horizon, trend_result_t *result);
+
+
+#endif /* TREND_H_ */
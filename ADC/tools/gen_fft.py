@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Generates the FFT tables in ADC/fft_tables.c/.h.
+
+Twiddles: one period of sin() in Q15 with --size entries. cos() is read a
+quarter period further on, and smaller transforms step through the table.
+Bit reversal: the --size point bit reversed index of every input index,
+shifted right for smaller transforms.
+
+Only the standard library is used, so it runs wherever Python 3 does:
+
+    python3 ADC/tools/gen_fft.py --size 1024
+"""
+
+import argparse
+import math
+import os
+
+TWIDDLE_SHIFT = 15
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+	parser.add_argument("--size", type=int, default=1024, help="largest transform, a power of two")
+	parser.add_argument("--out", default=os.path.join(os.path.dirname(__file__), "..", "ADC"))
+	args = parser.parse_args()
+
+	if args.size < 4 or args.size > 4096 or args.size & (args.size - 1):
+		raise SystemExit("--size must be a power of two, 4..4096")
+
+	bits = args.size.bit_length() - 1
+	sine = [min(32767, int(round(math.sin(2.0 * math.pi * i / args.size) * (1 << TWIDDLE_SHIFT))))
+		for i in range(args.size)]
+	bitrev = [int(format(i, "0%db" % bits)[::-1], 2) for i in range(args.size)]
+
+	command = "python3 ADC/tools/gen_fft.py --size %d" % args.size
+
+	header = [
+		"#ifndef FFT_TABLES_H_",
+		"#define FFT_TABLES_H_",
+		"",
+		"// Generated by ADC/tools/gen_fft.py, do not edit. To regenerate:",
+		"// " + command,
+		"",
+		"//////////////////////////////////////////////////////////////////////////",
+		"// Include and defines",
+		"//////////////////////////////////////////////////////////////////////////",
+		"#include <stdint.h>",
+		"",
+		"// Largest transform and its log2",
+		"#define FFT_SIZE_MAX              (%du)" % args.size,
+		"#define FFT_LOG2_MAX              (%du)" % bits,
+		"",
+		"// sin(2 pi i / FFT_SIZE_MAX) in Q%d" % TWIDDLE_SHIFT,
+		"#define FFT_TWIDDLE_SHIFT         (%du)" % TWIDDLE_SHIFT,
+		"",
+		"extern const int16_t fft_sine[FFT_SIZE_MAX];",
+		"extern const uint16_t fft_bitrev[FFT_SIZE_MAX];",
+		"",
+		"#endif /* FFT_TABLES_H_ */",
+		"",
+	]
+
+	source = [
+		"// Generated by ADC/tools/gen_fft.py, do not edit. To regenerate:",
+		"// " + command,
+		"",
+		"#include \"fft_tables.h\"",
+		"",
+		"const int16_t fft_sine[FFT_SIZE_MAX] =",
+		"{",
+	]
+	for i in range(0, len(sine), 8):
+		sep = "," if i + 8 < len(sine) else ""
+		source.append("\t" + ", ".join("%6d" % v for v in sine[i:i + 8]) + sep)
+	source += ["};", "", "const uint16_t fft_bitrev[FFT_SIZE_MAX] =", "{"]
+	for i in range(0, len(bitrev), 8):
+		sep = "," if i + 8 < len(bitrev) else ""
+		source.append("\t" + ", ".join("%5d" % v for v in bitrev[i:i + 8]) + sep)
+	source += ["};", ""]
+
+	with open(os.path.join(args.out, "fft_tables.h"), "w", newline="\n") as f:
+		f.write("\n".join(header))
+	with open(os.path.join(args.out, "fft_tables.c"), "w", newline="\n") as f:
+		f.write("\n".join(source))
+
+
+if __name__ == "__main__":
+	main()
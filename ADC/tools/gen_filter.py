@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Generates the fixed-point filter tables in ADC/filter_coeffs.c/.h.
+
+Band-pass: Butterworth high-pass at --low and low-pass at --high, each of
+--order (even), as a cascade of biquads in Q14 (coefficients reach +/-2).
+Smoothing FIR: Hamming windowed-sinc low-pass at --fir-high (--high if not
+given) with --fir-taps (odd) taps in Q15, rounded so the DC gain is exactly
+1. It keeps the pulse shape for morph.c, so its cutoff sits above the
+band-pass edge.
+Goertzel bank: 2 cos(w) in Q14 for each heart rate bin from --bpm-min to
+--bpm-max in --bpm-step, at fs / --goertzel-decim.
+
+Only the standard library is used, so it runs wherever Python 3 does:
+
+    python3 ADC/tools/gen_filter.py --fs 100 --low 0.5 --high 5 --order 4 --fir-taps 31 \
+        --fir-high 10 --goertzel-decim 4 --bpm-min 30 --bpm-max 240 --bpm-step 1
+"""
+
+import argparse
+import math
+import os
+
+BIQUAD_SHIFT = 14
+FIR_SHIFT = 15
+
+
+def butterworth_q(order):
+	"""Q of each biquad in an even order Butterworth cascade."""
+	return [1.0 / (2.0 * math.sin((2 * k + 1) * math.pi / (2 * order))) for k in range(order // 2)]
+
+
+def biquad(kind, fc, fs, q):
+	"""Bilinear transform biquad, normalised to a0 = 1: (b0, b1, b2, a1, a2)."""
+	w0 = 2.0 * math.pi * fc / fs
+	cw = math.cos(w0)
+	alpha = math.sin(w0) / (2.0 * q)
+	if kind == "lp":
+		b = [(1.0 - cw) / 2.0, 1.0 - cw, (1.0 - cw) / 2.0]
+	else:
+		b = [(1.0 + cw) / 2.0, -(1.0 + cw), (1.0 + cw) / 2.0]
+	a0 = 1.0 + alpha
+	return [b[0] / a0, b[1] / a0, b[2] / a0, (-2.0 * cw) / a0, (1.0 - alpha) / a0]
+
+
+def quantise_biquad(kind, c):
+	"""Q14 biquad with the numerator rounded as a whole: b1 = +/-2 b0 keeps the
+	high-pass zero exactly at DC and the low-pass DC gain at 1 within an LSB."""
+	a1 = quantise(c[3], BIQUAD_SHIFT)
+	a2 = quantise(c[4], BIQUAD_SHIFT)
+	if kind == "hp":
+		b0 = quantise(c[0], BIQUAD_SHIFT)
+		return [b0, -2 * b0, b0, a1, a2]
+	b0 = int(round(((1 << BIQUAD_SHIFT) + a1 + a2) / 4.0))
+	return [b0, 2 * b0, b0, a1, a2]
+
+
+def quantise(value, shift):
+	q = int(round(value * (1 << shift)))
+	if q < -32768 or q > 32767:
+		raise SystemExit("coefficient %f does not fit Q%d" % (value, shift))
+	return q
+
+
+def fir_lowpass(fc, fs, taps):
+	"""Hamming windowed-sinc low-pass in Q15 with a DC gain of exactly 1."""
+	mid = (taps - 1) // 2
+	h = []
+	for n in range(taps):
+		m = n - mid
+		x = 2.0 * fc / fs
+		sinc = x if m == 0 else math.sin(math.pi * x * m) / (math.pi * m)
+		w = 0.54 - 0.46 * math.cos(2.0 * math.pi * n / (taps - 1))
+		h.append(sinc * w)
+	total = sum(h)
+	q = [int(round(v / total * (1 << FIR_SHIFT))) for v in h]
+	q[mid] += (1 << FIR_SHIFT) - sum(q)
+	return q
+
+
+def goertzel_bank(fs, bpm_min, bpm_max, step):
+	"""Q14 resonator coefficient 2 cos(w) of each bin, with w below pi/2 so
+	every coefficient is positive and under 2."""
+	bank = []
+	for bpm in range(bpm_min, bpm_max + 1, step):
+		w = 2.0 * math.pi * (bpm / 60.0) / fs
+		if w >= math.pi / 2.0:
+			raise SystemExit("%d bpm is above fs/4 of the Goertzel bank" % bpm)
+		bank.append((bpm, quantise(2.0 * math.cos(w), BIQUAD_SHIFT)))
+	return bank
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+	parser.add_argument("--fs", type=float, default=100.0, help="sample rate in Hz")
+	parser.add_argument("--low", type=float, default=0.5, help="pass band low edge in Hz")
+	parser.add_argument("--high", type=float, default=5.0, help="pass band high edge in Hz")
+	parser.add_argument("--order", type=int, default=4, help="order of each edge, even")
+	parser.add_argument("--fir-taps", type=int, default=31, help="smoothing FIR taps, odd")
+	parser.add_argument("--fir-high", type=float, default=None, help="smoothing FIR cutoff in Hz, --high if not given")
+	parser.add_argument("--goertzel-decim", type=int, default=4, help="Goertzel bank decimation (bin groups)")
+	parser.add_argument("--bpm-min", type=int, default=30, help="lowest Goertzel bin in bpm")
+	parser.add_argument("--bpm-max", type=int, default=240, help="highest Goertzel bin in bpm")
+	parser.add_argument("--bpm-step", type=int, default=1, help="Goertzel bin spacing in bpm")
+	parser.add_argument("--out", default=os.path.join(os.path.dirname(__file__), "..", "ADC"))
+	args = parser.parse_args()
+
+	if args.order < 2 or args.order % 2:
+		raise SystemExit("--order must be even")
+	if args.fir_taps < 3 or args.fir_taps % 2 == 0 or args.fir_taps > 127:
+		raise SystemExit("--fir-taps must be odd, 3..127")
+	if not 0.0 < args.low < args.high < args.fs / 2.0:
+		raise SystemExit("need 0 < low < high < fs/2")
+	if args.fir_high is None:
+		args.fir_high = args.high
+	if not 0.0 < args.fir_high < args.fs / 2.0:
+		raise SystemExit("need 0 < fir-high < fs/2")
+
+	if args.goertzel_decim < 1 or args.bpm_step < 1 or not 0 < args.bpm_min < args.bpm_max:
+		raise SystemExit("need decim >= 1, step >= 1 and 0 < bpm-min < bpm-max")
+
+	sections = []
+	for q in butterworth_q(args.order):
+		sections.append(("high-pass %.2f Hz, Q %.4f" % (args.low, q), quantise_biquad("hp", biquad("hp", args.low, args.fs, q))))
+	for q in butterworth_q(args.order):
+		sections.append(("low-pass %.2f Hz, Q %.4f" % (args.high, q), quantise_biquad("lp", biquad("lp", args.high, args.fs, q))))
+	fir = fir_lowpass(args.fir_high, args.fs, args.fir_taps)
+	goertzel_fs = args.fs / args.goertzel_decim
+	bank = goertzel_bank(goertzel_fs, args.bpm_min, args.bpm_max, args.bpm_step)
+
+	spec = "fs %g Hz, pass band %g-%g Hz, order %d, %d FIR taps to %g Hz" % (
+		args.fs, args.low, args.high, args.order, args.fir_taps, args.fir_high)
+	command = "python3 ADC/tools/gen_filter.py --fs %g --low %g --high %g --order %d --fir-taps %d --fir-high %g" % (
+		args.fs, args.low, args.high, args.order, args.fir_taps, args.fir_high)
+	command += " --goertzel-decim %d --bpm-min %d --bpm-max %d --bpm-step %d" % (
+		args.goertzel_decim, args.bpm_min, args.bpm_max, args.bpm_step)
+
+	header = [
+		"#ifndef FILTER_COEFFS_H_",
+		"#define FILTER_COEFFS_H_",
+		"",
+		"// Generated by ADC/tools/gen_filter.py, do not edit. To regenerate:",
+		"// " + command,
+		"",
+		"//////////////////////////////////////////////////////////////////////////",
+		"// Include and defines",
+		"//////////////////////////////////////////////////////////////////////////",
+		"#include <stdint.h>",
+		"",
+		"// " + spec,
+		"#define FILTER_SAMPLE_RATE_HZ     (%du)" % int(round(args.fs)),
+		"",
+		"// Band-pass biquads: b0, b1, b2, a1, a2 in Q%d (a0 = 1)" % BIQUAD_SHIFT,
+		"#define FILTER_BIQUAD_SHIFT       (%du)" % BIQUAD_SHIFT,
+		"#define FILTER_BIQUAD_COEFFS      (5u)",
+		"#define FILTER_BIQUAD_SECTIONS    (%du)" % len(sections),
+		"",
+		"// Smoothing FIR in Q%d, symmetric" % FIR_SHIFT,
+		"#define FILTER_FIR_SHIFT          (%du)" % FIR_SHIFT,
+		"#define FILTER_FIR_TAPS           (%du)" % len(fir),
+		"",
+		"// Goertzel bank at %g Hz: 2 cos(w) in Q%d for %d-%d bpm in %d bpm steps" % (
+			goertzel_fs, BIQUAD_SHIFT, args.bpm_min, bank[-1][0], args.bpm_step),
+		"#define FILTER_GOERTZEL_DECIM     (%du)" % args.goertzel_decim,
+		"#define FILTER_GOERTZEL_BPM_MIN   (%du)" % args.bpm_min,
+		"#define FILTER_GOERTZEL_BPM_STEP  (%du)" % args.bpm_step,
+		"#define FILTER_GOERTZEL_BINS      (%du)" % len(bank),
+		"",
+		"extern const int16_t filter_bandpass_coeffs[FILTER_BIQUAD_SECTIONS][FILTER_BIQUAD_COEFFS];",
+		"extern const int16_t filter_fir_coeffs[FILTER_FIR_TAPS];",
+		"extern const int16_t filter_goertzel_coeffs[FILTER_GOERTZEL_BINS];",
+		"",
+		"#endif /* FILTER_COEFFS_H_ */",
+		"",
+	]
+
+	source = [
+		"// Generated by ADC/tools/gen_filter.py, do not edit. To regenerate:",
+		"// " + command,
+		"",
+		"#include \"filter_coeffs.h\"",
+		"",
+		"const int16_t filter_bandpass_coeffs[FILTER_BIQUAD_SECTIONS][FILTER_BIQUAD_COEFFS] =",
+		"{",
+	]
+	for i, (name, c) in enumerate(sections):
+		values = ", ".join("%6d" % v for v in c)
+		sep = "," if i + 1 < len(sections) else " "
+		source.append("\t{ %s }%s  // %s" % (values, sep, name))
+	source += ["};", "", "const int16_t filter_fir_coeffs[FILTER_FIR_TAPS] =", "{"]
+	for i in range(0, len(fir), 8):
+		chunk = fir[i:i + 8]
+		sep = "," if i + 8 < len(fir) else ""
+		source.append("\t" + ", ".join("%5d" % v for v in chunk) + sep)
+	source += ["};", "", "const int16_t filter_goertzel_coeffs[FILTER_GOERTZEL_BINS] =", "{"]
+	for i in range(0, len(bank), 8):
+		chunk = bank[i:i + 8]
+		sep = "," if i + 8 < len(bank) else ""
+		source.append("\t" + ", ".join("%5d" % c for _, c in chunk) + sep + "  // %d bpm" % chunk[0][0])
+	source += ["};", ""]
+
+	with open(os.path.join(args.out, "filter_coeffs.h"), "w", newline="\n") as f:
+		f.write("\n".join(header))
+	with open(os.path.join(args.out, "filter_coeffs.c"), "w", newline="\n") as f:
+		f.write("\n".join(source))
+
+
+if __name__ == "__main__":
+	main()
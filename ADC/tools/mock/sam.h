@@ -0,0 +1,172 @@
+#ifndef SAM_H_
+#define SAM_H_
+
+//////////////////////////////////////////////////////////////////////////
+// Host stand-in for the SAMD21 device header
+//
+// Only what adc_dma.c and dma.c touch. The registers are plain memory in
+// the test, which also plays the part of the DMAC and the NVIC, see
+// ADC/tools/test_adc_dma.c. The DMAC channel registers are not banked by
+// CHID, one channel is modelled.
+//////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+typedef enum
+{
+	DMAC_IRQn = 6
+} IRQn_Type;
+
+typedef struct { uint8_t reg; } MOCK_REG8_Type;
+typedef struct { uint16_t reg; } MOCK_REG16_Type;
+typedef struct { uint32_t reg; } MOCK_REG32_Type;
+
+//////////////////////////////////////////////////////////////////////////
+// DMAC
+//////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+	MOCK_REG16_Type BTCTRL;
+	MOCK_REG16_Type BTCNT;
+	MOCK_REG32_Type SRCADDR;
+	MOCK_REG32_Type DSTADDR;
+	MOCK_REG32_Type DESCADDR;
+} DmacDescriptor;
+
+typedef union
+{
+	struct
+	{
+		uint16_t SWRST:1;
+		uint16_t DMAENABLE:1;
+		uint16_t :14;
+	} bit;
+	uint16_t reg;
+} DMAC_CTRL_Type;
+
+typedef union
+{
+	struct
+	{
+		uint8_t SWRST:1;
+		uint8_t ENABLE:1;
+		uint8_t :6;
+	} bit;
+	uint8_t reg;
+} DMAC_CHCTRLA_Type;
+
+typedef struct
+{
+	volatile DMAC_CTRL_Type CTRL;
+	volatile MOCK_REG32_Type BASEADDR;
+	volatile MOCK_REG32_Type WRBADDR;
+	volatile MOCK_REG32_Type INTSTATUS;
+	volatile MOCK_REG8_Type CHID;
+	volatile DMAC_CHCTRLA_Type CHCTRLA;
+	volatile MOCK_REG32_Type CHCTRLB;
+	volatile MOCK_REG8_Type CHINTENSET;
+	volatile MOCK_REG8_Type CHINTFLAG;
+} Dmac;
+
+#define DMAC_CTRL_SWRST              (1u << 0)
+#define DMAC_CTRL_DMAENABLE          (1u << 1)
+#define DMAC_CTRL_LVLEN(value)       (((value) & 0xFu) << 8)
+
+#define DMAC_CHID_ID(value)          ((value) & 0xFu)
+
+#define DMAC_CHCTRLA_SWRST           (1u << 0)
+#define DMAC_CHCTRLA_ENABLE          (1u << 1)
+
+#define DMAC_CHCTRLB_LVL(value)      (((value) & 0x3u) << 5)
+#define DMAC_CHCTRLB_TRIGSRC_Pos     (8u)
+#define DMAC_CHCTRLB_TRIGSRC_Msk     (0x3Fu << DMAC_CHCTRLB_TRIGSRC_Pos)
+#define DMAC_CHCTRLB_TRIGSRC(value)  (((value) & 0x3Fu) << DMAC_CHCTRLB_TRIGSRC_Pos)
+#define DMAC_CHCTRLB_TRIGACT_Msk     (0x3u << 22)
+#define DMAC_CHCTRLB_TRIGACT_BEAT    (0x2u << 22)
+
+#define DMAC_CHINTENSET_TERR         (1u << 0)
+#define DMAC_CHINTENSET_TCMPL        (1u << 1)
+#define DMAC_CHINTFLAG_TERR          (1u << 0)
+#define DMAC_CHINTFLAG_TCMPL         (1u << 1)
+
+#define DMAC_BTCTRL_VALID            (1u << 0)
+#define DMAC_BTCTRL_BLOCKACT_Msk     (0x3u << 3)
+#define DMAC_BTCTRL_BLOCKACT_INT     (0x1u << 3)
+#define DMAC_BTCTRL_BEATSIZE_Msk     (0x3u << 8)
+#define DMAC_BTCTRL_BEATSIZE_HWORD   (0x1u << 8)
+#define DMAC_BTCTRL_SRCINC           (1u << 10)
+#define DMAC_BTCTRL_DSTINC           (1u << 11)
+
+//////////////////////////////////////////////////////////////////////////
+// PM
+//////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+	volatile MOCK_REG32_Type AHBMASK;
+	volatile MOCK_REG32_Type APBBMASK;
+} Pm;
+
+#define PM_AHBMASK_DMAC              (1u << 5)
+#define PM_APBBMASK_DMAC             (1u << 4)
+
+//////////////////////////////////////////////////////////////////////////
+// ADC
+//////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+	volatile MOCK_REG16_Type RESULT;
+	volatile union
+	{
+		struct
+		{
+			uint8_t STARTEI:1;
+			uint8_t SYNCEI:1;
+			uint8_t :6;
+		} bit;
+		uint8_t reg;
+	} EVCTRL;
+	volatile union
+	{
+		struct
+		{
+			uint16_t DIFFMODE:1;
+			uint16_t LEFTADJ:1;
+			uint16_t FREERUN:1;
+			uint16_t :13;
+		} bit;
+		uint16_t reg;
+	} CTRLB;
+	volatile union
+	{
+		struct
+		{
+			uint8_t :7;
+			uint8_t SYNCBUSY:1;
+		} bit;
+		uint8_t reg;
+	} STATUS;
+	volatile MOCK_REG8_Type SWTRIG;
+} Adc;
+
+#define ADC_SWTRIG_FLUSH             (1u << 0)
+#define ADC_SWTRIG_START             (1u << 1)
+#define ADC_DMAC_ID_RESRDY           (0x27u)
+
+//////////////////////////////////////////////////////////////////////////
+// Instances and core functions, defined by the test
+//////////////////////////////////////////////////////////////////////////
+
+// Every access goes through the test so that resets can complete
+Dmac *mock_dmac(void);
+extern Pm mock_pm;
+extern Adc mock_adc;
+
+#define DMAC                         (mock_dmac())
+#define PM                           (&mock_pm)
+#define ADC                          (&mock_adc)
+
+void __disable_irq(void);
+void __enable_irq(void);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void DMAC_Handler(void);
+
+#endif /* SAM_H_ */
@@ -0,0 +1,422 @@
+/*
+ * Replays synthetic desaturations and pulse stops through the alarm engine
+ * (ADC/alarm.c) on the host and prints the latency distributions.
+ *
+ * Desaturations: SpO2 falls from a baseline at a rate drawn per trial and is
+ * only seen at beats, with noise, as on the target. The latency is from the
+ * true SpO2 crossing ALARM_SPO2_LOW to the raise, less ALARM_SPO2_DELAY_MS,
+ * and counts as 0 when noise brought the raise forward. A raise before the
+ * noisy SpO2 could first have crossed, plus the delay, is early.
+ *
+ * Pulse stops: beats at a heart rate drawn per trial stop with the probe
+ * still on. The latency is from the last beat to HR low being raised, less
+ * ALARM_HR_STALE_MS and ALARM_HR_DELAY_MS.
+ *
+ * A probe that comes off after the pulse has stopped must not raise HR low.
+ *
+ * Motion: accepted beats give way to REPLAY_MOTION_MS of beats the SQI
+ * turns down, at irregular intervals, which the main loop passes on with
+ * alarm_seen(). HR low must stay quiet through them, then be raised once
+ * the beats stop, with the latency from the last one as above.
+ *
+ * Exits non-zero if any event is missed or an alarm is raised early.
+ *
+ * Only the C library is used, so it builds wherever gcc does:
+ *
+ *     gcc -std=gnu99 -Wall -Wextra -O2 -IADC/ADC -o replay_alarm \
+ *         ADC/tools/replay_alarm.c ADC/ADC/alarm.c
+ *     ./replay_alarm [trials] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "alarm.h"
+
+#define REPLAY_TRIALS      (1000u)
+#define REPLAY_SEED        (54321u)
+
+// Main loop period, alarm_tick() runs once a pass
+#define REPLAY_TICK_MS     (10u)
+#define REPLAY_TIMEOUT_MS  (300000u)
+
+// SpO2 in 0.1 %
+#define REPLAY_BASELINE    (970)
+#define REPLAY_NADIR       (750)
+#define REPLAY_NOISE       (5)
+
+// Rejected beats before the pulse stops
+#define REPLAY_MOTION_MS   (120000u)
+
+#define REPLAY_BIN_MS      (250u)
+#define REPLAY_BINS        (16u)
+
+#define REPLAY_CASES       (4u)
+
+typedef struct
+{
+	const char *name;
+	uint32_t *latency;
+	uint32_t count;
+	uint32_t missed;
+	uint32_t early;
+} replay_result_t;
+
+
+/*******************************************************************************
+ * Function:        static uint32_t replay_random(uint32_t *seed, uint32_t range)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Generator state and range
+ *
+ * Output:          Uniform value in 0..range-1
+ *
+ * Side Effects:    None
+ *
+ * Overview:        xorshift32, so runs repeat on every host.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static uint32_t replay_random(uint32_t *seed, uint32_t range)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed % range;
+} // replay_random()
+
+
+/*******************************************************************************
+ * Function:        static void replay_desaturation(alarm_engine_t *engine,
+ *                                                  uint32_t *seed,
+ *                                                  replay_result_t *result)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Engine, generator state and result to add to
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        One desaturation at 40-180 bpm, falling 0.2-4 %/s from
+ *                  a random onset.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void replay_desaturation(alarm_engine_t *engine, uint32_t *seed, replay_result_t *result)
+{
+	uint32_t beat_ms = 60000u / (40u + replay_random(seed, 141u));
+	uint32_t fall_x10 = 2u + replay_random(seed, 39u);         // 0.1 %/s
+	uint32_t onset_ms = 5000u + replay_random(seed, 20000u);
+	uint32_t cross_ms = onset_ms + (((REPLAY_BASELINE - ALARM_SPO2_LOW) * 1000u) / fall_x10);
+	uint32_t noisy_ms = onset_ms + (((REPLAY_BASELINE - ALARM_SPO2_LOW - REPLAY_NOISE) * 1000u) / fall_x10);
+	uint32_t next_beat = replay_random(seed, beat_ms);
+
+	alarm_init(engine);
+	for (uint32_t now = 0; now < REPLAY_TIMEOUT_MS; now += REPLAY_TICK_MS)
+	{
+		bool raised = false;
+
+		if (now >= next_beat)
+		{
+			int32_t spo2 = REPLAY_BASELINE;
+
+			if (now > onset_ms)
+			{
+				spo2 -= (int32_t)(((now - onset_ms) * fall_x10) / 1000u);
+			}
+			if (spo2 < REPLAY_NADIR)
+			{
+				spo2 = REPLAY_NADIR;
+			}
+			spo2 += (int32_t)replay_random(seed, 2u * REPLAY_NOISE + 1u) - REPLAY_NOISE;
+
+			alarm_update(engine, ALARM_HR_BRADY, (int32_t)(600000u / beat_ms), true, now);
+			raised = alarm_update(engine, ALARM_SPO2, spo2, true, now);
+			next_beat += beat_ms;
+		}
+		raised |= ((alarm_tick(engine, now) & (1u << ALARM_SPO2)) != 0u);
+
+		if (raised && (engine->alarm[ALARM_SPO2].level != ALARM_NONE))
+		{
+			if (now < (noisy_ms + ALARM_SPO2_DELAY_MS))
+			{
+				result->early++;
+			}
+			result->latency[result->count++] = (now > (cross_ms + ALARM_SPO2_DELAY_MS)) ?
+				(now - cross_ms - ALARM_SPO2_DELAY_MS) : 0u;
+			return;
+		}
+	}
+	result->missed++;
+} // replay_desaturation()
+
+
+/*******************************************************************************
+ * Function:        static void replay_pulse_stop(alarm_engine_t *engine,
+ *                                                uint32_t *seed,
+ *                                                replay_result_t *result,
+ *                                                bool probe_off)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Engine, generator state, result to add to and whether
+ *                  the probe comes off after the pulse stops
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Beats at 45-180 bpm stop at a random time. With the probe
+ *                  on HR low must be raised. With the probe taken off a
+ *                  second later, as the main loop does on PROBE_EVENT_LOST,
+ *                  HR low must stay quiet and a raise counts as early.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void replay_pulse_stop(alarm_engine_t *engine, uint32_t *seed, replay_result_t *result, bool probe_off)
+{
+	uint32_t beat_ms = 60000u / (45u + replay_random(seed, 136u));
+	uint32_t stop_ms = 10000u + replay_random(seed, 20000u);
+	uint32_t next_beat = replay_random(seed, beat_ms);
+	uint32_t last_beat = 0;
+	uint32_t due_ms = 0;
+
+	alarm_init(engine);
+	for (uint32_t now = 0; now < REPLAY_TIMEOUT_MS; now += REPLAY_TICK_MS)
+	{
+		if ((now >= next_beat) && (now < stop_ms))
+		{
+			alarm_update(engine, ALARM_HR_BRADY, (int32_t)(600000u / beat_ms), true, now);
+			last_beat = now;
+			due_ms = last_beat + ALARM_HR_STALE_MS + ALARM_HR_DELAY_MS;
+			next_beat += beat_ms;
+		}
+		if (probe_off && (now == (stop_ms - (stop_ms % REPLAY_TICK_MS) + 1000u)))
+		{
+			alarm_update(engine, ALARM_HR_BRADY, 0, false, now);
+		}
+		alarm_tick(engine, now);
+
+		if (engine->alarm[ALARM_HR_BRADY].level != ALARM_NONE)
+		{
+			if (probe_off || (now < stop_ms) || ((now + REPLAY_TICK_MS) < due_ms))
+			{
+				result->early++;
+				return;
+			}
+			result->latency[result->count++] = (now > due_ms) ? (now - due_ms) : 0u;
+			return;
+		}
+	}
+	if (!probe_off)
+	{
+		result->missed++;
+	}
+} // replay_pulse_stop()
+
+
+/*******************************************************************************
+ * Function:        static void replay_motion(alarm_engine_t *engine,
+ *                                            uint32_t *seed,
+ *                                            replay_result_t *result)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Engine, generator state and result to add to
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Accepted beats at 45-180 bpm until a random time, then
+ *                  REPLAY_MOTION_MS of rejected beats between half and one
+ *                  and a half intervals apart, some of them far enough apart
+ *                  for HR to go stale, then nothing. Any raise before the
+ *                  beats stop counts as early.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void replay_motion(alarm_engine_t *engine, uint32_t *seed, replay_result_t *result)
+{
+	uint32_t beat_ms = 60000u / (45u + replay_random(seed, 136u));
+	uint32_t motion_ms = 10000u + replay_random(seed, 20000u);
+	uint32_t stop_ms = motion_ms + REPLAY_MOTION_MS;
+	uint32_t next_beat = replay_random(seed, beat_ms);
+	uint32_t due_ms = 0;
+
+	alarm_init(engine);
+	for (uint32_t now = 0; now < (stop_ms + REPLAY_TIMEOUT_MS); now += REPLAY_TICK_MS)
+	{
+		if ((now >= next_beat) && (now < stop_ms))
+		{
+			if (now < motion_ms)
+			{
+				alarm_update(engine, ALARM_HR_BRADY, (int32_t)(600000u / beat_ms), true, now);
+				next_beat += beat_ms;
+			}
+			else
+			{
+				alarm_seen(engine, ALARM_HR_BRADY, now);
+				next_beat += (beat_ms / 2u) + replay_random(seed, beat_ms + 1u);
+			}
+			due_ms = now + ALARM_HR_STALE_MS + ALARM_HR_DELAY_MS;
+		}
+		alarm_tick(engine, now);
+
+		if (engine->alarm[ALARM_HR_BRADY].level != ALARM_NONE)
+		{
+			if ((now < stop_ms) || ((now + REPLAY_TICK_MS) < due_ms))
+			{
+				result->early++;
+				return;
+			}
+			result->latency[result->count++] = (now > due_ms) ? (now - due_ms) : 0u;
+			return;
+		}
+	}
+	result->missed++;
+} // replay_motion()
+
+
+/*******************************************************************************
+ * Function:        static int replay_compare(const void *a, const void *b)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Two latencies
+ *
+ * Output:          qsort() order
+ *
+ * Side Effects:    None
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int replay_compare(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+} // replay_compare()
+
+
+/*******************************************************************************
+ * Function:        static void replay_print(replay_result_t *result, uint32_t trials)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Result and the number of trials run
+ *
+ * Output:          None
+ *
+ * Side Effects:    The latencies are sorted
+ *
+ * Overview:        Counts, percentiles and a histogram of the latencies.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void replay_print(replay_result_t *result, uint32_t trials)
+{
+	uint32_t bins[REPLAY_BINS] = { 0 };
+	uint64_t sum = 0;
+
+	printf("%s: %u of %u raised, %u missed, %u early\n", result->name,
+		(unsigned)result->count, (unsigned)trials, (unsigned)result->missed, (unsigned)result->early);
+	if (result->count == 0u)
+	{
+		return;
+	}
+
+	qsort(result->latency, result->count, sizeof(result->latency[0]), replay_compare);
+	for (uint32_t i = 0; i < result->count; i++)
+	{
+		uint32_t bin = result->latency[i] / REPLAY_BIN_MS;
+
+		bins[(bin < REPLAY_BINS) ? bin : (REPLAY_BINS - 1u)]++;
+		sum += result->latency[i];
+	}
+
+	printf("  latency after the delay: min %u, median %u, p90 %u, p99 %u, max %u, mean %u ms\n",
+		(unsigned)result->latency[0],
+		(unsigned)result->latency[result->count / 2u],
+		(unsigned)result->latency[(result->count * 90u) / 100u],
+		(unsigned)result->latency[(result->count * 99u) / 100u],
+		(unsigned)result->latency[result->count - 1u],
+		(unsigned)(sum / result->count));
+	for (uint32_t bin = 0; bin < REPLAY_BINS; bin++)
+	{
+		if (bins[bin] == 0u)
+		{
+			continue;
+		}
+		if (bin == (REPLAY_BINS - 1u))
+		{
+			printf("  >= %5u ms: %u\n", (unsigned)(bin * REPLAY_BIN_MS), (unsigned)bins[bin]);
+		}
+		else
+		{
+			printf("  < %6u ms: %u\n", (unsigned)((bin + 1u) * REPLAY_BIN_MS), (unsigned)bins[bin]);
+		}
+	}
+} // replay_print()
+
+
+int main(int argc, char **argv)
+{
+	uint32_t trials = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : REPLAY_TRIALS;
+	uint32_t seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : REPLAY_SEED;
+	static alarm_engine_t engine;
+	replay_result_t results[REPLAY_CASES] =
+	{
+		{ "SpO2 low, desaturations", NULL, 0, 0, 0 },
+		{ "HR low, pulse stops", NULL, 0, 0, 0 },
+		{ "HR low, pulse stops then probe off", NULL, 0, 0, 0 },
+		{ "HR low, rejected beats then pulse stops", NULL, 0, 0, 0 }
+	};
+	int failed = 0;
+
+	if ((trials == 0u) || (seed == 0u))
+	{
+		fprintf(stderr, "usage: %s [trials > 0] [seed != 0]\n", argv[0]);
+		return 2;
+	}
+
+	for (uint8_t r = 0; r < REPLAY_CASES; r++)
+	{
+		results[r].latency = calloc(trials, sizeof(uint32_t));
+		if (results[r].latency == NULL)
+		{
+			return 2;
+		}
+	}
+
+	for (uint32_t trial = 0; trial < trials; trial++)
+	{
+		replay_desaturation(&engine, &seed, &results[0]);
+		replay_pulse_stop(&engine, &seed, &results[1], false);
+		replay_pulse_stop(&engine, &seed, &results[2], true);
+		replay_motion(&engine, &seed, &results[3]);
+	}
+
+	printf("%u trials, seed %u, main loop every %u ms\n", (unsigned)trials,
+		(unsigned)((argc > 2) ? strtoul(argv[2], NULL, 0) : REPLAY_SEED), (unsigned)REPLAY_TICK_MS);
+	for (uint8_t r = 0; r < REPLAY_CASES; r++)
+	{
+		replay_print(&results[r], trials);
+		failed |= (results[r].missed != 0u) || (results[r].early != 0u);
+		free(results[r].latency);
+	}
+	return failed;
+}
@@ -0,0 +1,750 @@
+/*
+ * Checks the ping-pong hand-off of adc_dma.c on the host, with dma.c and a
+ * register mock (ADC/tools/mock/sam.h). The test plays the DMAC: each ADC
+ * result is one beat into the active descriptor's destination, a finished
+ * block raises TCMPL through DMAC_Handler() and the DMAC follows DESCADDR,
+ * refetching the base descriptor after the channel is disabled. Interrupts
+ * are held while masked and taken at __enable_irq(), as on the core.
+ *
+ *   length   adc_dma_block_length() is the most whole frames that fit in
+ *            ADC_DMA_BLOCK_SIZE, and the descriptors count that many beats
+ *   stream   every block is handed over once, in order, from alternating
+ *            halves, starting on a frame, with no overruns
+ *   overrun  blocks left uncollected are counted and the newest is handed
+ *            over intact while the DMAC fills the other half
+ *   race     a block finishing inside adc_dma_get_block() is not lost
+ *   restart  stop keeps the ready block, init drops it and a restarted
+ *            ring begins at slot 0 of the first half
+ *   event    with the START event input enabled the ADC is not switched
+ *            to free-running mode
+ *
+ * The mock also checks the descriptors: valid, half word beats into an
+ * incrementing destination from ADC->RESULT, and a trigger of one beat per
+ * RESRDY. Exits non-zero if any check fails.
+ *
+ * The DMAC registers hold 32-bit addresses, so on a 64-bit host build it
+ * without PIE to keep the static buffers below 4 GB:
+ *
+ *     gcc -std=gnu99 -Wall -Wextra -Wno-pointer-to-int-cast -O2 -no-pie \
+ *         -IADC/tools/mock -IADC/ADC -o test_adc_dma \
+ *         ADC/tools/test_adc_dma.c ADC/ADC/adc_dma.c ADC/ADC/dma.c
+ *     ./test_adc_dma
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "adc_dma.h"
+#include "dma.h"
+
+// Blocks streamed per frame size, kept under 65536 samples so the sample
+// numbers in the results do not wrap
+#define TEST_BLOCKS        (500u)
+
+// Uncollected blocks in the overrun check
+#define TEST_BACKLOG       (4u)
+
+// Red, IR and dark, as the LED sequence interleaves them
+#define TEST_PHASES        (3u)
+
+Pm mock_pm;
+Adc mock_adc;
+
+static Dmac mock_dmac_regs;
+
+// Descriptor the DMAC is working through, as it would be in write-back
+static DmacDescriptor mock_active;
+static uint16_t mock_beats = 0;
+static bool mock_loaded = false;
+
+static bool mock_irq_masked = false;
+static bool mock_irq_pending = false;
+static bool mock_irq_enabled = false;
+
+// Run once on the next __disable_irq(), after masking
+static void (*mock_mask_hook)(void) = NULL;
+
+// First thing the mock DMAC found wrong, NULL if nothing
+static const char *mock_fault = NULL;
+
+// Next sample number fed to the ADC
+static uint16_t test_sample = 0;
+
+
+/*******************************************************************************
+ * Function:        Dmac *mock_dmac(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          The DMAC registers
+ *
+ * Side Effects:    Pending resets complete
+ *
+ * Overview:        Stands in for the DMAC base address. A reset is done by
+ *                  the next access, so polling SWRST terminates, and a
+ *                  disabled channel forgets its place in the ring.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+Dmac *mock_dmac(void)
+{
+	if (mock_dmac_regs.CTRL.bit.SWRST)
+	{
+		mock_dmac_regs.CTRL.reg = 0;
+		mock_dmac_regs.BASEADDR.reg = 0;
+		mock_dmac_regs.WRBADDR.reg = 0;
+		mock_dmac_regs.CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+	}
+	if (mock_dmac_regs.CHCTRLA.bit.SWRST)
+	{
+		mock_dmac_regs.CHCTRLA.reg = 0;
+		mock_dmac_regs.CHCTRLB.reg = 0;
+		mock_dmac_regs.CHINTENSET.reg = 0;
+		mock_dmac_regs.CHINTFLAG.reg = 0;
+	}
+	if (!mock_dmac_regs.CHCTRLA.bit.ENABLE)
+	{
+		mock_loaded = false;
+	}
+	return &mock_dmac_regs;
+} // mock_dmac()
+
+
+/*******************************************************************************
+ * Function:        static void mock_irq_deliver(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    May run DMAC_Handler()
+ *
+ * Overview:        Takes a pending DMAC interrupt unless it is masked.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void mock_irq_deliver(void)
+{
+	if (mock_irq_pending && mock_irq_enabled && !mock_irq_masked)
+	{
+		mock_irq_pending = false;
+		DMAC_Handler();
+		mock_dmac_regs.INTSTATUS.reg = 0;
+	}
+} // mock_irq_deliver()
+
+
+void __disable_irq(void)
+{
+	void (*hook)(void) = mock_mask_hook;
+
+	mock_irq_masked = true;
+	mock_mask_hook = NULL;
+	if (hook != NULL)
+	{
+		hook();
+	}
+}
+
+
+void __enable_irq(void)
+{
+	mock_irq_masked = false;
+	mock_irq_deliver();
+}
+
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+	if (irq == DMAC_IRQn)
+	{
+		mock_irq_enabled = true;
+	}
+}
+
+
+/*******************************************************************************
+ * Function:        static bool mock_check(const DmacDescriptor *desc)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Descriptor about to be used
+ *
+ * Output:          true if the DMAC can run it as adc_dma.c intends
+ *
+ * Side Effects:    mock_fault is set on the first problem
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool mock_check(const DmacDescriptor *desc)
+{
+	const char *fault = NULL;
+
+	if (!(desc->BTCTRL.reg & DMAC_BTCTRL_VALID))
+	{
+		fault = "descriptor not valid";
+	}
+	else if ((desc->BTCTRL.reg & DMAC_BTCTRL_BEATSIZE_Msk) != DMAC_BTCTRL_BEATSIZE_HWORD)
+	{
+		fault = "beats are not half words";
+	}
+	else if ((desc->BTCTRL.reg & (DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_DSTINC)) != DMAC_BTCTRL_DSTINC)
+	{
+		fault = "addresses do not increment as destination only";
+	}
+	else if (desc->SRCADDR.reg != (uint32_t)(uintptr_t)&mock_adc.RESULT.reg)
+	{
+		fault = "source is not ADC->RESULT";
+	}
+	else if ((desc->BTCNT.reg == 0u) || (desc->BTCNT.reg > ADC_DMA_BLOCK_SIZE))
+	{
+		fault = "block count out of range";
+	}
+	else if ((mock_dmac_regs.CHCTRLB.reg & DMAC_CHCTRLB_TRIGSRC_Msk) != DMAC_CHCTRLB_TRIGSRC(ADC_DMAC_ID_RESRDY) ||
+		(mock_dmac_regs.CHCTRLB.reg & DMAC_CHCTRLB_TRIGACT_Msk) != DMAC_CHCTRLB_TRIGACT_BEAT)
+	{
+		fault = "trigger is not one beat per RESRDY";
+	}
+
+	if ((fault != NULL) && (mock_fault == NULL))
+	{
+		mock_fault = fault;
+	}
+	return (fault == NULL);
+} // mock_check()
+
+
+/*******************************************************************************
+ * Function:        static void mock_convert(uint16_t result)
+ *
+ * PreCondition:    None
+ *
+ * Input:           ADC result
+ *
+ * Output:          None
+ *
+ * Side Effects:    May write the buffer and run DMAC_Handler()
+ *
+ * Overview:        One conversion. If the channel is enabled the DMAC moves
+ *                  the result as one beat, and at the end of a block flags
+ *                  TCMPL and moves on to the next descriptor.
+ *
+ * Note:            The base descriptor is fetched on the first beat after
+ *                  the channel was enabled, as the DMAC does.
+ *
+ ******************************************************************************/
+static void mock_convert(uint16_t result)
+{
+	mock_adc.RESULT.reg = result;
+
+	if (!mock_dmac_regs.CTRL.bit.DMAENABLE || !mock_dmac_regs.CHCTRLA.bit.ENABLE)
+	{
+		return;
+	}
+
+	if (!mock_loaded)
+	{
+		const DmacDescriptor *base = (const DmacDescriptor *)(uintptr_t)mock_dmac_regs.BASEADDR.reg;
+
+		mock_active = base[ADC_DMA_CHANNEL];
+		mock_beats = 0;
+		mock_loaded = true;
+	}
+	if (!mock_check(&mock_active))
+	{
+		return;
+	}
+
+	uint16_t *dst = (uint16_t *)(uintptr_t)mock_active.DSTADDR.reg - mock_active.BTCNT.reg;
+	dst[mock_beats] = *(volatile uint16_t *)(uintptr_t)mock_active.SRCADDR.reg;
+
+	if (++mock_beats < mock_active.BTCNT.reg)
+	{
+		return;
+	}
+
+	if (((mock_active.BTCTRL.reg & DMAC_BTCTRL_BLOCKACT_Msk) == DMAC_BTCTRL_BLOCKACT_INT) &&
+		(mock_dmac_regs.CHINTENSET.reg & DMAC_CHINTENSET_TCMPL))
+	{
+		mock_dmac_regs.CHINTFLAG.reg |= DMAC_CHINTFLAG_TCMPL;
+		mock_dmac_regs.INTSTATUS.reg |= 1u << ADC_DMA_CHANNEL;
+		mock_irq_pending = true;
+	}
+
+	if (mock_active.DESCADDR.reg == 0u)
+	{
+		mock_dmac_regs.CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+		mock_loaded = false;
+	}
+	else
+	{
+		mock_active = *(const DmacDescriptor *)(uintptr_t)mock_active.DESCADDR.reg;
+		mock_beats = 0;
+	}
+	mock_irq_deliver();
+} // mock_convert()
+
+
+/*******************************************************************************
+ * Function:        static void test_feed(uint32_t count)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Number of conversions
+ *
+ * Output:          None
+ *
+ * Side Effects:    test_sample moves on
+ *
+ * Overview:        Converts consecutive sample numbers, so a block shows
+ *                  where in the stream it came from.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_feed(uint32_t count)
+{
+	while (count-- > 0u)
+	{
+		mock_convert(test_sample++);
+	}
+} // test_feed()
+
+
+/*******************************************************************************
+ * Function:        static void test_feed_one(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Mask hook, the conversion that finishes a block.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_feed_one(void)
+{
+	test_feed(1u);
+} // test_feed_one()
+
+
+/*******************************************************************************
+ * Function:        static bool test_block(const char *name,
+ *                                         const uint16_t *block,
+ *                                         uint16_t first)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Check name, block and the sample number it should start at
+ *
+ * Output:          true if the block holds the expected samples
+ *
+ * Side Effects:    None
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_block(const char *name, const uint16_t *block, uint16_t first)
+{
+	if (block == NULL)
+	{
+		printf("%s: no block, expected one from sample %u\n", name, first);
+		return false;
+	}
+	for (uint16_t i = 0; i < adc_dma_block_length(); i++)
+	{
+		if (block[i] != (uint16_t)(first + i))
+		{
+			printf("%s: sample %u is %u, expected %u\n", name, i, block[i], (uint16_t)(first + i));
+			return false;
+		}
+	}
+	return true;
+} // test_block()
+
+
+/*******************************************************************************
+ * Function:        static void test_begin(uint8_t frame_size)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Samples per frame
+ *
+ * Output:          None
+ *
+ * Side Effects:    The stream restarts from sample 0
+ *
+ * Overview:        adc_dma_init() and adc_dma_start() as probe.c runs them.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_begin(uint8_t frame_size)
+{
+	adc_dma_init(frame_size);
+	adc_dma_start();
+	test_sample = 0;
+} // test_begin()
+
+
+/*******************************************************************************
+ * Function:        static bool test_length(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          true if every frame size gives the right length
+ *
+ * Side Effects:    The ADC DMA is restarted
+ *
+ * Overview:        Frame sizes 1-8.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_length(void)
+{
+	bool ok = true;
+
+	for (uint8_t frame = 1; frame <= 8u; frame++)
+	{
+		uint16_t length = (ADC_DMA_BLOCK_SIZE / frame) * frame;
+
+		adc_dma_init(frame);
+		if ((adc_dma_block_length() != length) || (dma_descriptor(ADC_DMA_CHANNEL)->BTCNT.reg != length))
+		{
+			printf("length: frame %u gives %u samples and %u beats, expected %u\n", frame,
+				adc_dma_block_length(), dma_descriptor(ADC_DMA_CHANNEL)->BTCNT.reg, length);
+			ok = false;
+		}
+	}
+	return ok;
+} // test_length()
+
+
+/*******************************************************************************
+ * Function:        static bool test_stream(uint8_t frame_size)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Samples per frame
+ *
+ * Output:          true if every block is handed over as it should be
+ *
+ * Side Effects:    The ADC DMA is restarted
+ *
+ * Overview:        TEST_BLOCKS blocks, each collected as soon as it is full.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_stream(uint8_t frame_size)
+{
+	const uint16_t *half[2] = { NULL, NULL };
+
+	test_begin(frame_size);
+	if (!mock_adc.CTRLB.bit.FREERUN || !(mock_adc.SWTRIG.reg & ADC_SWTRIG_START))
+	{
+		printf("stream: ADC not started in free-running mode\n");
+		return false;
+	}
+
+	uint16_t length = adc_dma_block_length();
+
+	for (uint32_t k = 0; k < TEST_BLOCKS; k++)
+	{
+		test_feed(length - 1u);
+		if (adc_dma_get_block() != NULL)
+		{
+			printf("stream: block %u handed over early\n", (unsigned)k);
+			return false;
+		}
+		test_feed(1u);
+
+		const uint16_t *block = adc_dma_get_block();
+
+		if (!test_block("stream", block, (uint16_t)(k * length)))
+		{
+			return false;
+		}
+		if (k < 2u)
+		{
+			half[k] = block;
+		}
+		if ((half[0] == half[1]) || (block != half[k & 1u]))
+		{
+			printf("stream: block %u not from the other half\n", (unsigned)k);
+			return false;
+		}
+		if ((block[0] % frame_size) != 0u)
+		{
+			printf("stream: block %u starts at slot %u\n", (unsigned)k, block[0] % frame_size);
+			return false;
+		}
+		if (adc_dma_get_block() != NULL)
+		{
+			printf("stream: block %u handed over twice\n", (unsigned)k);
+			return false;
+		}
+	}
+	if (adc_dma_overruns() != 0u)
+	{
+		printf("stream: %u overruns counted\n", (unsigned)adc_dma_overruns());
+		return false;
+	}
+	return true;
+} // test_stream()
+
+
+/*******************************************************************************
+ * Function:        static bool test_overrun(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          true if the overruns are counted and the newest block is intact
+ *
+ * Side Effects:    The ADC DMA is restarted
+ *
+ * Overview:        The main loop misses TEST_BACKLOG blocks and collects the last
+ *                  one half a block late.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_overrun(void)
+{
+	test_begin(TEST_PHASES);
+
+	uint16_t length = adc_dma_block_length();
+
+	test_feed(length);
+	if (!test_block("overrun", adc_dma_get_block(), 0))
+	{
+		return false;
+	}
+
+	test_feed(TEST_BACKLOG * length);
+	if (adc_dma_overruns() != (TEST_BACKLOG - 1u))
+	{
+		printf("overrun: %u counted, expected %u\n", (unsigned)adc_dma_overruns(), TEST_BACKLOG - 1u);
+		return false;
+	}
+
+	// The DMAC is half way through the other half when the loop gets here
+	test_feed(length / 2u);
+
+	const uint16_t *block = adc_dma_get_block();
+
+	if (!test_block("overrun", block, (uint16_t)(TEST_BACKLOG * length)) || (adc_dma_get_block() != NULL))
+	{
+		return false;
+	}
+
+	test_feed(length - (length / 2u));
+	if (!test_block("overrun", adc_dma_get_block(), (uint16_t)((TEST_BACKLOG + 1u) * length)) ||
+		(adc_dma_overruns() != (TEST_BACKLOG - 1u)))
+	{
+		printf("overrun: lost the block after the overruns\n");
+		return false;
+	}
+	return true;
+} // test_overrun()
+
+
+/*******************************************************************************
+ * Function:        static bool test_race(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          true if both blocks are handed over
+ *
+ * Side Effects:    The ADC DMA is restarted
+ *
+ * Overview:        The next block finishes after adc_dma_get_block() has masked
+ *                  interrupts, so DMAC_Handler() runs when it unmasks them.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_race(void)
+{
+	test_begin(TEST_PHASES);
+
+	uint16_t length = adc_dma_block_length();
+
+	test_feed((2u * length) - 1u);
+	mock_mask_hook = test_feed_one;
+	if (!test_block("race", adc_dma_get_block(), 0) ||
+		!test_block("race", adc_dma_get_block(), length))
+	{
+		return false;
+	}
+	if (adc_dma_overruns() != 0u)
+	{
+		printf("race: %u overruns counted\n", (unsigned)adc_dma_overruns());
+		return false;
+	}
+	return true;
+} // test_race()
+
+
+/*******************************************************************************
+ * Function:        static bool test_restart(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          true if stop, init and start behave as probe.c relies on
+ *
+ * Side Effects:    The ADC DMA is restarted
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_restart(void)
+{
+	test_begin(TEST_PHASES);
+
+	uint16_t length = adc_dma_block_length();
+
+	test_feed(length + (length / 2u));
+	adc_dma_stop();
+	if (mock_adc.CTRLB.bit.FREERUN || mock_dmac_regs.CHCTRLA.bit.ENABLE)
+	{
+		printf("restart: ADC or DMAC left running\n");
+		return false;
+	}
+
+	// Nothing moves while stopped, and the ready block stays
+	test_feed(length);
+	if (!test_block("restart", adc_dma_get_block(), 0))
+	{
+		return false;
+	}
+
+	// A ring stopped part way with a block waiting
+	test_begin(TEST_PHASES);
+	test_feed(length + 40u);
+	adc_dma_stop();
+	adc_dma_init(TEST_PHASES);
+	if (adc_dma_get_block() != NULL)
+	{
+		printf("restart: block from before init handed over\n");
+		return false;
+	}
+
+	adc_dma_start();
+	test_sample = 0;
+	test_feed(length);
+
+	const uint16_t *block = adc_dma_get_block();
+
+	if (!test_block("restart", block, 0))
+	{
+		return false;
+	}
+	test_feed(length);
+	if (adc_dma_get_block() <= block)
+	{
+		printf("restart: ring did not restart in the first half\n");
+		return false;
+	}
+	return (adc_dma_overruns() == 0u);
+} // test_restart()
+
+
+/*******************************************************************************
+ * Function:        static bool test_event(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          true if the ADC is left waiting for start events
+ *
+ * Side Effects:    The ADC DMA is restarted
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_event(void)
+{
+	bool ok;
+
+	adc_dma_stop();
+	mock_adc.EVCTRL.bit.STARTEI = 1;
+	mock_adc.SWTRIG.reg = 0;
+	test_begin(TEST_PHASES);
+
+	ok = !mock_adc.CTRLB.bit.FREERUN && (mock_adc.SWTRIG.reg == 0u) && mock_dmac_regs.CHCTRLA.bit.ENABLE;
+	if (!ok)
+	{
+		printf("event: ADC switched to free-running mode\n");
+	}
+
+	test_feed(adc_dma_block_length());
+	ok = test_block("event", adc_dma_get_block(), 0) && ok;
+
+	adc_dma_stop();
+	mock_adc.EVCTRL.bit.STARTEI = 0;
+	return ok;
+} // test_event()
+
+
+int main(void)
+{
+	static const uint8_t frames[] = { 1u, 3u, 5u, 7u };
+	int failed = 0;
+
+	if (((uintptr_t)&mock_adc > UINT32_MAX) || ((uintptr_t)dma_descriptor(ADC_DMA_CHANNEL) > UINT32_MAX))
+	{
+		printf("statics above 4 GB, build with -no-pie\n");
+		return 2;
+	}
+
+	failed |= !test_length();
+	for (uint8_t i = 0; i < sizeof(frames); i++)
+	{
+		failed |= !test_stream(frames[i]);
+	}
+	failed |= !test_overrun();
+	failed |= !test_race();
+	failed |= !test_restart();
+	failed |= !test_event();
+
+	if (mock_fault != NULL)
+	{
+		printf("DMAC: %s\n", mock_fault);
+		failed = 1;
+	}
+
+	printf("%s\n", failed ? "FAILED" : "all checks passed");
+	return failed;
+}
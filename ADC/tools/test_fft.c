@@ -0,0 +1,216 @@
+/*
+ * Checks fft_q15() (ADC/fft.c) on the host against a double precision DFT of
+ * the same Q15 input, scaled by 1/n as fft_q15() scales, for every size from
+ * FFT_SIZE_MIN to FFT_SIZE_MAX and a few kinds of input:
+ *
+ *   noise    full scale uniform noise in re and im
+ *   real     full scale uniform noise in re only, as resp.c feeds it
+ *   tone     a complex tone between two bins at half scale
+ *   impulse  a full scale impulse, every bin equal
+ *
+ * Prints the SNR of each and exits non-zero if any is under TEST_SNR_MIN_DB
+ * or a size outside the supported range is accepted. fft_q15() is plain C
+ * with no target intrinsics, so the target computes the same bits.
+ *
+ * Only the C library is used, so it builds wherever gcc does:
+ *
+ *     gcc -std=gnu99 -Wall -Wextra -O2 -IADC/ADC -o test_fft \
+ *         ADC/tools/test_fft.c ADC/ADC/fft.c ADC/ADC/fft_tables.c \
+ *         ADC/ADC/fixmath.c -lm
+ *     ./test_fft
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "fft.h"
+
+#define TEST_SEED          (12345u)
+#define TEST_SNR_MIN_DB    (50.0)
+
+typedef enum
+{
+	TEST_NOISE = 0,
+	TEST_REAL,
+	TEST_TONE,
+	TEST_IMPULSE,
+	TEST_KINDS
+} test_kind_t;
+
+static const char *const test_names[TEST_KINDS] = { "noise", "real", "tone", "impulse" };
+
+static int16_t test_data[2u * FFT_SIZE_MAX];
+static int16_t test_input[2u * FFT_SIZE_MAX];
+
+
+/*******************************************************************************
+ * Function:        static int16_t test_random(uint32_t *seed)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Generator state
+ *
+ * Output:          Uniform Q15 value
+ *
+ * Side Effects:    None
+ *
+ * Overview:        xorshift32, so runs repeat on every host.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int16_t test_random(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return (int16_t)(*seed >> 16);
+} // test_random()
+
+
+/*******************************************************************************
+ * Function:        static void test_fill(test_kind_t kind, uint16_t n, uint32_t *seed)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Kind of input, size and generator state
+ *
+ * Output:          None
+ *
+ * Side Effects:    test_input and test_data hold the input
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_fill(test_kind_t kind, uint16_t n, uint32_t *seed)
+{
+	for (uint16_t i = 0; i < n; i++)
+	{
+		int16_t re = 0, im = 0;
+
+		switch (kind)
+		{
+			case TEST_NOISE:
+				re = test_random(seed);
+				im = test_random(seed);
+				break;
+
+			case TEST_REAL:
+				re = test_random(seed);
+				break;
+
+			case TEST_TONE:
+			{
+				double phase = 2.0 * M_PI * (n / 8.0 + 0.37) * i / n;
+
+				re = (int16_t)lround(16384.0 * cos(phase));
+				im = (int16_t)lround(16384.0 * sin(phase));
+				break;
+			}
+
+			default:
+				re = (i == 0u) ? 32767 : 0;
+				break;
+		}
+		test_input[2u * i] = re;
+		test_input[(2u * i) + 1u] = im;
+	}
+	for (uint32_t i = 0; i < (2u * n); i++)
+	{
+		test_data[i] = test_input[i];
+	}
+} // test_fill()
+
+
+/*******************************************************************************
+ * Function:        static double test_snr(uint16_t n)
+ *
+ * PreCondition:    test_fill() and fft_q15() have run
+ *
+ * Input:           Size
+ *
+ * Output:          SNR in dB of test_data against the reference
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Direct DFT of test_input in double precision, scaled by
+ *                  1/n. The error is everything fft_q15() adds: twiddle
+ *                  rounding and the rounding of each stage's scaling.
+ *
+ * Note:            O(n^2), well under a second for all sizes and kinds
+ *
+ ******************************************************************************/
+static double test_snr(uint16_t n)
+{
+	double signal = 0.0, noise = 0.0;
+
+	for (uint16_t k = 0; k < n; k++)
+	{
+		double re = 0.0, im = 0.0;
+
+		for (uint16_t i = 0; i < n; i++)
+		{
+			double phase = -2.0 * M_PI * (double)(((uint32_t)i * k) % n) / n;
+			double c = cos(phase), s = sin(phase);
+
+			re += (test_input[2u * i] * c) - (test_input[(2u * i) + 1u] * s);
+			im += (test_input[2u * i] * s) + (test_input[(2u * i) + 1u] * c);
+		}
+		re /= n;
+		im /= n;
+
+		double err_re = test_data[2u * k] - re;
+		double err_im = test_data[(2u * k) + 1u] - im;
+
+		signal += (re * re) + (im * im);
+		noise += (err_re * err_re) + (err_im * err_im);
+	}
+	return (noise > 0.0) ? (10.0 * log10(signal / noise)) : INFINITY;
+} // test_snr()
+
+
+int main(void)
+{
+	uint32_t seed = TEST_SEED;
+	int failed = 0;
+
+	if (fft_q15(test_data, FFT_SIZE_MIN / 2u) || fft_q15(test_data, 2u * FFT_SIZE_MAX) ||
+		fft_q15(test_data, FFT_SIZE_MIN + 1u))
+	{
+		printf("unsupported size accepted\n");
+		failed = 1;
+	}
+
+	printf("   n");
+	for (uint8_t kind = 0; kind < TEST_KINDS; kind++)
+	{
+		printf("  %8s", test_names[kind]);
+	}
+	printf("   (SNR dB against a double precision DFT)\n");
+
+	for (uint16_t n = FFT_SIZE_MIN; n <= FFT_SIZE_MAX; n *= 2u)
+	{
+		printf("%4u", n);
+		for (uint8_t kind = 0; kind < TEST_KINDS; kind++)
+		{
+			test_fill((test_kind_t)kind, n, &seed);
+			if (!fft_q15(test_data, n))
+			{
+				printf("  rejected");
+				failed = 1;
+				continue;
+			}
+
+			double snr = test_snr(n);
+			printf("  %8.1f", snr);
+			if (snr < TEST_SNR_MIN_DB)
+			{
+				failed = 1;
+			}
+		}
+		printf("\n");
+	}
+	return failed;
+}
@@ -0,0 +1,478 @@
+/*
+ * Checks filter_bandpass() and filter_fir() (ADC/filter.c) on the host:
+ *
+ *   bit-exact  against a plain reference in 64-bit integers, with no wrapping
+ *              sums, sample for sample on noise, steps and full scale input
+ *   SNR        against the same coefficients run in double precision, so the
+ *              error is only the rounding of the fixed point arithmetic
+ *   response   gain at tones through the pass band and both edges against
+ *              the design: Butterworth edges through the bilinear transform,
+ *              and the unquantised Hamming windowed-sinc
+ *
+ * The design is the one filter_coeffs.h was generated with, see the
+ * gen_filter.py command at its top. Exits non-zero on any mismatch, an SNR
+ * under TEST_SNR_MIN_DB or a gain off the design by more than TEST_GAIN_DB.
+ * filter.c is plain C with no target intrinsics, so the target computes the
+ * same bits.
+ *
+ * Only the C library is used, so it builds wherever gcc does:
+ *
+ *     gcc -std=gnu99 -Wall -Wextra -O2 -IADC/ADC -o test_filter \
+ *         ADC/tools/test_filter.c ADC/ADC/filter.c ADC/ADC/filter_coeffs.c \
+ *         ADC/ADC/fixmath.c -lm
+ *     ./test_filter
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "filter.h"
+
+// Design, as given to gen_filter.py
+#define TEST_LOW_HZ        (0.5)
+#define TEST_HIGH_HZ       (5.0)
+#define TEST_ORDER         (4)
+#define TEST_FIR_HIGH_HZ   (10.0)
+
+#define TEST_SEED          (13579u)
+#define TEST_SAMPLES       (200000u)
+#define TEST_SNR_MIN_DB    (55.0)
+#define TEST_GAIN_DB       (0.1)
+#define TEST_AMPLITUDE     (8192.0)        // tone amplitude, a quarter of full scale
+#define TEST_TONE_S        (60u)           // each tone, the first half settles
+
+static const double test_tones_hz[] = { 0.3, 0.5, 0.8, 1.0, 1.5, 2.0, 3.0, 4.0, 5.0, 7.0, 10.0, 15.0 };
+
+// Reference section state, wide enough that nothing wraps
+typedef struct
+{
+	int64_t x1, x2, y1, y2;
+	int64_t err;
+} test_biquad_t;
+
+// Double precision section state
+typedef struct
+{
+	double x1, x2, y1, y2;
+} test_biquad_double_t;
+
+
+/*******************************************************************************
+ * Function:        static int16_t test_random(uint32_t *seed)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Generator state
+ *
+ * Output:          Uniform Q15 value
+ *
+ * Side Effects:    None
+ *
+ * Overview:        xorshift32, so runs repeat on every host.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int16_t test_random(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return (int16_t)(*seed >> 16);
+} // test_random()
+
+
+/*******************************************************************************
+ * Function:        static int16_t test_input(uint32_t n, uint32_t *seed)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Sample number and generator state
+ *
+ * Output:          Input sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Quarter scale noise on a baseline that steps every
+ *                  10000 samples, with a run of full scale steps and full
+ *                  scale noise, which saturate the band-pass.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int16_t test_input(uint32_t n, uint32_t *seed)
+{
+	int16_t noise = test_random(seed);
+	uint32_t part = n / 10000u;
+
+	if (part == 7u)
+	{
+		return ((n / 200u) & 1u) ? 32767 : -32768;
+	}
+	if (part == 8u)
+	{
+		return noise;
+	}
+	return (int16_t)(((part & 1u) ? 8000 : -8000) + (noise / 4));
+} // test_input()
+
+
+/*******************************************************************************
+ * Function:        static int16_t test_sat16(int64_t x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Value
+ *
+ * Output:          Value clamped to the int16_t range
+ *
+ * Side Effects:    None
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int16_t test_sat16(int64_t x)
+{
+	return (int16_t)((x > 32767) ? 32767 : ((x < -32768) ? -32768 : x));
+} // test_sat16()
+
+
+/*******************************************************************************
+ * Function:        static int16_t test_biquad(const int16_t *coeffs,
+ *                                             test_biquad_t *section, int16_t x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Q14 coefficients, section state and one input sample
+ *
+ * Output:          Filtered sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The section as written down: the exact sum plus the
+ *                  fraction carried from the last sample, floored to Q0 and
+ *                  saturated, with the new fraction carried on.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int16_t test_biquad(const int16_t *coeffs, test_biquad_t *section, int16_t x)
+{
+	int64_t sum = section->err + (coeffs[0] * (int64_t)x) + (coeffs[1] * section->x1) +
+		(coeffs[2] * section->x2) - (coeffs[3] * section->y1) - (coeffs[4] * section->y2);
+	int64_t floor = sum >> FILTER_BIQUAD_SHIFT;
+	int16_t y = test_sat16(floor);
+
+	section->err = sum - (floor << FILTER_BIQUAD_SHIFT);
+	section->x2 = section->x1;
+	section->x1 = x;
+	section->y2 = section->y1;
+	section->y1 = y;
+	return y;
+} // test_biquad()
+
+
+/*******************************************************************************
+ * Function:        static double test_biquad_double(const int16_t *coeffs,
+ *                                                   test_biquad_double_t *section,
+ *                                                   double x)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Q14 coefficients, section state and one input sample
+ *
+ * Output:          Filtered sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The same section in double precision.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static double test_biquad_double(const int16_t *coeffs, test_biquad_double_t *section, double x)
+{
+	const double scale = 1.0 / (1u << FILTER_BIQUAD_SHIFT);
+	double y = scale * ((coeffs[0] * x) + (coeffs[1] * section->x1) + (coeffs[2] * section->x2) -
+		(coeffs[3] * section->y1) - (coeffs[4] * section->y2));
+
+	section->x2 = section->x1;
+	section->x1 = x;
+	section->y2 = section->y1;
+	section->y1 = y;
+	return y;
+} // test_biquad_double()
+
+
+/*******************************************************************************
+ * Function:        static int16_t test_fir(const int16_t *line, uint32_t n)
+ *
+ * PreCondition:    line holds the inputs up to n
+ *
+ * Input:           Input history and sample number
+ *
+ * Output:          Filtered sample
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Direct convolution, every tap multiplied on its own,
+ *                  rounded half up and saturated.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int16_t test_fir(const int16_t *line, uint32_t n)
+{
+	int64_t sum = 1l << (FILTER_FIR_SHIFT - 1u);
+
+	for (uint32_t k = 0; k < FILTER_FIR_TAPS; k++)
+	{
+		sum += (int64_t)filter_fir_coeffs[k] * ((n >= k) ? line[n - k] : 0);
+	}
+	return test_sat16(sum >> FILTER_FIR_SHIFT);
+} // test_fir()
+
+
+/*******************************************************************************
+ * Function:        static int test_exact(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          Non-zero on a mismatch
+ *
+ * Side Effects:    None
+ *
+ * Overview:        TEST_SAMPLES of test_input() through filter.c and the
+ *                  references, compared sample for sample.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int test_exact(void)
+{
+	static int16_t line[TEST_SAMPLES];
+	filter_bandpass_t bandpass;
+	filter_fir_t fir;
+	test_biquad_t ref[FILTER_BIQUAD_SECTIONS] = { { 0 } };
+	uint32_t seed = TEST_SEED;
+	uint32_t bandpass_bad = 0, fir_bad = 0;
+
+	filter_bandpass_init(&bandpass);
+	filter_fir_init(&fir);
+	for (uint32_t n = 0; n < TEST_SAMPLES; n++)
+	{
+		int16_t x = test_input(n, &seed);
+		int16_t y = x;
+
+		for (uint8_t s = 0; s < FILTER_BIQUAD_SECTIONS; s++)
+		{
+			y = test_biquad(filter_bandpass_coeffs[s], &ref[s], y);
+		}
+		bandpass_bad += (filter_bandpass(&bandpass, x) != y);
+
+		line[n] = x;
+		fir_bad += (filter_fir(&fir, x) != test_fir(line, n));
+	}
+
+	printf("bit-exact over %u samples: band-pass %u, FIR %u mismatches\n",
+		(unsigned)TEST_SAMPLES, (unsigned)bandpass_bad, (unsigned)fir_bad);
+	return (bandpass_bad != 0u) || (fir_bad != 0u);
+} // test_exact()
+
+
+/*******************************************************************************
+ * Function:        static int test_snr(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          Non-zero if an SNR is under TEST_SNR_MIN_DB
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Quarter scale noise through filter.c and through the same
+ *                  coefficients in double precision.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int test_snr(void)
+{
+	static int16_t line[TEST_SAMPLES];
+	filter_bandpass_t bandpass;
+	filter_fir_t fir;
+	test_biquad_double_t ref[FILTER_BIQUAD_SECTIONS] = { { 0 } };
+	uint32_t seed = TEST_SEED;
+	double bandpass_signal = 0.0, bandpass_noise = 0.0;
+	double fir_signal = 0.0, fir_noise = 0.0;
+
+	filter_bandpass_init(&bandpass);
+	filter_fir_init(&fir);
+	for (uint32_t n = 0; n < TEST_SAMPLES; n++)
+	{
+		int16_t x = (int16_t)(test_random(&seed) / 4);
+		double y = x;
+
+		for (uint8_t s = 0; s < FILTER_BIQUAD_SECTIONS; s++)
+		{
+			y = test_biquad_double(filter_bandpass_coeffs[s], &ref[s], y);
+		}
+		double e = filter_bandpass(&bandpass, x) - y;
+		bandpass_signal += y * y;
+		bandpass_noise += e * e;
+
+		line[n] = x;
+		double f = 0.0;
+		for (uint32_t k = 0; (k < FILTER_FIR_TAPS) && (k <= n); k++)
+		{
+			f += filter_fir_coeffs[k] * (double)line[n - k];
+		}
+		f /= (1u << FILTER_FIR_SHIFT);
+		e = filter_fir(&fir, x) - f;
+		fir_signal += f * f;
+		fir_noise += e * e;
+	}
+
+	double bandpass_snr = 10.0 * log10(bandpass_signal / bandpass_noise);
+	double fir_snr = 10.0 * log10(fir_signal / fir_noise);
+
+	printf("SNR against double precision: band-pass %.1f dB, FIR %.1f dB\n", bandpass_snr, fir_snr);
+	return (bandpass_snr < TEST_SNR_MIN_DB) || (fir_snr < TEST_SNR_MIN_DB);
+} // test_snr()
+
+
+/*******************************************************************************
+ * Function:        static double test_design_db(double hz, bool fir)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Frequency and which filter
+ *
+ * Output:          Design gain in dB
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Butterworth edges through the bilinear transform, whose
+ *                  analogue frequency is tan(pi f / fs), or the DTFT of the
+ *                  unquantised Hamming windowed-sinc, as gen_filter.py
+ *                  designs them.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static double test_design_db(double hz, bool fir)
+{
+	const double fs = FILTER_SAMPLE_RATE_HZ;
+
+	if (!fir)
+	{
+		double w = tan(M_PI * hz / fs);
+		double high = pow(tan(M_PI * TEST_LOW_HZ / fs) / w, 2.0 * TEST_ORDER);
+		double low = pow(w / tan(M_PI * TEST_HIGH_HZ / fs), 2.0 * TEST_ORDER);
+
+		return -10.0 * log10((1.0 + high) * (1.0 + low));
+	}
+
+	int mid = (FILTER_FIR_TAPS - 1) / 2;
+	double total = 0.0, re = 0.0, im = 0.0;
+
+	for (int n = 0; n < (int)FILTER_FIR_TAPS; n++)
+	{
+		int m = n - mid;
+		double x = 2.0 * TEST_FIR_HIGH_HZ / fs;
+		double sinc = (m == 0) ? x : (sin(M_PI * x * m) / (M_PI * m));
+		double h = sinc * (0.54 - 0.46 * cos(2.0 * M_PI * n / (FILTER_FIR_TAPS - 1)));
+
+		total += h;
+		re += h * cos(2.0 * M_PI * hz * m / fs);
+		im -= h * sin(2.0 * M_PI * hz * m / fs);
+	}
+	return 20.0 * log10(sqrt((re * re) + (im * im)) / fabs(total));
+} // test_design_db()
+
+
+/*******************************************************************************
+ * Function:        static int test_response(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          Non-zero if a gain is off the design by more than
+ *                  TEST_GAIN_DB
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Each tone runs TEST_TONE_S, and the output of the second
+ *                  half is correlated with a sine and cosine of the tone.
+ *                  Tones the design takes under -40 dB are only printed, the
+ *                  rounding noise is a large part of what is left.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int test_response(void)
+{
+	const uint32_t samples = TEST_TONE_S * FILTER_SAMPLE_RATE_HZ;
+	int failed = 0;
+
+	printf("    Hz  band-pass dB  design   FIR dB  design\n");
+	for (uint8_t t = 0; t < (sizeof(test_tones_hz) / sizeof(test_tones_hz[0])); t++)
+	{
+		double hz = test_tones_hz[t];
+		filter_bandpass_t bandpass;
+		filter_fir_t fir;
+		double b_re = 0.0, b_im = 0.0, f_re = 0.0, f_im = 0.0;
+
+		filter_bandpass_init(&bandpass);
+		filter_fir_init(&fir);
+		for (uint32_t n = 0; n < samples; n++)
+		{
+			double phase = 2.0 * M_PI * hz * n / FILTER_SAMPLE_RATE_HZ;
+			int16_t x = (int16_t)lround(TEST_AMPLITUDE * sin(phase));
+			int16_t b = filter_bandpass(&bandpass, x);
+			int16_t f = filter_fir(&fir, x);
+
+			if (n >= (samples / 2u))
+			{
+				b_re += b * sin(phase);
+				b_im += b * cos(phase);
+				f_re += f * sin(phase);
+				f_im += f * cos(phase);
+			}
+		}
+
+		// Correlation over the half, 2/N of it is the amplitude
+		double scale = 4.0 / (samples * TEST_AMPLITUDE);
+		double b_db = 20.0 * log10(scale * sqrt((b_re * b_re) + (b_im * b_im)));
+		double f_db = 20.0 * log10(scale * sqrt((f_re * f_re) + (f_im * f_im)));
+		double b_design = test_design_db(hz, false);
+		double f_design = test_design_db(hz, true);
+		bool b_bad = (b_design > -40.0) && (fabs(b_db - b_design) > TEST_GAIN_DB);
+		bool f_bad = (f_design > -40.0) && (fabs(f_db - f_design) > TEST_GAIN_DB);
+
+		printf("%6.1f  %10.2f%s %7.2f  %7.2f%s %7.2f\n", hz, b_db, b_bad ? "!" : " ", b_design,
+			f_db, f_bad ? "!" : " ", f_design);
+		failed |= b_bad || f_bad;
+	}
+	return failed;
+} // test_response()
+
+
+int main(void)
+{
+	int failed = 0;
+
+	printf("fs %u Hz, band-pass %g-%g Hz order %d, FIR %u taps to %g Hz\n", (unsigned)FILTER_SAMPLE_RATE_HZ,
+		TEST_LOW_HZ, TEST_HIGH_HZ, TEST_ORDER, (unsigned)FILTER_FIR_TAPS, TEST_FIR_HIGH_HZ);
+	failed |= test_exact();
+	failed |= test_snr();
+	failed |= test_response();
+	return failed;
+}
@@ -0,0 +1,100 @@
+/*
+ * Checks fixmath_exp2_q16() (ADC/fixmath.c) on the host against pow(2, x)
+ * for every Q16 exponent from TEST_X_MIN to TEST_X_MAX, against the bounds
+ * fixmath.h states:
+ *
+ *   x >= -3   relative error within TEST_REL_MAX
+ *   x <  -3   within TEST_LSB_MAX of Q16
+ *   x >= 16   UINT32_MAX
+ *
+ * Prints the worst error on each unit interval of x and exits non-zero if
+ * a bound is broken. fixmath.c is plain C with no target intrinsics, so the
+ * target computes the same bits.
+ *
+ * Only the C library is used, so it builds wherever gcc does:
+ *
+ *     gcc -std=gnu99 -Wall -Wextra -O2 -IADC/ADC -o test_fixmath \
+ *         ADC/tools/test_fixmath.c ADC/ADC/fixmath.c -lm
+ *     ./test_fixmath
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "fixmath.h"
+
+// Whole part of the exponents swept, every Q16 step in between
+#define TEST_X_MIN         (-20)
+#define TEST_X_MAX         (17)
+
+// Where the relative bound gives way to the absolute one
+#define TEST_X_SPLIT       (-3)
+
+#define TEST_REL_MAX       (1.2e-4)
+#define TEST_LSB_MAX       (1.0)
+
+
+int main(void)
+{
+	int failed = 0;
+
+	printf("       x      max LSB   max relative\n");
+
+	for (int32_t whole = TEST_X_MIN; whole < TEST_X_MAX; whole++)
+	{
+		double worst_lsb = 0.0, worst_rel = 0.0;
+		int32_t worst_x = 0;
+		uint32_t broken = 0;
+
+		for (int32_t frac = 0; frac < FIXMATH_Q16_ONE; frac++)
+		{
+			int32_t x = (whole * FIXMATH_Q16_ONE) + frac;
+			double exact = ldexp(pow(2.0, frac / 65536.0), whole + 16);
+			uint32_t result = fixmath_exp2_q16(x);
+
+			if (whole >= 16)
+			{
+				broken += (result != UINT32_MAX);
+				continue;
+			}
+
+			double lsb = fabs((double)result - exact);
+			double rel = lsb / exact;
+
+			if (lsb > worst_lsb)
+			{
+				worst_lsb = lsb;
+				worst_x = x;
+			}
+			if (rel > worst_rel)
+			{
+				worst_rel = rel;
+			}
+			if (whole >= TEST_X_SPLIT)
+			{
+				broken += (rel > TEST_REL_MAX);
+			}
+			else
+			{
+				broken += (lsb > TEST_LSB_MAX);
+			}
+		}
+
+		if (whole >= 16)
+		{
+			printf("[%3d,%3d)  saturates%s\n", (int)whole, (int)(whole + 1), broken ? ", FAILED" : "");
+		}
+		else
+		{
+			printf("[%3d,%3d)  %11.4f   %.4e%s\n", (int)whole, (int)(whole + 1), worst_lsb, worst_rel,
+				broken ? "  FAILED" : "");
+		}
+		if (broken != 0u)
+		{
+			printf("  %u inputs out of bounds, worst at x = %.6f\n", (unsigned)broken,
+				worst_x / 65536.0);
+			failed = 1;
+		}
+	}
+	return failed;
+}
@@ -0,0 +1,335 @@
+/*
+ * Checks the pulse shape features of morph.c (ADC/morph.c) on the host
+ * against the true features of a synthetic PPG, fed through the same chain
+ * as app.c: DC tracker, band-pass and beat detector for the beat events, a
+ * slower DC tracker and the smoothing FIR for the shape.
+ *
+ * Each beat is a systolic and a reflected diastolic Gaussian wave on a
+ * slowly breathing baseline with a little noise. The truth is measured on
+ * the noise free waveform at 1 ms steps with the definitions morph.c uses:
+ *
+ *   foot    the lowest point before the upstroke, in time where the tangent
+ *           at the steepest point meets its level
+ *   rise    tangent foot to systolic peak
+ *   width   width at half the foot to peak amplitude
+ *   RI      diastolic peak over the foot, % of the amplitude
+ *
+ * Prints the truth and the mean and worst error of each heart rate, and
+ * exits non-zero if any error is over its limit, a beat is missed or
+ * doubled, or a notch clearly deeper than MORPH_NOTCH_SHIFT allows is not
+ * found.
+ *
+ * Only the C library is used, so it builds wherever gcc does:
+ *
+ *     gcc -std=gnu99 -Wall -Wextra -O2 -IADC/ADC -o test_morph \
+ *         ADC/tools/test_morph.c ADC/ADC/morph.c ADC/ADC/beat.c \
+ *         ADC/ADC/filter.c ADC/ADC/filter_coeffs.c ADC/ADC/dc_track.c \
+ *         ADC/ADC/fixmath.c -lm
+ *     ./test_morph
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "beat.h"
+#include "dc_track.h"
+#include "filter.h"
+#include "morph.h"
+
+#define TEST_SEED          (24680u)
+#define TEST_RATE_HZ       (FILTER_SAMPLE_RATE_HZ)
+#define TEST_BLOCK         (4u)           // samples per DC tracker update, as app.c
+#define TEST_DC_TAU_MS     (1000u)
+#define TEST_SHAPE_TAU_MS  (4000u)
+#define TEST_MIN_AMPLITUDE (32)
+#define TEST_SECONDS       (60u)
+#define TEST_SETTLE_S      (10u)          // beats before this are not checked
+
+// IR counts: baseline, pulse and breathing swing, noise
+#define TEST_IR_BASE       (200000.0)
+#define TEST_IR_PULSE      (2000.0)
+#define TEST_IR_BREATH     (100.0)
+#define TEST_IR_NOISE      (4u)
+
+// Beat model, times from the beat start in s
+#define TEST_SYS_AT        (0.20)
+#define TEST_SYS_SIGMA     (0.075)
+#define TEST_DIA_AT        (0.50)
+#define TEST_DIA_SIGMA     (0.11)
+#define TEST_DIA_HEIGHT    (0.60)
+
+// Limits on the error of each beat, RI is truncated to whole %
+#define TEST_RISE_MS       (15)
+#define TEST_WIDTH_MS      (15)
+#define TEST_RI_PCT        (8)
+
+// Rates at which the model's diastolic wave rides on the systolic decay.
+// Much slower or faster, the fixed reflection time leaves it on its own
+// mid-beat, where beat.c can take it for a beat.
+static const uint16_t test_bpm[] = { 50u, 55u, 60u, 65u, 70u };
+
+// True features of one heart rate
+typedef struct
+{
+	double rise_ms;
+	double width_ms;
+	double ri_pct;
+	double depth_pct;        // diastolic peak over the notch
+} test_truth_t;
+
+
+/*******************************************************************************
+ * Function:        static int32_t test_random(uint32_t *seed, uint32_t range)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Generator state and range
+ *
+ * Output:          Uniform value in -range..range
+ *
+ * Side Effects:    None
+ *
+ * Overview:        xorshift32, so runs repeat on every host.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int32_t test_random(uint32_t *seed, uint32_t range)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return (int32_t)(*seed % ((2u * range) + 1u)) - (int32_t)range;
+} // test_random()
+
+
+/*******************************************************************************
+ * Function:        static double test_ppg(double t, double period)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Time and beat period in s
+ *
+ * Output:          Blood volume, 1 at a lone systolic peak
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The waves of this beat and its neighbours, which overlap
+ *                  at high rates.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static double test_ppg(double t, double period)
+{
+	double phase = fmod(t, period);
+	double sum = 0.0;
+
+	for (int k = -2; k <= 1; k++)
+	{
+		double s = (phase - (k * period) - TEST_SYS_AT) / TEST_SYS_SIGMA;
+		double d = (phase - (k * period) - TEST_DIA_AT) / TEST_DIA_SIGMA;
+
+		sum += exp(-0.5 * s * s) + (TEST_DIA_HEIGHT * exp(-0.5 * d * d));
+	}
+	return sum;
+} // test_ppg()
+
+
+/*******************************************************************************
+ * Function:        static test_truth_t test_truth(double period)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Beat period in s
+ *
+ * Output:          True features
+ *
+ * Side Effects:    None
+ *
+ * Overview:        One beat at 1 ms steps, from the foot before the systolic
+ *                  upstroke to the next.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static test_truth_t test_truth(double period)
+{
+	const double step = 0.001;
+	double t0 = period;                       // a beat away from the start
+	double peak_t = t0 + TEST_SYS_AT;
+	test_truth_t truth;
+
+	// Steepest point of the upstroke, then down to the foot before it
+	double steep_t = t0, slope = 0.0;
+	for (double t = peak_t - 0.3; t < peak_t; t += step)
+	{
+		double d = (test_ppg(t + step, period) - test_ppg(t, period)) / step;
+
+		if (d > slope)
+		{
+			slope = d;
+			steep_t = t;
+		}
+	}
+	double foot_t = steep_t;
+	while (test_ppg(foot_t - step, period) < test_ppg(foot_t, period))
+	{
+		foot_t -= step;
+	}
+
+	double foot = test_ppg(foot_t, period);
+	while (test_ppg(peak_t + step, period) > test_ppg(peak_t, period))
+	{
+		peak_t += step;
+	}
+	while (test_ppg(peak_t - step, period) > test_ppg(peak_t, period))
+	{
+		peak_t -= step;
+	}
+	double amplitude = test_ppg(peak_t, period) - foot;
+	double tangent_t = steep_t + (step / 2.0) -
+		((test_ppg(steep_t, period) + test_ppg(steep_t + step, period)) / 2.0 - foot) / slope;
+	truth.rise_ms = 1000.0 * (peak_t - tangent_t);
+
+	double up_t = foot_t, down_t = peak_t;
+	while (test_ppg(up_t, period) < (foot + (amplitude / 2.0)))
+	{
+		up_t += step;
+	}
+	while (test_ppg(down_t, period) >= (foot + (amplitude / 2.0)))
+	{
+		down_t += step;
+	}
+	truth.width_ms = 1000.0 * (down_t - up_t);
+
+	// Notch, then the diastolic peak, before the next foot
+	double t = peak_t;
+	while (test_ppg(t + step, period) <= test_ppg(t, period))
+	{
+		t += step;
+	}
+	double notch = test_ppg(t, period);
+	while (test_ppg(t + step, period) > test_ppg(t, period))
+	{
+		t += step;
+	}
+	truth.ri_pct = 100.0 * (test_ppg(t, period) - foot) / amplitude;
+	truth.depth_pct = 100.0 * (test_ppg(t, period) - notch) / amplitude;
+	return truth;
+} // test_truth()
+
+
+/*******************************************************************************
+ * Function:        static int test_rate(uint16_t bpm, uint32_t *seed)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Heart rate and generator state
+ *
+ * Output:          Non-zero if a limit was broken
+ *
+ * Side Effects:    None
+ *
+ * Overview:        Runs TEST_SECONDS of the PPG through the chain and
+ *                  compares every reported beat after TEST_SETTLE_S.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static int test_rate(uint16_t bpm, uint32_t *seed)
+{
+	static morph_state_t morph;
+	beat_state_t beat;
+	dc_track_t dc, dc_shape;
+	filter_bandpass_t bandpass;
+	filter_fir_t fir;
+	int32_t block[TEST_BLOCK];
+
+	double period = 60.0 / bpm;
+	test_truth_t truth = test_truth(period);
+	double worst_rise = 0.0, worst_width = 0.0, worst_ri = 0.0;
+	double sum_rise = 0.0, sum_width = 0.0, sum_ri = 0.0;
+	uint32_t beats = 0, notches = 0;
+
+	dc_track_init(&dc, TEST_RATE_HZ, TEST_DC_TAU_MS);
+	dc_track_init(&dc_shape, TEST_RATE_HZ, TEST_SHAPE_TAU_MS);
+	filter_bandpass_init(&bandpass);
+	filter_fir_init(&fir);
+	beat_init(&beat, TEST_RATE_HZ, TEST_MIN_AMPLITUDE);
+	morph_init(&morph, TEST_RATE_HZ, FILTER_FIR_DELAY);
+
+	for (uint32_t n = 0; n < (TEST_SECONDS * TEST_RATE_HZ); n += TEST_BLOCK)
+	{
+		for (uint32_t i = 0; i < TEST_BLOCK; i++)
+		{
+			double t = (double)(n + i) / TEST_RATE_HZ;
+
+			// IR falls as the blood volume rises
+			block[i] = (int32_t)lround(TEST_IR_BASE + (TEST_IR_BREATH * sin(2.0 * M_PI * 0.25 * t)) -
+				(TEST_IR_PULSE * test_ppg(t, period))) + test_random(seed, TEST_IR_NOISE);
+		}
+		dc_track_block(&dc, block, TEST_BLOCK);
+		dc_track_block(&dc_shape, block, TEST_BLOCK);
+
+		int32_t ir_dc = dc_track_value(&dc);
+		int32_t shape_dc = dc_track_value(&dc_shape);
+		for (uint32_t i = 0; i < TEST_BLOCK; i++)
+		{
+			int16_t x = filter_bandpass(&bandpass, fixmath_sat16(ir_dc - block[i]));
+			int16_t shape = filter_fir(&fir, fixmath_sat16(shape_dc - block[i]));
+			beat_event_t event;
+
+			if (morph_push(&morph, shape, block[i]) &&
+				((n + i) >= (TEST_SETTLE_S * TEST_RATE_HZ)))
+			{
+				double rise = morph.last.rise_ms - truth.rise_ms;
+				double width = morph.last.width_ms - truth.width_ms;
+				double ri = morph.last.ri_pct - truth.ri_pct;
+
+				beats++;
+				sum_rise += rise;
+				sum_width += width;
+				if (fabs(rise) > fabs(worst_rise)) worst_rise = rise;
+				if (fabs(width) > fabs(worst_width)) worst_width = width;
+				if (morph.last.notch)
+				{
+					notches++;
+					sum_ri += ri;
+					if (fabs(ri) > fabs(worst_ri)) worst_ri = ri;
+				}
+			}
+			if (beat_push(&beat, x, &event))
+			{
+				morph_beat(&morph, &event);
+			}
+		}
+	}
+
+	printf("%4u  %6.1f %+6.1f %+6.1f  %6.1f %+6.1f %+6.1f  %5.1f %+6.1f %+6.1f  %3u/%u\n", bpm,
+		truth.rise_ms, beats ? (sum_rise / beats) : 0.0, worst_rise,
+		truth.width_ms, beats ? (sum_width / beats) : 0.0, worst_width,
+		truth.ri_pct, notches ? (sum_ri / notches) : 0.0, worst_ri,
+		(unsigned)notches, (unsigned)beats);
+
+	// Twice the notch hysteresis, smoothing takes some of the depth
+	bool clear = truth.depth_pct > (200.0 / (1u << MORPH_NOTCH_SHIFT));
+	uint32_t expected = ((TEST_SECONDS - TEST_SETTLE_S) * bpm) / 60u;
+
+	return (beats + 2u < expected) || (beats > expected + 2u) || (clear && (notches != beats)) ||
+		(fabs(worst_rise) > TEST_RISE_MS) || (fabs(worst_width) > TEST_WIDTH_MS) || (fabs(worst_ri) > TEST_RI_PCT);
+} // test_rate()
+
+
+int main(void)
+{
+	uint32_t seed = TEST_SEED;
+	int failed = 0;
+
+	printf(" bpm  rise ms: true   mean  worst  width ms: true mean  worst  RI %%: true  mean  worst  notches\n");
+	for (uint8_t r = 0; r < (sizeof(test_bpm) / sizeof(test_bpm[0])); r++)
+	{
+		failed |= test_rate(test_bpm[r], &seed);
+	}
+	return failed;
+}
@@ -0,0 +1,363 @@
+/*
+ * Test vectors for the SpO2 engine (ADC/spo2.c) and its calibration curves
+ * (ADC/spo2_cal.c), run on the host.
+ *
+ * Beats: red and IR beats with a known ratio of ratios R, over a range of
+ * DC levels, pulse amplitudes and heart rates, go through spo2_push() and
+ * spo2_beat(). R is checked against a double precision R of the same
+ * integer samples. SpO2 is checked against the curve equation in spo2_cal.h
+ * sampled at every R = 1/8 and interpolated linearly, which is what the
+ * tables hold. The equation itself is printed too: between the knots the
+ * tables depart from it by up to 0.5 % at the knee of the linear curve.
+ *
+ * Edge cases: the first beat is only opened, a flat or too long beat and
+ * R above 2.0 give no reading, and the custom curve can only be selected
+ * once loaded with valid points.
+ *
+ * Prints each beat vector and exits non-zero on any mismatch.
+ *
+ * Only the C library is used, so it builds wherever gcc does:
+ *
+ *     gcc -std=gnu99 -Wall -Wextra -O2 -IADC/ADC -o test_spo2 \
+ *         ADC/tools/test_spo2.c ADC/ADC/spo2.c ADC/ADC/spo2_cal.c -lm
+ *     ./test_spo2
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "spo2.h"
+#include "spo2_cal.h"
+
+#define TEST_RATE_HZ       (100u)
+
+// R error in Q15 and SpO2 error in 0.1 %: the tables hold whole 0.1 %
+// points and the interpolation rounds down
+#define TEST_RATIO_TOL     (1.0)
+#define TEST_SPO2_TOL      (1.0)
+
+typedef struct
+{
+	double ratio;            // R of the generated beat
+	int32_t dc_red;
+	int32_t dc_ir;
+	int32_t ac_ir;           // IR pulse amplitude, red follows from R
+	uint16_t bpm;
+} test_beat_t;
+
+static const test_beat_t test_beats[] =
+{
+	{ 0.40, 30000, 32000, 600, 60 },
+	{ 0.50, 30000, 32000, 600, 60 },
+	{ 0.60, 12000, 40000, 300, 75 },
+	{ 0.70, 45000, 20000, 1200, 90 },
+	{ 0.80, 30000, 32000, 64, 120 },
+	{ 1.00, 30000, 32000, 600, 45 },
+	{ 1.25, 20000, 25000, 2000, 150 },
+	{ 1.50, 30000, 32000, 150, 180 },
+	{ 1.75, 8000, 50000, 900, 40 },
+	{ 2.00, 30000, 32000, 600, 60 }
+};
+
+#define TEST_BEATS         (sizeof(test_beats) / sizeof(test_beats[0]))
+
+static int test_failed = 0;
+
+
+/*******************************************************************************
+ * Function:        static double test_curve(spo2_cal_curve_t curve, double ratio)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Curve and R
+ *
+ * Output:          SpO2 in 0.1 % from the curve's equation
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The equations spo2_cal.c tabulates, with its clipping.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static double test_curve(spo2_cal_curve_t curve, double ratio)
+{
+	double spo2;
+
+	if (ratio > 2.0)
+	{
+		ratio = 2.0;
+	}
+	if (curve == SPO2_CAL_QUADRATIC)
+	{
+		spo2 = (-45.06 * ratio * ratio) + (30.354 * ratio) + 94.845;
+	}
+	else
+	{
+		spo2 = 110.0 - (25.0 * ratio);
+	}
+	spo2 = (spo2 > 100.0) ? 100.0 : ((spo2 < 0.0) ? 0.0 : spo2);
+	return spo2 * 10.0;
+} // test_curve()
+
+
+/*******************************************************************************
+ * Function:        static double test_table(spo2_cal_curve_t curve, double ratio)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Curve and R
+ *
+ * Output:          SpO2 in 0.1 % the table should give
+ *
+ * Side Effects:    None
+ *
+ * Overview:        The equation at the knots either side of R, rounded to
+ *                  0.1 % as spo2_cal.c stores them, and interpolated.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static double test_table(spo2_cal_curve_t curve, double ratio)
+{
+	double step = 1.0 / (1u << (15u - SPO2_CAL_SHIFT));
+	double knot = floor(ratio / step);
+
+	if (knot >= SPO2_CAL_SEGMENTS)
+	{
+		return round(test_curve(curve, 2.0));
+	}
+
+	double a = round(test_curve(curve, knot * step));
+	double b = round(test_curve(curve, (knot + 1.0) * step));
+	return a + ((b - a) * ((ratio / step) - knot));
+} // test_table()
+
+
+/*******************************************************************************
+ * Function:        static void test_check(bool ok, const char *what)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Result and description
+ *
+ * Output:          None
+ *
+ * Side Effects:    Notes a failure
+ *
+ * Overview:
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAIL: %s\n", what);
+		test_failed = 1;
+	}
+} // test_check()
+
+
+/*******************************************************************************
+ * Function:        static bool test_run_beat(spo2_state_t *state,
+ *                                            const test_beat_t *beat,
+ *                                            double *ratio)
+ *
+ * PreCondition:    spo2_beat() has opened a beat
+ *
+ * Input:           SpO2 state, beat and where to put the reference R
+ *
+ * Output:          What spo2_beat() returned at the end of the beat
+ *
+ * Side Effects:    None
+ *
+ * Overview:        A raised cosine pulse on each DC level, rounded to
+ *                  integer samples as the pulse stage gives them. The
+ *                  reference R is taken from those same samples.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static bool test_run_beat(spo2_state_t *state, const test_beat_t *beat, double *ratio)
+{
+	uint16_t samples = (uint16_t)((60u * TEST_RATE_HZ) / beat->bpm);
+	double ac_red = beat->ratio * beat->ac_ir * beat->dc_red / beat->dc_ir;
+	int32_t min_red = INT32_MAX, max_red = INT32_MIN, min_ir = INT32_MAX, max_ir = INT32_MIN;
+	double sum_red = 0.0, sum_ir = 0.0;
+
+	for (uint16_t i = 0; i < samples; i++)
+	{
+		double pulse = 0.5 - (0.5 * cos(2.0 * M_PI * i / samples));
+		int32_t red = beat->dc_red - (int32_t)lround(ac_red * pulse);
+		int32_t ir = beat->dc_ir - (int32_t)lround(beat->ac_ir * pulse);
+
+		spo2_push(state, red, ir);
+		sum_red += red;
+		sum_ir += ir;
+		if (red < min_red) min_red = red;
+		if (red > max_red) max_red = red;
+		if (ir < min_ir) min_ir = ir;
+		if (ir > max_ir) max_ir = ir;
+	}
+
+	*ratio = ((double)(max_red - min_red) / sum_red) / ((double)(max_ir - min_ir) / sum_ir);
+	return spo2_beat(state);
+} // test_run_beat()
+
+
+/*******************************************************************************
+ * Function:        static void test_beats_curve(spo2_cal_curve_t curve)
+ *
+ * PreCondition:    None
+ *
+ * Input:           Curve to check
+ *
+ * Output:          None
+ *
+ * Side Effects:    Selects the curve
+ *
+ * Overview:        Runs every beat vector through the engine with the curve
+ *                  selected.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_beats_curve(spo2_cal_curve_t curve)
+{
+	spo2_state_t state;
+
+	spo2_cal_select(curve);
+	spo2_init(&state, TEST_RATE_HZ);
+	test_check(!spo2_beat(&state), "first beat gives a reading");
+
+	printf("curve %d\n     R  dc_red  dc_ir  ac_ir  bpm   R ref (Q15)  R got  equation  SpO2 ref  SpO2 got\n", (int)curve);
+	for (uint8_t b = 0; b < TEST_BEATS; b++)
+	{
+		const test_beat_t *beat = &test_beats[b];
+		double ratio;
+		bool reading = test_run_beat(&state, beat, &ratio);
+		double ratio_q15 = ratio * 32768.0;
+		double spo2 = test_table(curve, ratio);
+
+		printf("  %4.2f  %6d  %5d  %5d  %3u  %12.1f", beat->ratio,
+			(int)beat->dc_red, (int)beat->dc_ir, (int)beat->ac_ir, beat->bpm, ratio_q15);
+		if (ratio_q15 > (double)SPO2_RATIO_MAX)
+		{
+			printf("  no reading\n");
+			test_check(!reading, "R above 2.0 gives a reading");
+			continue;
+		}
+		printf("  %5u  %8.1f  %8.1f  %8u\n", (unsigned)state.ratio, test_curve(curve, ratio),
+			spo2, (unsigned)state.spo2);
+
+		test_check(reading, "beat gives no reading");
+		test_check(fabs(state.ratio - ratio_q15) <= TEST_RATIO_TOL, "R out of tolerance");
+		test_check(fabs(state.spo2 - spo2) <= TEST_SPO2_TOL, "SpO2 out of tolerance");
+		test_check(state.beat_samples == (60u * TEST_RATE_HZ) / beat->bpm, "beat length");
+	}
+} // test_beats_curve()
+
+
+/*******************************************************************************
+ * Function:        static void test_edges(void)
+ *
+ * PreCondition:    None
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    Selects the linear curve
+ *
+ * Overview:        Beats that must not give a reading.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_edges(void)
+{
+	spo2_state_t state;
+	test_beat_t slow = { 0.5, 30000, 32000, 600, SPO2_BPM_MIN - 1u };
+	double ratio;
+
+	spo2_cal_select(SPO2_CAL_LINEAR);
+	spo2_init(&state, TEST_RATE_HZ);
+	spo2_beat(&state);
+
+	for (uint16_t i = 0; i < 50u; i++)
+	{
+		spo2_push(&state, 30000, 32000);
+	}
+	test_check(!spo2_beat(&state), "flat beat gives a reading");
+
+	test_check(!test_run_beat(&state, &slow, &ratio), "beat longer than SPO2_BPM_MIN gives a reading");
+	test_check(test_run_beat(&state, &test_beats[1], &ratio), "no reading after a long beat");
+
+	for (uint16_t i = 0; i < 50u; i++)
+	{
+		spo2_push(&state, -100, -100 - (int32_t)i);
+	}
+	test_check(!spo2_beat(&state), "negative DC gives a reading");
+} // test_edges()
+
+
+/*******************************************************************************
+ * Function:        static void test_custom(void)
+ *
+ * PreCondition:    The custom curve has not been loaded
+ *
+ * Input:           None
+ *
+ * Output:          None
+ *
+ * Side Effects:    Leaves the custom curve selected
+ *
+ * Overview:        The custom curve is refused until loaded, a point above
+ *                  SPO2_CAL_MAX is refused, and a loaded curve is hit
+ *                  exactly at its points and halfway between them.
+ *
+ * Note:
+ *
+ ******************************************************************************/
+static void test_custom(void)
+{
+	uint16_t points[SPO2_CAL_POINTS];
+
+	spo2_cal_select(SPO2_CAL_LINEAR);
+	spo2_cal_select(SPO2_CAL_CUSTOM);
+	test_check(spo2_cal_selected() == SPO2_CAL_LINEAR, "custom curve selected before loading");
+
+	for (uint8_t i = 0; i < SPO2_CAL_POINTS; i++)
+	{
+		points[i] = (uint16_t)(1000u - (40u * i));
+	}
+	points[3] = SPO2_CAL_MAX + 1u;
+	test_check(!spo2_cal_set_custom(points), "point above SPO2_CAL_MAX accepted");
+	points[3] = 1000u - (40u * 3u);
+	test_check(spo2_cal_set_custom(points), "valid custom curve refused");
+
+	spo2_cal_select(SPO2_CAL_CUSTOM);
+	test_check(spo2_cal_selected() == SPO2_CAL_CUSTOM, "custom curve not selected");
+	for (uint8_t i = 0; i < SPO2_CAL_SEGMENTS; i++)
+	{
+		uint32_t ratio = (uint32_t)i << SPO2_CAL_SHIFT;
+
+		test_check(spo2_cal_lookup(ratio) == points[i], "custom curve point");
+		test_check(spo2_cal_lookup(ratio + (1u << (SPO2_CAL_SHIFT - 1u))) == (points[i] - 20u),
+			"custom curve midpoint");
+	}
+	test_check(spo2_cal_lookup(SPO2_RATIO_MAX * 2u) == points[SPO2_CAL_SEGMENTS], "custom curve clamp");
+} // test_custom()
+
+
+int main(void)
+{
+	test_custom();
+	test_beats_curve(SPO2_CAL_LINEAR);
+	test_beats_curve(SPO2_CAL_QUADRATIC);
+	test_edges();
+
+	printf(test_failed ? "FAILED\n" : "passed\n");
+	return test_failed;
+}